@@ -0,0 +1,354 @@
+// Offline AppCore benchmark: feeds synthetic (or recorded) CV_8UC3 frames straight into
+// AppCore::processFrame for every effect in EXTEND and REPEAT panel modes plus the
+// multi-panel mix, and reports ns/frame, cv::Mat allocations/frame and throughput.
+// A second pass times Filled Silhouette (segmentation + contours, trivial drawing) with
+// every background model backend, to compare their cost.
+// No camera, LED matrix or sudo required, so it runs on a laptop or in CI.
+//
+// Output is JSON in the shape of benchmarks/baseline.json (avg_fps per effect), with the
+// extra per-effect fields ns_per_frame, p95_ns and allocs_per_frame.
+
+#include "app/app_core.h"
+#include "app/frame_alloc_tracker.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* effect_names[] = {
+    "Debug (Pass-through)",
+    "Filled Silhouette",
+    "Outline Only",
+    "Motion Trails",
+    "Rainbow Motion Trails",
+    "Double Exposure",
+    "Procedural Shapes",
+    "Wave Patterns",
+    "Geometric Abstraction"
+};
+
+struct BenchConfig {
+    int width = 576;
+    int height = 192;
+    int panels = 3;
+    int frames = 300;
+    int warmup = 30;
+    int process_width = 0;
+    int process_height = 0;
+    BackgroundModel::Type bg_model = BackgroundModel::Type::MOG2;
+    int segment_every = 1;
+    std::string input_path;
+    std::string output_path;
+};
+
+struct BenchResult {
+    int effect_id = 0;
+    double ns_per_frame = 0.0;
+    double p95_ns = 0.0;
+    double allocs_per_frame = 0.0;
+    double fps = 0.0;
+};
+
+// A static textured background with a figure walking across it, plus a little sensor
+// noise, so background subtraction sees motion the way it does with a person in view
+std::vector<cv::Mat> makeSyntheticFrames(int width, int height, int count) {
+    cv::Mat background(height, width, CV_8UC3);
+    for (int y = 0; y < height; y++) {
+        cv::Vec3b* row = background.ptr<cv::Vec3b>(y);
+        for (int x = 0; x < width; x++) {
+            row[x] = cv::Vec3b(static_cast<uchar>(40 + (x * 80) / width),
+                               static_cast<uchar>(60 + (y * 60) / height),
+                               static_cast<uchar>(((x / 16 + y / 16) & 1) ? 90 : 70));
+        }
+    }
+
+    cv::RNG rng(12345);
+    std::vector<cv::Mat> frames;
+    frames.reserve(count);
+    for (int i = 0; i < count; i++) {
+        cv::Mat frame = background.clone();
+        cv::Mat noise(height, width, CV_8UC3);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 8);
+        frame += noise;
+
+        double phase = static_cast<double>(i) / count;
+        int cx = static_cast<int>(width * (0.15 + 0.7 * phase));
+        int cy = height / 2;
+        int body_h = std::max(8, height / 3);
+        int body_w = std::max(4, body_h / 3);
+        cv::ellipse(frame, cv::Point(cx, cy + body_h / 4), cv::Size(body_w, body_h),
+                    0, 0, 360, cv::Scalar(200, 170, 150), cv::FILLED);
+        cv::circle(frame, cv::Point(cx, cy - body_h + body_h / 4), std::max(3, body_w * 2 / 3),
+                   cv::Scalar(180, 190, 220), cv::FILLED);
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+// Decode a clip up front so decoding is not part of the measurement
+std::vector<cv::Mat> loadRecordedFrames(const std::string& path, int width, int height, int max_frames) {
+    std::vector<cv::Mat> frames;
+    cv::VideoCapture capture(path);
+    if (!capture.isOpened()) {
+        std::cerr << "Error: Could not open " << path << std::endl;
+        return frames;
+    }
+    cv::Mat frame;
+    while (static_cast<int>(frames.size()) < max_frames && capture.read(frame)) {
+        cv::Mat resized;
+        cv::resize(frame, resized, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+        frames.push_back(resized);
+    }
+    return frames;
+}
+
+void configureCore(AppCore& core, const BenchConfig& config) {
+    if (config.process_width > 0 && config.process_height > 0) {
+        core.setProcessingSize(config.process_width, config.process_height);
+    }
+    core.setBackgroundModel(config.bg_model);
+    core.setSegmentationRate(config.segment_every);
+}
+
+// Warm up (buffers, MOG2 model, effect state), then time each processFrame call
+BenchResult measure(AppCore& core, const std::vector<cv::Mat>& frames, const BenchConfig& config) {
+    cv::Mat out;
+    size_t next = 0;
+    for (int i = 0; i < config.warmup; i++) {
+        core.processFrame(frames[next], out);
+        next = (next + 1) % frames.size();
+    }
+
+    std::vector<int64_t> samples;
+    samples.reserve(config.frames);
+    uint64_t allocs_before = FrameAllocTracker::instance().getAllocationCount();
+    for (int i = 0; i < config.frames; i++) {
+        auto start = std::chrono::steady_clock::now();
+        core.processFrame(frames[next], out);
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        next = (next + 1) % frames.size();
+    }
+    uint64_t allocations = FrameAllocTracker::instance().getAllocationCount() - allocs_before;
+
+    BenchResult result;
+    int64_t total = 0;
+    for (int64_t sample : samples) total += sample;
+    result.ns_per_frame = static_cast<double>(total) / samples.size();
+    std::sort(samples.begin(), samples.end());
+    result.p95_ns = static_cast<double>(samples[(samples.size() * 95) / 100]);
+    result.allocs_per_frame = static_cast<double>(allocations) / samples.size();
+    result.fps = result.ns_per_frame > 0.0 ? 1e9 / result.ns_per_frame : 0.0;
+    return result;
+}
+
+std::vector<BenchResult> benchPanelMode(PanelMode mode, const std::vector<cv::Mat>& frames,
+                                        const BenchConfig& config) {
+    std::vector<BenchResult> results;
+    for (int effect_id = 1; effect_id <= 9; effect_id++) {
+        // Fresh core per effect so no state (background model, trails) leaks between runs
+        AppCore core(config.width, config.height, config.panels);
+        configureCore(core, config);
+        core.setPanelMode(mode);
+        Effect effect = static_cast<Effect>(effect_id);
+        // Same as selecting the effect from the keyboard
+        core.setSystemMode(core.getAppropriateModeForEffect(effect));
+        core.setEffect(effect);
+
+        BenchResult result = measure(core, frames, config);
+        result.effect_id = effect_id;
+        results.push_back(result);
+
+        std::cerr << (mode == PanelMode::EXTEND ? "extend " : "repeat ") << effect_id << " "
+                  << effect_names[effect_id - 1] << ": " << static_cast<int64_t>(result.ns_per_frame)
+                  << " ns/frame, " << result.allocs_per_frame << " allocs/frame" << std::endl;
+    }
+    return results;
+}
+
+BenchResult benchMultiPanel(const std::vector<cv::Mat>& frames, const BenchConfig& config) {
+    AppCore core(config.width, config.height, config.panels);
+    configureCore(core, config);
+    core.setMultiPanelEnabled(true);
+    BenchResult result = measure(core, frames, config);
+    std::cerr << "multi-panel: " << static_cast<int64_t>(result.ns_per_frame) << " ns/frame, "
+              << result.allocs_per_frame << " allocs/frame" << std::endl;
+    return result;
+}
+
+struct BackgroundResult {
+    BackgroundModel::Type type;
+    BenchResult result;
+};
+
+std::vector<BackgroundResult> benchBackgroundModels(const std::vector<cv::Mat>& frames,
+                                                    const BenchConfig& config) {
+    const BackgroundModel::Type types[] = {
+        BackgroundModel::Type::MOG2,
+        BackgroundModel::Type::MOG2_FAST,
+        BackgroundModel::Type::RUNNING_AVERAGE,
+        BackgroundModel::Type::FRAME_DIFF
+    };
+    std::vector<BackgroundResult> results;
+    for (BackgroundModel::Type type : types) {
+        BenchConfig model_config = config;
+        model_config.bg_model = type;
+        AppCore core(config.width, config.height, 1);
+        configureCore(core, model_config);
+        core.setSystemMode(SystemMode::ACTIVE);
+        core.setEffect(Effect::FILLED_SILHOUETTE);
+
+        BackgroundResult entry{type, measure(core, frames, config)};
+        results.push_back(entry);
+        std::cerr << "bg-model " << BackgroundModel::getTypeName(type) << ": "
+                  << static_cast<int64_t>(entry.result.ns_per_frame) << " ns/frame" << std::endl;
+    }
+    return results;
+}
+
+void writeResults(std::ostream& out, const char* name, const std::vector<BenchResult>& results) {
+    out << "    \"" << name << "\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << (i ? "," : "")
+            << "{\"effect_id\":" << r.effect_id
+            << ",\"effect_name\":\"" << effect_names[r.effect_id - 1] << "\""
+            << ",\"avg_fps\":" << static_cast<int>(r.fps + 0.5)
+            << ",\"ns_per_frame\":" << static_cast<int64_t>(r.ns_per_frame)
+            << ",\"p95_ns\":" << static_cast<int64_t>(r.p95_ns)
+            << ",\"allocs_per_frame\":" << r.allocs_per_frame << "}";
+    }
+    out << "],\n";
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "Options:\n"
+              << "  --width WIDTH          Input frame width (default: 576)\n"
+              << "  --height HEIGHT        Input frame height (default: 192)\n"
+              << "  --panels N             Number of panels (default: 3)\n"
+              << "  --frames N             Measured frames per effect (default: 300)\n"
+              << "  --warmup N             Unmeasured frames before each effect (default: 30)\n"
+              << "  --process-size WxH     AppCore processing resolution (default: input resolution)\n"
+              << "  --bg-model MODEL       Background model for the effect runs: mog2, mog2-fast, average, diff (default: mog2)\n"
+              << "  --segment-every N      Segment every Nth frame and reuse the silhouette in between (default: 1)\n"
+              << "  --input VIDEO          Use frames from a recorded clip instead of synthetic ones\n"
+              << "  --output FILE          Write JSON results to FILE (default: stdout)\n"
+              << "  --help                 Show this help message\n"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            config.width = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            config.height = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--panels") == 0 && i + 1 < argc) {
+            config.panels = std::max(1, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            config.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            config.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--process-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &config.process_width, &config.process_height) != 2) {
+                std::cerr << "Invalid --process-size: " << argv[i] << " (expected WxH)" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--bg-model") == 0 && i + 1 < argc) {
+            if (!BackgroundModel::parseType(argv[++i], config.bg_model)) {
+                std::cerr << "Unknown background model: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--segment-every") == 0 && i + 1 < argc) {
+            config.segment_every = std::max(1, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--input") == 0 && i + 1 < argc) {
+            config.input_path = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            config.output_path = argv[++i];
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<cv::Mat> frames;
+    if (!config.input_path.empty()) {
+        frames = loadRecordedFrames(config.input_path, config.width, config.height, 600);
+        if (frames.empty()) return 1;
+    } else {
+        frames = makeSyntheticFrames(config.width, config.height, 120);
+    }
+
+    // Count allocations for every core (AppCore's own per-frame log stays off)
+    FrameAllocTracker::instance().install();
+
+    std::vector<BenchResult> extend = benchPanelMode(PanelMode::EXTEND, frames, config);
+    std::vector<BenchResult> repeat = benchPanelMode(PanelMode::REPEAT, frames, config);
+    BenchResult multi_panel = benchMultiPanel(frames, config);
+    std::vector<BackgroundResult> bg_models = benchBackgroundModels(frames, config);
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"benchmark_info\": {\n"
+         << "    \"type\": \"offline\",\n"
+         << "    \"source\": \"" << (config.input_path.empty() ? "synthetic" : "recorded") << "\",\n"
+         << "    \"width\": " << config.width << ",\n"
+         << "    \"height\": " << config.height << ",\n"
+         << "    \"led_chain\": " << config.panels << ",\n"
+         << "    \"frames_per_effect\": " << config.frames << ",\n"
+         << "    \"bg_model\": \"" << BackgroundModel::getTypeName(config.bg_model) << "\",\n"
+         << "    \"segment_every\": " << config.segment_every << "\n"
+         << "  },\n"
+         << "  \"results\": {\n";
+    writeResults(json, "extend", extend);
+    writeResults(json, "repeat", repeat);
+    json << "    \"multi_panel_fps\": " << static_cast<int>(multi_panel.fps + 0.5) << ",\n"
+         << "    \"multi_panel_ns_per_frame\": " << static_cast<int64_t>(multi_panel.ns_per_frame) << ",\n"
+         << "    \"background_models\": [";
+    for (size_t i = 0; i < bg_models.size(); i++) {
+        const BenchResult& r = bg_models[i].result;
+        json << (i ? ",\n      " : "\n      ")
+             << "{\"model\":\"" << BackgroundModel::getTypeName(bg_models[i].type) << "\""
+             << ",\"avg_fps\":" << static_cast<int>(r.fps + 0.5)
+             << ",\"ns_per_frame\":" << static_cast<int64_t>(r.ns_per_frame)
+             << ",\"p95_ns\":" << static_cast<int64_t>(r.p95_ns) << "}";
+    }
+    json << "]\n"
+         << "  }\n"
+         << "}\n";
+
+    if (config.output_path.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(config.output_path);
+        if (!file) {
+            std::cerr << "Error: Could not write " << config.output_path << std::endl;
+            return 1;
+        }
+        file << json.str();
+        std::cerr << "Results written to " << config.output_path << std::endl;
+    }
+    return 0;
+}
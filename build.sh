@@ -48,6 +48,7 @@ echo "Build complete!"
 echo "Executables:"
 echo "  - build/camera_to_matrix    (direct libcamera capture)"
 echo "  - build/rpicam_to_matrix    (reads rpicam-vid output from stdin)"
+echo "  - build/matrix_receiver     (shows one tile sent by another node's --send-tiles)"
 echo ""
 echo "Run with:"
 echo "  sudo ./build/camera_to_matrix"
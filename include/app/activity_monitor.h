@@ -0,0 +1,38 @@
+#ifndef ACTIVITY_MONITOR_H
+#define ACTIVITY_MONITOR_H
+
+#include <opencv2/core.hpp>
+
+// Cheap scene-activity metric: frame differencing on a tiny downsampled luma image.
+// Costs one INTER_AREA resize to 32x24 plus ~800 pixel compares per frame, so it can run
+// on every probe frame while the expensive segmentation pipeline is idle.
+class ActivityMonitor {
+public:
+    static constexpr int PROBE_WIDTH = 32;
+    static constexpr int PROBE_HEIGHT = 24;
+
+    // pixel_threshold: luma change (0-255) for a probe pixel to count as changed
+    explicit ActivityMonitor(int pixel_threshold = 12);
+
+    // Fraction (0-1) of probe pixels that changed since the previous update().
+    // The first frame after construction/reset() returns 0.
+    // advance = false compares against the same reference next time (change since the
+    // last advancing update, so slow motion accumulates); keepLatestAsReference() then
+    // promotes the probe of that non-advancing update() to reference.
+    double update(const cv::Mat& frame_bgr, bool advance = true);
+    void keepLatestAsReference();
+    double getLastScore() const { return last_score_; }
+
+    void setPixelThreshold(int threshold) { pixel_threshold_ = threshold; }
+    void reset();
+
+private:
+    int pixel_threshold_;
+    double last_score_;
+    cv::Mat small_bgr_;
+    cv::Mat luma_;
+    cv::Mat prev_luma_;
+    cv::Mat diff_;
+};
+
+#endif // ACTIVITY_MONITOR_H
@@ -2,15 +2,30 @@
 #define APP_CORE_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 #include <memory>
 #include <opencv2/core.hpp>
 #include <opencv2/video/background_segm.hpp>
 
-// Include effect class headers
-#include "effects/ambient/procedural_shapes.h"
-#include "effects/ambient/wave_patterns.h"
+#include "app/activity_monitor.h"
+#include "app/background_model.h"
+#include "app/frame_history.h"
+#include "app/quality_governor.h"
+#include "app/segmentation_stage.h"
+#include "app/state_checkpoint.h"
+#include "app/transition_engine.h"
+#include "effects/active/double_exposure.h"
+#include "effects/effect.h"
+#include "effects/effect_registry.h"
 
 // System modes
 enum class SystemMode {
@@ -42,6 +57,8 @@ enum class PanelMode {
 class AppCore {
 public:
     explicit AppCore(int width, int height, int num_panels = 1);
+    // Writes a final state checkpoint when a state file is set
+    ~AppCore();
 
     // System mode controls
     void setSystemMode(SystemMode mode);
@@ -68,42 +85,158 @@ public:
     int getPanelEffect(int panel_index) const;
     int getNumPanels() const { return num_panels_; }
     
+    // Processing resolution: every frame is downscaled once (INTER_AREA) to this size
+    // before any effect runs, and output frames are produced at this size.
+    // 0x0 (default) processes at the input resolution.
+    void setProcessingSize(int width, int height);
+    cv::Size getProcessingSize() const { return cv::Size(processing_width_, processing_height_); }
+
+    // Debug: count cv::Mat allocations per processFrame() and log whenever the count changes.
+    // Steady state should only show OpenCV-internal allocations (findContours' padded copy).
+    void setAllocationCheck(bool enabled);
+    uint64_t getLastFrameAllocations() const { return last_frame_allocations_; }
+
+    // Double exposure history storage: BGR (default) or BGR565 (2/3 the memory, small
+    // colour loss in the ghost image). Changing it restarts the history.
+    void setHistoryFormat(FrameHistory::Format format);
+    FrameHistory::Format getHistoryFormat() const { return frame_history_.getFormat(); }
+
+    // Background subtraction backend behind every silhouette effect (default MOG2 with
+    // shadows). The cheaper backends trade detection quality for CPU; see BackgroundModel.
+    // Set before processing starts: it resets the learned background.
+    void setBackgroundModel(BackgroundModel::Type type);
+    BackgroundModel::Type getBackgroundModel() const { return background_model_type_; }
+
+    // Reduced-rate segmentation: run the background model and contours every interval
+    // frames, or earlier when more than change_threshold of a luma probe changed since
+    // (0 = only the interval), and reuse the cached silhouette in between. Effects still
+    // render every frame. Default 1 (every frame).
+    void setSegmentationRate(int interval, double change_threshold = 0.0);
+
+    // Warm startup: restore the learned background and effect state (trail buffers,
+    // animation clocks) from path if it holds a checkpoint, then rewrite it every
+    // interval_seconds and on destruction (StateCheckpoint). Periodic saves snapshot the
+    // state on the frame thread and write it on a background thread. The effect and mode
+    // selection are not part of it. Call before processing starts (after setBackgroundModel()).
+    void setStateFile(const std::string& path, double interval_seconds = 30.0);
+    // Write the checkpoint now (waits for a background save in progress); false without a
+    // state file or when writing failed
+    bool saveState();
+
+    // Adaptive quality (QualityGovernor): trade detail for speed at runtime to hold
+    // target_fps (AppCore processing time per frame) and/or stay below target_temp_c.
+    // temperature returns the CPU temperature (DebugDataCollector::getTemperature());
+    // without it only frame time counts. Levels step MOG2 update rate, contour
+    // simplification, history depth and processing resolution, logging "[GOVERNOR]".
+    void setQualityGovernor(double target_fps, float target_temp_c,
+                            std::function<float()> temperature = nullptr);
+    int getQualityLevel() const { return governor_.getLevel(); }
+
+    // Motion-activated mode switching. Every camera frame gets a cheap activity score
+    // (ActivityMonitor: fraction of a 32x24 luma probe that changed since the last frame).
+    // AMBIENT -> ACTIVE when the score reaches active_threshold on a few consecutive frames;
+    // ACTIVE -> AMBIENT once it has stayed below idle_threshold for the idle timeout.
+    // Each switch selects the new mode's default effect and logs "[AUTO-MODE]".
+    void setAutoModeSwitching(bool enabled);
+    bool isAutoModeSwitching() const { return auto_mode_enabled_; }
+    void setActivityThresholds(double active_threshold, double idle_threshold);
+    void setIdleTimeout(double seconds);
+    double getActivityScore() const { return activity_monitor_.getLastScore(); }
+    // Score a camera frame that is not going through processFrame() (idle-rendering probe)
+    void observeActivity(const cv::Mat& in_bgr);
+
+    // Effect switches (auto-cycling, keyboard, auto mode, REPEAT panel cycling) crossfade
+    // over this many frames by blending a snapshot of the last frame shown into the new
+    // effect's output; the old effect is not run again. 0 cuts. Default 30 (1s at 30fps).
+    void setTransitionDuration(int frames);
+    int getTransitionDuration() const { return transition_frames_; }
+
     // Auto-cycling controls
     void toggleAutoCycling();
     bool isAutoCycling() const { return auto_cycling_enabled_; }
 
     // Process an input frame into an output frame.
     // - in_bgr: CV_8UC3 BGR image (size can differ; core will adapt internal buffers)
-    // - out_bgr: written as CV_8UC3 BGR image, same size as in_bgr
+    // - out_bgr: written as CV_8UC3 BGR image, at the processing size (see setProcessingSize),
+    //            or the same size as in_bgr when no processing size is set
     void processFrame(const cv::Mat& in_bgr, cv::Mat& out_bgr);
 
+    // Idle rendering: true when any effect currently on screen reads the camera image.
+    // When false (ambient effects only), frames can be produced by renderFrame() on a
+    // timer and the camera only needs to run as a low-rate motion probe.
+    bool needsCameraInput() const;
+    // Produce one frame without camera input, at the processing size (or the last input size)
+    void renderFrame(cv::Mat& out_bgr);
+
     // Effect validation and processing (public for keyboard input)
     bool isEffectValidForMode(Effect effect, SystemMode mode) const;
     Effect getDefaultEffectForMode(SystemMode mode) const;
     SystemMode getAppropriateModeForEffect(Effect effect) const;
 
 private:
+    // Effect instances of one processing context (the full frame, or one panel), created
+    // from EffectRegistry on first use and kept, so an effect switched back to resumes
+    // its state (trails, animation) instead of starting over
+    struct EffectInstance {
+        std::unique_ptr<IEffect> effect;
+        cv::Size size;  // Size of the last prepare()
+    };
+    struct ProcessingContext {
+        std::map<int, EffectInstance> instances;  // By effect id
+        IEffect* current = nullptr;               // Effect rendering this frame
+        FrameContext frame{};                     // Its inputs for this frame
+        cv::Mat result;                           // Its output for this frame
+        TransitionEngine transition;              // Fade from the context's previous effect
+        std::string state_prefix;                 // Checkpoint key prefix ("frame/", "panel0/", ...)
+    };
+
     void ensureSize(int w, int h);
+    void allocateFrameBuffers();
+    void runFrame(const cv::Mat& in_frame, cv::Mat& out_bgr, bool camera_input);
+    void processFrameStages(const cv::Mat& in_frame, cv::Mat& out_bgr, bool camera_input);
+    void updateAutoMode(double score);
+    void updateGovernor(double process_ms);
+    void applyQualityLevel(int level);
+    // read_pixels = false only sizes the processing frame (no effect reads it)
+    const cv::Mat& downscaleInput(const cv::Mat& in_bgr, bool read_pixels);
+
+    // Detection parameters are tuned for input resolution; this rescales them to the
+    // processing resolution (kernel sizes: FrameContext::scaledKernelSize())
+    int scaledArea(int area) const;
 
-    void processPassThrough(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    void processFilledSilhouette(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    void processOutline(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    void processMotionTrails(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    void processRainbowTrails(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    void processDoubleExposure(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    void processGeometricAbstraction(const cv::Mat& in_bgr, cv::Mat& out_bgr);
+    // Checkpoint key prefix of the background model of segmentation stage "name"
+    std::string segmentationStatePrefix(const char* name) const;
+    // Copy the current warm state into checkpoint (deep copies, safe to write on any thread)
+    void collectState(StateCheckpoint& checkpoint) const;
+    // Periodic save: snapshot here, write/msync/rename on a background thread
+    void saveStateInBackground();
+
+    // Unknown effect ids render as DEBUG (pass-through)
+    static int resolveEffectId(int effect);
     void processMultiPanel(const cv::Mat& in_bgr, cv::Mat& out_bgr);
-    
-    // Procedural shapes helpers
-    cv::Scalar hsvToBgr(float h, float s, float v);
-    void drawMorphingShape(cv::Mat& img, int cx, int cy, int radius, 
-                          int shape_type, float morph_progress, cv::Scalar color,
-                          float fill_mode);
-    std::vector<cv::Point> getShapePoints(int shape_type, int cx, int cy, int radius);
-    
-    void processPanelRegion(const cv::Mat& in_region, cv::Mat& out_region, int effect, int panel_index);
     void ensurePanelResourcesInitialized();
-    
+    // Fills panel_effect_ids_ for this frame
+    void selectPanelEffects();
+    // Selects the context's instance of effect for input, a region (roi) of the frame
+    // segmentation and history were computed on. Returns true when that switched the
+    // context's effect (a transition should start). min_contour_area 0 uses the effect's own
+    // full-frame threshold (IEffect::minContourArea()).
+    bool prepareContext(ProcessingContext& context, int effect, const cv::Mat& input,
+                        SegmentationStage& segmentation, const FrameHistory& history,
+                        const cv::Rect& roi, int panel_index, int min_contour_area);
+    // Starts panel_index's transition from its region of the last frame shown
+    void beginPanelTransition(int panel_index, const cv::Size& frame_size);
+    // Serial step before the effects run (panels then run in parallel): computes what the
+    // contexts' inputs() need from the shared segmentation and pushes frame into history,
+    // the two concurrently when both are needed, so effects only read finished state
+    void runSharedStages(ProcessingContext* contexts, int count, FrameHistory& history,
+                         const cv::Mat& frame);
+    // History push on the persistent side thread (started on first use), so the frames
+    // that overlap it with segmentation do not create a thread each
+    void beginHistoryPush(FrameHistory& history, const cv::Mat& frame);
+    void finishHistoryPush();
+    void historyWorkerLoop();
+
     // Auto mode cycling (internal)
     void updateAutoCycling();
     int getRandomCycleInterval();
@@ -128,56 +261,86 @@ private:
     int height_;
     int num_panels_;
 
-    cv::Ptr<cv::BackgroundSubtractor> background_subtractor_;
-    cv::Mat silhouette_frame_; // persistent buffer for trails/energy
-    cv::Mat trail_age_buffer_;  // Float buffer tracking age of each trail pixel (for rainbow)
-    float trail_alpha_ = 0.7f;
-    float energy_decay_ = 0.97f;
-    
-    // Double exposure buffers (time-based with randomization)
-    std::vector<cv::Mat> frame_history_;   // Ring buffer of past frames
-    int frame_history_index_ = 0;
-    int frame_counter_ = 0;  // Count frames to trigger random time offset changes
-    int current_time_offset_ = 30;  // Current random offset (in frames)
-    static constexpr int MAX_FRAME_HISTORY = 90;  // Store ~3 seconds at 30fps
-    static constexpr int MIN_TIME_OFFSET = 15;    // Min 0.5 sec at 30fps
-    static constexpr int MAX_TIME_OFFSET = 75;    // Max 2.5 sec at 30fps
-    
-    // Per-panel resources for multi-panel mode (lazy initialized)
+    // Processing resolution (0 = input resolution)
+    int processing_width_ = 0;
+    int processing_height_ = 0;
+    cv::Mat processing_frame_;   // Downscaled input, reused every frame
+    cv::Mat idle_input_;         // Black stand-in frame for renderFrame()
+    double area_scale_ = 1.0;    // Processing / input pixel count
+    double governor_scale_ = 1.0;  // Quality governor's factor on the processing size
+
+    // Foreground segmentation, computed at most once per frame and shared by all effects/panels
+    uint64_t frame_sequence_ = 0;
+    uint32_t scheduled_inputs_ = 0;          // Union of this frame's effects' inputs()
+    BackgroundModel::Type background_model_type_ = BackgroundModel::Type::MOG2;
+    SegmentationStage segmentation_;         // Full processing frame (single effect + EXTEND panels)
+    SegmentationStage repeat_segmentation_;  // Panel-sized input shared by all REPEAT panels
+    cv::Mat repeat_input_;
+    cv::Mat multi_panel_output_;     // Composited multi-panel frame
+    bool alloc_check_enabled_ = false;
+    uint64_t last_frame_allocations_ = 0;
+
+    // Past frames at processing resolution, only as deep as the largest double exposure
+    // offset. frame_history_ holds the full frame (EXTEND panels read their ROI of it);
+    // repeat_history_ holds the REPEAT-mode panel image, shared by all REPEAT panels.
+    FrameHistory frame_history_{DoubleExposureEffect::MAX_TIME_OFFSET};
+    FrameHistory repeat_history_{DoubleExposureEffect::MAX_TIME_OFFSET};
+
+    // Effect instances: one context for the single-effect path, one per panel
+    ProcessingContext frame_context_;
     bool panel_resources_initialized_ = false;
-    std::vector<cv::Ptr<cv::BackgroundSubtractor>> panel_bg_subtractors_;
-    std::vector<cv::Mat> panel_silhouette_frames_;
-    
-    // Per-panel Mode 7 (Double Exposure) resources
-    std::vector<std::vector<cv::Mat>> panel_frame_history_;  // Frame history for each panel
-    std::vector<int> panel_frame_history_index_;             // Circular buffer index per panel
-    std::vector<int> panel_frame_counter_;                   // Frame counter per panel
-    std::vector<int> panel_time_offset_;                     // Time offset per panel
-    
-    // Helper to process Mode 7 with specific state
-    void processDoubleExposureWithState(const cv::Mat& in_bgr, cv::Mat& out_bgr,
-                                        std::vector<cv::Mat>& history,
-                                        int& history_index,
-                                        int& frame_counter,
-                                        int& time_offset,
-                                        cv::Ptr<cv::BackgroundSubtractor> bg_subtractor);
-    
+    std::vector<ProcessingContext> panel_contexts_;
+    std::vector<cv::Rect> panel_rois_;
+    std::vector<int> panel_effect_ids_;
+
+    // Effect transitions: last_output_ references the last frame returned (kept alive by
+    // its refcount, no copy), which the transition engines snapshot on a switch
+    int transition_frames_ = 30;
+    cv::Mat last_output_;
+    cv::Mat transition_output_;      // Single-effect blend target (never an effect's buffer)
+    bool last_frame_multi_panel_ = false;
+
+    // Warm-state checkpoint: restored_state_ holds what was loaded (effects created
+    // later restore from it, and saves keep entries of effects not used this run)
+    std::string state_path_;
+    double state_interval_seconds_ = 30.0;
+    std::chrono::steady_clock::time_point last_state_save_;
+    StateCheckpoint restored_state_;
+    std::future<bool> state_save_;  // Background write of the last periodic save
+
+    // History side thread: one job at a time, handed over under history_mutex_
+    std::thread history_thread_;
+    std::mutex history_mutex_;
+    std::condition_variable history_wake_;  // Job posted, or stop
+    std::condition_variable history_done_;  // Job finished
+    FrameHistory* history_job_ = nullptr;   // Pending or running push (null: idle)
+    const cv::Mat* history_job_frame_ = nullptr;
+    bool history_thread_stop_ = false;
+
+    // Quality governor state
+    QualityGovernor governor_;
+    std::function<float()> temperature_source_;
+
+    // Motion-activated mode switching state
+    bool auto_mode_enabled_ = false;
+    ActivityMonitor activity_monitor_;
+    double active_threshold_ = 0.02;    // Fraction of probe pixels to become active
+    double idle_threshold_ = 0.005;     // Below this counts as idle
+    double idle_timeout_seconds_ = 10.0;
+    static constexpr int ACTIVATE_FRAMES = 2;
+    int active_streak_ = 0;
+    std::chrono::steady_clock::time_point last_activity_time_;
+
     // Auto-cycling state
     bool auto_cycling_enabled_ = true;
     int cycle_frame_counter_ = 0;
     int frames_until_next_mode_ = 0;
-    int transition_frames_remaining_ = 0;
-    int previous_mode_ = 1;
-    float transition_alpha_ = 0.0f;
-    cv::Mat previous_frame_output_;
+    // REPEAT mode: panel i shows the mode's valid effect (i + offset); auto-cycling
+    // advances the offset, so every panel switches (and crossfades) together
+    std::atomic<int> repeat_cycle_offset_{0};
     
     static constexpr int MIN_CYCLE_SECONDS = 3;
     static constexpr int MAX_CYCLE_SECONDS = 7;
-    static constexpr int TRANSITION_FRAMES = 30;  // 1 second transition at 30fps
-
-    // Effect class instances
-    std::unique_ptr<ProceduralShapesEffect> procedural_shapes_effect_;
-    std::unique_ptr<WavePatternsEffect> wave_patterns_effect_;
 };
 
 #endif // APP_CORE_H
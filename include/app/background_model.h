@@ -0,0 +1,122 @@
+#ifndef BACKGROUND_MODEL_H
+#define BACKGROUND_MODEL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <opencv2/core.hpp>
+#include <opencv2/video/background_segm.hpp>
+
+class StateCheckpoint;
+
+// Foreground/background separation backend for SegmentationStage.
+// apply() learns from frame_bgr (CV_8UC3) and writes a CV_8UC1 mask of the same size:
+// 255 = foreground, 127 = shadow (MOG2 only), 0 = background.
+// The cheap backends work on a downsampled grayscale copy and upscale the mask with
+// nearest neighbour, which is plenty for a silhouette on a 64-row matrix.
+class BackgroundModel {
+public:
+    enum class Type {
+        MOG2,             // OpenCV MOG2, history 500, shadow detection (reference quality)
+        MOG2_FAST,        // MOG2 without shadows, model updated every 4th frame
+        RUNNING_AVERAGE,  // Fixed-point running average on downsampled grayscale
+        FRAME_DIFF        // Difference to the previous downsampled frame (motion only)
+    };
+
+    virtual ~BackgroundModel() = default;
+
+    virtual void apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) = 0;
+
+    // Quality governor: update the model factor times less often than configured
+    // (1 = as configured). Only meaningful for models with a costly update (MOG2).
+    virtual void setUpdateSlowdown(int factor) { (void)factor; }
+
+    // Warm-state checkpoint: write/read the learned background under keys starting with
+    // prefix. A restored model classifies the first frame of the same size against it
+    // instead of learning from scratch. Models without useful state keep the defaults.
+    virtual void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+        (void)checkpoint;
+        (void)prefix;
+    }
+    virtual void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+        (void)checkpoint;
+        (void)prefix;
+    }
+
+    static std::unique_ptr<BackgroundModel> create(Type type);
+    // "mog2", "mog2-fast", "average", "diff"; false for anything else
+    static bool parseType(const char* name, Type& type);
+    static const char* getTypeName(Type type);
+};
+
+class Mog2BackgroundModel : public BackgroundModel {
+public:
+    // update_interval > 1 only updates the model every update_interval frames (keeping the
+    // same adaptation speed); the other frames are classified against the frozen model
+    Mog2BackgroundModel(int history, double var_threshold, bool detect_shadows, int update_interval = 1);
+
+    void apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) override;
+    void setUpdateSlowdown(int factor) override;
+    // MOG2's Gaussians aren't accessible, so the checkpoint holds its background image;
+    // the model is re-initialised from it and then learns at the steady-state rate
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
+
+private:
+    cv::Ptr<cv::BackgroundSubtractorMOG2> subtractor_;
+    int history_;
+    int update_interval_;
+    int slowdown_;
+    uint64_t frames_;
+    cv::Mat seed_;        // Restored background image, consumed by the next apply()
+    cv::Mat seed_mask_;   // Output of the seeding apply() (discarded)
+    bool warm_start_;     // Seeded: skip MOG2's fast initial learning
+};
+
+// Downsampled grayscale shared by the cheap backends
+class GrayBackgroundModel : public BackgroundModel {
+protected:
+    // Frames with at least MIN_DOWNSAMPLE_ROWS rows are halved before modelling
+    static constexpr int MIN_DOWNSAMPLE_ROWS = 128;
+
+    // frame_bgr -> gray_ (half size when large enough)
+    void toSmallGray(const cv::Mat& frame_bgr);
+    // small_mask_ -> fg_mask at the frame size
+    void upscaleMask(const cv::Size& frame_size, cv::Mat& fg_mask);
+
+    cv::Mat gray_full_;
+    cv::Mat gray_;
+    cv::Mat small_mask_;
+};
+
+class RunningAverageBackgroundModel : public GrayBackgroundModel {
+public:
+    // threshold: luma difference (0-255) to count as foreground.
+    // Background pixels adapt at 1/2^background_shift per frame, foreground pixels at
+    // 1/2^foreground_shift (someone standing still fades into the background slowly).
+    explicit RunningAverageBackgroundModel(int threshold = 20, int background_shift = 5,
+                                           int foreground_shift = 9);
+
+    void apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) override;
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
+
+private:
+    int threshold_;
+    int background_shift_;
+    int foreground_shift_;
+    cv::Mat background_;  // CV_16UC1, Q8.8 luma
+};
+
+class FrameDiffBackgroundModel : public GrayBackgroundModel {
+public:
+    explicit FrameDiffBackgroundModel(int threshold = 25);
+
+    void apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) override;
+
+private:
+    int threshold_;
+    cv::Mat previous_;
+};
+
+#endif // BACKGROUND_MODEL_H
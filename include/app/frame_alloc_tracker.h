@@ -0,0 +1,43 @@
+#ifndef FRAME_ALLOC_TRACKER_H
+#define FRAME_ALLOC_TRACKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+// Debug-only cv::Mat allocator that counts every buffer allocation and forwards
+// it to OpenCV's standard allocator. Once installed it sees all Mats created
+// without an explicit allocator, on every thread, so AppCore can measure how many
+// allocations a frame makes (steady state should only be OpenCV-internal ones,
+// e.g. the padded copy findContours makes).
+class FrameAllocTracker : public cv::MatAllocator {
+public:
+    static FrameAllocTracker& instance();
+
+    // Become cv::Mat's default allocator (idempotent)
+    void install();
+    bool isInstalled() const { return installed_; }
+
+    uint64_t getAllocationCount() const { return allocations_.load(std::memory_order_relaxed); }
+
+#if CV_VERSION_MAJOR >= 4
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override;
+    bool allocate(cv::UMatData* data, cv::AccessFlag access_flags,
+                  cv::UMatUsageFlags usage_flags) const override;
+#else
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           int flags, cv::UMatUsageFlags usage_flags) const override;
+    bool allocate(cv::UMatData* data, int access_flags, cv::UMatUsageFlags usage_flags) const override;
+#endif
+    void deallocate(cv::UMatData* data) const override;
+
+private:
+    FrameAllocTracker();
+
+    cv::MatAllocator* std_allocator_;
+    bool installed_;
+    mutable std::atomic<uint64_t> allocations_;
+};
+
+#endif // FRAME_ALLOC_TRACKER_H
@@ -0,0 +1,50 @@
+#ifndef FRAME_HISTORY_H
+#define FRAME_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Ring of past frames for time-offset effects (double exposure).
+// Frames are stored at whatever resolution they are pushed at (AppCore's processing
+// resolution), optionally packed as BGR565 to cut memory and bandwidth by a third.
+// One ring can back several consumers: push() is keyed by frame sequence, so
+// repeated pushes of the same frame are no-ops, and reads take a ROI.
+class FrameHistory {
+public:
+    enum class Format {
+        BGR,     // CV_8UC3, read back without conversion
+        BGR565   // CV_8UC2, 2 bytes per pixel, decoded on read
+    };
+
+    explicit FrameHistory(int capacity, Format format = Format::BGR);
+
+    // Changing the format drops the stored frames
+    void setFormat(Format format);
+    Format getFormat() const { return format_; }
+    int getCapacity() const { return static_cast<int>(slots_.size()); }
+    // Resize the ring, keeping the newest frames that still fit (shrinking frees the rest)
+    void setCapacity(int capacity);
+
+    // Store frame_bgr (CV_8UC3) as the newest entry, unless this sequence was already pushed.
+    // A frame of a different size restarts the history.
+    void push(const cv::Mat& frame_bgr, uint64_t sequence);
+
+    // Frame pushed frames_back pushes ago (1 = newest) restricted to roi, as BGR.
+    // BGR storage returns a view; BGR565 decodes into out_bgr.
+    // Returns false while the history is not yet that deep.
+    bool read(int frames_back, const cv::Rect& roi, cv::Mat& out_bgr) const;
+
+    void clear();
+
+private:
+    std::vector<cv::Mat> slots_;
+    Format format_;
+    int next_;       // Slot the next push writes
+    int count_;      // Valid frames (<= capacity)
+    uint64_t last_sequence_;
+    bool has_sequence_;
+    cv::Size frame_size_;
+};
+
+#endif // FRAME_HISTORY_H
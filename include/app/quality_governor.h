@@ -0,0 +1,51 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+// Runtime policy over the manual trade-offs in OPTIMIZATIONS.md. Each quality level
+// adds one step on top of the previous ones (see describeLevel()); AppCore applies them.
+// The governor steps down (cheaper) when the smoothed processing time exceeds the frame
+// budget or the CPU runs hotter than the target, and back up only after a sustained
+// stretch of headroom on both. Steps up that are undone soon after make the next
+// step up wait longer, so the level settles instead of oscillating at a boundary.
+class QualityGovernor {
+public:
+    static constexpr int MAX_LEVEL = 5;
+
+    QualityGovernor();
+
+    // target_fps <= 0 ignores frame time, target_temp_c <= 0 ignores temperature;
+    // with both off the governor stays at level 0 (full quality)
+    void configure(double target_fps, float target_temp_c);
+    bool isEnabled() const { return target_fps_ > 0.0 || target_temp_c_ > 0.0f; }
+
+    // Feed one processed frame: its processing time and the latest CPU temperature
+    // (<= 0 when unknown). Returns true when the level changed.
+    bool update(double process_ms, float temperature_c);
+
+    int getLevel() const { return level_; }
+    double getAverageProcessMs() const { return average_ms_; }
+    // What level adds, e.g. "MOG2 updates halved"
+    static const char* describeLevel(int level);
+
+private:
+    // Frame counts (the runners aim for 30fps)
+    static constexpr int DOWN_FRAMES = 30;          // Sustained slow frames before a step down
+    // CPU temperature responds over tens of seconds, so each step down under heat waits
+    // for the previous one to show instead of running through every level at once
+    static constexpr int TEMP_DOWN_FRAMES = 450;
+    static constexpr int MIN_UP_FRAMES = 150;       // Sustained headroom before a step up
+    static constexpr int MAX_UP_FRAMES = 1800;
+    static constexpr float TEMP_HYSTERESIS_C = 3.0f;
+
+    double target_fps_;
+    float target_temp_c_;
+    int level_;
+    double average_ms_;        // Exponential moving average of the processing time
+    int slow_frames_;
+    int hot_frames_;
+    int headroom_frames_;
+    int up_frames_;            // Current headroom requirement, backs off after reverted steps up
+    int frames_since_up_;      // Since the last step up (-1: none pending)
+};
+
+#endif // QUALITY_GOVERNOR_H
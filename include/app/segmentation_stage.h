@@ -0,0 +1,105 @@
+#ifndef SEGMENTATION_STAGE_H
+#define SEGMENTATION_STAGE_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "app/activity_monitor.h"
+#include "app/background_model.h"
+
+// Per-frame foreground segmentation shared by every effect and panel.
+// Results are computed on first use and cached until the next beginFrame() (or the next
+// refresh, see setRefreshPolicy()), so the
+// background model (MOG2 by default, see BackgroundModel),
+// the morphology cleanup and findContours run at most once per frame no matter how
+// many effects or panels read them. Frames where nothing asks for a mask never reach
+// the background model (same learning behaviour as calling apply() per effect).
+// Not thread-safe while computing; results already computed for the current frame
+// can be read concurrently (AppCore prefetches before dispatching panels in parallel).
+class SegmentationStage {
+public:
+    SegmentationStage();
+
+    // Start a new frame. frame_bgr must stay alive and unchanged until the next call.
+    void beginFrame(const cv::Mat& frame_bgr, uint64_t sequence);
+    uint64_t getSequence() const { return sequence_; }
+    cv::Rect getFrameRect() const { return cv::Rect(0, 0, frame_.cols, frame_.rows); }
+
+    // Ellipse kernel size for the open/close cleanup (takes effect on the next frame)
+    void setCleanupKernelSize(int size);
+
+    // Replace the background model; the new one starts learning from the next frame
+    void setBackgroundModel(std::unique_ptr<BackgroundModel> model);
+
+    // Warm-state checkpoint of the background model (see BackgroundModel::saveState())
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix);
+
+    // Quality governor knobs. The update slowdown is passed to the background model
+    // (and kept across setBackgroundModel()); epsilon > 0 simplifies every contour with
+    // approxPolyDP (fewer edges to fill/draw), 0 keeps findContours' output.
+    void setModelUpdateSlowdown(int factor);
+    void setContourEpsilon(double epsilon);
+
+    // Reduced-rate segmentation: refresh the background model, masks and contours every
+    // interval frames and reuse the cached results in between (effects keep animating on
+    // the reused silhouette). change_threshold > 0 refreshes early when that fraction of a
+    // 32x24 luma probe changed since the last refresh. interval 1 refreshes every frame.
+    void setRefreshPolicy(int interval, double change_threshold);
+    // True when this frame reuses the previous results
+    bool isReusingResults() const { return reusing_; }
+
+    // Raw foreground mask (CV_8UC1, 255 = foreground, 127 = shadow with MOG2)
+    const cv::Mat& foregroundMask();
+    // Foreground mask after MORPH_OPEN + MORPH_CLOSE (removes speckle, fills small holes)
+    const cv::Mat& cleanedMask();
+
+    // External contours with area > min_area, found on the raw or cleaned mask.
+    // roi restricts the search to a sub-rectangle (contour points are ROI-relative);
+    // an empty roi means the whole frame.
+    const std::vector<std::vector<cv::Point>>& contours(int min_area, bool cleaned,
+                                                        const cv::Rect& roi = cv::Rect());
+
+private:
+    bool needsRefresh();
+
+    struct ContourEntry {
+        int min_area;
+        bool cleaned;
+        cv::Rect roi;
+        std::vector<std::vector<cv::Point>> contours;
+    };
+
+    std::unique_ptr<BackgroundModel> background_model_;
+    cv::Mat frame_;
+    uint64_t sequence_;
+
+    cv::Mat fg_mask_;
+    cv::Mat cleaned_mask_;
+    bool fg_valid_;
+    bool cleaned_valid_;
+    int cleanup_kernel_size_;
+    cv::Mat cleanup_kernel_;
+    int update_slowdown_;
+    double contour_epsilon_;
+
+    int refresh_interval_;
+    double change_threshold_;
+    int frames_since_refresh_;
+    bool reusing_;
+    bool probed_;                   // change_probe_ already ran on this frame
+    ActivityMonitor change_probe_;  // Change since the last refresh
+
+    // Entries [0, contours_used_) belong to the current frame; the rest are kept for reuse.
+    // deque so references handed out stay valid while more entries are added.
+    std::deque<ContourEntry> contour_cache_;
+    size_t contours_used_;
+    std::vector<std::vector<cv::Point>> raw_contours_;  // findContours scratch
+    std::vector<cv::Point> approx_scratch_;             // approxPolyDP output
+};
+
+#endif // SEGMENTATION_STAGE_H
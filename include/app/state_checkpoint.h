@@ -0,0 +1,39 @@
+#ifndef STATE_CHECKPOINT_H
+#define STATE_CHECKPOINT_H
+
+#include <map>
+#include <string>
+#include <opencv2/core.hpp>
+
+// Named matrices and scalars making up AppCore's warm state (background model, trail
+// buffers, animation clocks), saved to and restored from a small binary file so a
+// restart picks up where the previous process left off instead of re-learning.
+// Keys are paths like "segmentation/mog2/background" or "panel1/5/trail_age"; readers
+// ignore missing keys and entries whose size no longer matches.
+class StateCheckpoint {
+public:
+    // Store a copy of value (any type, continuous or not)
+    void put(const std::string& key, const cv::Mat& value);
+    void putValue(const std::string& key, double value);
+
+    // value references the checkpoint's data (copy it to keep it past clear())
+    bool get(const std::string& key, cv::Mat& value) const;
+    bool getValue(const std::string& key, double& value) const;
+    // get() for a matrix of the expected size and type, copied into target
+    bool restore(const std::string& key, cv::Mat& target) const;
+
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+    void clear() { entries_.clear(); }
+
+    // The file is written through a shared mapping to path + ".tmp" and renamed over
+    // path, so a crash mid-save leaves the previous checkpoint intact
+    bool save(const std::string& path) const;
+    // Replaces the contents with the file's; false (and empty) when it is missing or invalid
+    bool load(const std::string& path);
+
+private:
+    std::map<std::string, cv::Mat> entries_;
+};
+
+#endif // STATE_CHECKPOINT_H
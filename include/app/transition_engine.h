@@ -0,0 +1,35 @@
+#ifndef TRANSITION_ENGINE_H
+#define TRANSITION_ENGINE_H
+
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+// Crossfade from the outgoing effect to the incoming one without running both.
+// begin() copies the outgoing effect's last output once; every following frame blends
+// that snapshot with the incoming effect's live output (Q8 fixed-point lerp, SIMD), so
+// a transition costs one copy plus one blend per frame and never a second effect.
+class TransitionEngine {
+public:
+    explicit TransitionEngine(int duration_frames = 30);
+
+    // Frames a transition takes; 0 disables transitions (switches cut)
+    void setDuration(int frames);
+    int getDuration() const { return duration_; }
+
+    // Start fading out from outgoing (CV_8UC3), the last frame shown. Mid-transition that
+    // is the current blend, so rapid switches stay smooth.
+    void begin(const cv::Mat& outgoing);
+    void cancel() { remaining_ = 0; }
+    bool isActive() const { return remaining_ > 0; }
+
+    // Blend incoming towards the snapshot into out and advance one frame.
+    // out may be incoming itself (blends in place). A size change ends the transition.
+    void apply(const cv::Mat& incoming, cv::Mat& out);
+
+private:
+    int duration_;
+    int remaining_;
+    cv::Mat snapshot_;
+};
+
+#endif // TRANSITION_ENGINE_H
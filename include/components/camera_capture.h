@@ -1,8 +1,13 @@
 #ifndef CAMERA_CAPTURE_H
 #define CAMERA_CAPTURE_H
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <libcamera/libcamera.h>
 #include <libcamera/camera_manager.h>
 #include <libcamera/camera.h>
@@ -10,8 +15,18 @@
 #include <libcamera/request.h>
 #include <libcamera/controls.h>
 
+#include "components/frame_queue.h"
+
 using namespace libcamera;
 
+// What the pipelined worker does when frames arrive faster than they are processed
+enum class FrameDropPolicy {
+    DROP_OLDEST,  // Latest wins: stale queued frames are recycled, only the newest is processed
+    DROP_NEWEST   // Queued frames are processed in order; new frames are recycled while the queue is full
+};
+
+class FrameRecorder;
+
 class CameraCapture {
 public:
     CameraCapture(int width, int height, int sensor_width = 0, int sensor_height = 0);
@@ -23,11 +38,43 @@ public:
 
     void start();
     void stop();
-    void setFrameCallback(std::function<void(uint8_t*, int, int)> callback);
+    // Callback receives (data, width, height, stride); stride is the row pitch in bytes
+    // reported by libcamera and may be larger than width * 3.
+    void setFrameCallback(std::function<void(uint8_t*, int, int, int)> callback);
+
+    // Pipelined mode: completed requests are handed to a processing thread through a
+    // lock-free ring instead of running the frame callback on libcamera's completion thread.
+    // Must be called before start(). queue_depth only applies to DROP_NEWEST.
+    void setPipelined(bool enabled, int queue_depth = 2,
+                      FrameDropPolicy policy = FrameDropPolicy::DROP_OLDEST);
+    bool isPipelined() const { return pipelined_; }
+
+    // Cap the sensor frame rate via FrameDurationLimits; fps <= 0 restores the default
+    // (~120fps). Safe to call while streaming: the new limit rides on the next re-queued request.
+    void setFrameRateLimit(double fps);
+    double getFrameRateLimit() const;
+
+    // Sensor exposure start -> frame callback for the frame currently being delivered
+    // (read it from inside the callback); 0 when the pipeline reports no SensorTimestamp
+    uint64_t getLastCaptureLatencyNs() const { return last_capture_latency_ns_.load(); }
+
+    // Frames recycled without reaching the callback (pipelined mode only)
+    uint64_t getDroppedFrames() const { return dropped_frames_.load(); }
+
+    // Copy every delivered frame (stamped with its SensorTimestamp) into recorder, on the
+    // delivering thread just before the callback. Set before start(); null stops recording.
+    void setRecorder(FrameRecorder* recorder) { recorder_ = recorder; }
 
 private:
     void setup();
     void processRequest(Request *request);
+    bool mapBuffers(Stream *stream);
+    void unmapBuffers();
+    void deliverFrame(Request *request);
+    void requeueRequest(Request *request);
+    void startWorker();
+    void stopWorker();
+    void workerLoop();
     void cleanup();
 
     int width_;          // Output resolution (after ISP scaling)
@@ -36,11 +83,40 @@ private:
     int sensor_height_;
     int actual_width_;   // Actual camera stream width
     int actual_height_;  // Actual camera stream height
+    int stride_;         // Bytes per row of the configured stream (may include padding)
     std::unique_ptr<CameraManager> camera_manager_;
     std::shared_ptr<Camera> camera_;
     FrameBufferAllocator *allocator_;
-    std::function<void(uint8_t*, int, int)> frame_callback_;
+    std::function<void(uint8_t*, int, int, int)> frame_callback_;
     bool frame_callback_connected_;
+    FrameRecorder* recorder_ = nullptr;
+
+    // Persistent buffer mappings, created once after allocate() and released in cleanup().
+    // Each FrameBuffer's cookie indexes buffer_data_.
+    struct BufferMapping {
+        void *address;
+        size_t length;
+    };
+    std::vector<BufferMapping> mappings_;
+    std::vector<uint8_t*> buffer_data_;  // Start of plane 0 pixel data (mapping + plane.offset)
+
+    // Pipelined mode state
+    bool pipelined_;
+    int queue_depth_;
+    FrameDropPolicy drop_policy_;
+    std::unique_ptr<FrameQueue<Request*>> frame_queue_;
+    std::thread worker_thread_;
+    std::atomic<bool> worker_running_;
+    std::mutex worker_mutex_;              // Only guards sleeping/waking, never the ring itself
+    std::condition_variable worker_wake_;
+    std::atomic<uint64_t> dropped_frames_;
+
+    // Frame duration (us) requested from the sensor; pending until applied to a request
+    static constexpr int64_t DEFAULT_FRAME_DURATION_US = 8333;  // 120 fps
+    std::atomic<int64_t> frame_duration_us_;
+    std::atomic<bool> frame_duration_pending_;
+
+    std::atomic<uint64_t> last_capture_latency_ns_;
 };
 
 #endif // CAMERA_CAPTURE_H
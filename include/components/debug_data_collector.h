@@ -3,10 +3,66 @@
 
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Lock-free latency histogram: log-linear buckets (8 per power of two of microseconds,
+// <= 12.5% resolution) up to ~16s. record() is two relaxed atomic adds, so any number
+// of hot-path threads can write while readers (the periodic report, the metrics
+// endpoint) take snapshots. Counts are cumulative; windows are computed by diffing.
+class LatencyHistogram {
+public:
+    static constexpr int NUM_BUCKETS = 184;
+
+    struct Snapshot {
+        uint64_t counts[NUM_BUCKETS];
+        uint64_t sum_ns;
+    };
+
+    struct Summary {
+        uint64_t count = 0;
+        double p50_ms = 0.0;
+        double p95_ms = 0.0;
+        double p99_ms = 0.0;
+        double max_ms = 0.0;
+    };
+
+    LatencyHistogram();
+
+    void record(uint64_t nanoseconds);
+    // Percentiles of everything recorded since the previous call (single caller)
+    Summary takeSummary();
+    // Cumulative counts since construction (any thread)
+    void snapshot(Snapshot& out) const;
+
+    // Upper bound of a bucket, in microseconds
+    static double bucketUpperMicros(int bucket);
+
+private:
+    static int bucketFor(uint64_t micros);
+
+    std::atomic<uint64_t> buckets_[NUM_BUCKETS];
+    std::atomic<uint64_t> sum_ns_;
+    uint64_t reported_[NUM_BUCKETS];  // Counts at the last takeSummary()
+};
 
 class DebugDataCollector {
 public:
+    // Hot-path stages timed per frame
+    enum class Stage {
+        CAPTURE = 0,  // Sensor timestamp -> frame callback (capture + ISP + queueing)
+        PROCESS,      // AppCore::processFrame (also binned per effect)
+        DISPLAY,      // Scale + canvas write
+        VSYNC,        // SwapOnVSync wait
+        COUNT
+    };
+    static constexpr int NUM_EFFECT_BINS = 10;  // Effect 1-9, 0 = multi-panel
+
     DebugDataCollector();
+    ~DebugDataCollector();
     
     // Call this for each frame to update FPS tracking
     void recordFrame();
@@ -14,16 +70,75 @@ public:
     // Get current FPS (updated every second)
     double getFPS() const;
     
-    // Read current temperature from system
+    // Latest temperature, sampled once per second on a background thread
     float getTemperature() const;
+    // Raspberry Pi firmware throttling bitmask (get_throttled), -1 when unavailable
+    int getThrottled() const { return throttled_.load(); }
+    uint64_t getFrameCount() const { return frames_total_.load(); }
+
+    void recordStage(Stage stage, uint64_t nanoseconds);
+    void recordEffect(int effect, uint64_t nanoseconds);
+    // Running total of frames dropped upstream (e.g. CameraCapture::getDroppedFrames())
+    void setDroppedFrames(uint64_t total) { dropped_total_ = total; }
+    uint64_t getDroppedFrames() const { return dropped_total_.load(); }
+
+    // What is on screen, for export (relaxed stores, safe from the frame path)
+    void setCurrentState(int effect, int system_mode) {
+        current_effect_.store(effect, std::memory_order_relaxed);
+        system_mode_.store(system_mode, std::memory_order_relaxed);
+    }
+    int getCurrentEffect() const { return current_effect_.load(std::memory_order_relaxed); }
+    int getSystemMode() const { return system_mode_.load(std::memory_order_relaxed); }
+
+    const LatencyHistogram& getStageHistogram(Stage stage) const { return stages_[static_cast<int>(stage)]; }
+    const LatencyHistogram& getEffectHistogram(int bin) const { return effects_[bin]; }
+    static const char* stageName(Stage stage);
+
+    // Multi-line p50/p95/p99 report for the window since the previous call
+    std::string takeReport();
+
+    // Records the lifetime of the scope into a stage (or effect bin); a null collector is a no-op
+    class ScopedTimer {
+    public:
+        ScopedTimer(DebugDataCollector* collector, Stage stage);
+        ScopedTimer(DebugDataCollector* collector, Stage stage, int effect);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        DebugDataCollector* collector_;
+        Stage stage_;
+        int effect_;
+        std::chrono::steady_clock::time_point start_;
+    };
 
 private:
     // FPS tracking
     std::atomic<uint64_t> frame_count_;
     std::chrono::steady_clock::time_point last_fps_time_;
     std::atomic<double> current_fps_;
+    std::atomic<uint64_t> frames_total_;
+    std::atomic<int> current_effect_;
+    std::atomic<int> system_mode_;
+
+    LatencyHistogram stages_[static_cast<int>(Stage::COUNT)];
+    LatencyHistogram effects_[NUM_EFFECT_BINS];
+    std::atomic<uint64_t> dropped_total_;
+    uint64_t dropped_reported_;
+
+    // Temperature sampling thread (one sysfs read per second instead of one per frame)
+    std::atomic<float> temperature_;
+    std::atomic<int> throttled_;
+    std::thread sampler_thread_;
+    std::mutex sampler_mutex_;
+    std::condition_variable sampler_wake_;
+    bool sampler_running_;
+    void samplerLoop();
     
     float readTemperature() const;
+    int readThrottled() const;
 };
 
 #endif // DEBUG_DATA_COLLECTOR_H
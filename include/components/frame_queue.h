@@ -0,0 +1,54 @@
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded single-producer / single-consumer ring buffer.
+// push() may only be called from one thread and pop() from one other thread;
+// neither side ever blocks or takes a lock.
+template <typename T>
+class FrameQueue {
+public:
+    explicit FrameQueue(size_t capacity)
+        : slots_(capacity + 1), head_(0), tail_(0) {}
+
+    // Returns false (and leaves item untouched) when the queue is full
+    bool push(const T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = advance(tail);
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail] = item;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Returns false when the queue is empty
+    bool pop(T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots_[head];
+        head_.store(advance(head), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots_.size() - 1; }
+
+private:
+    size_t advance(size_t index) const { return (index + 1) % slots_.size(); }
+
+    std::vector<T> slots_;  // One slot is kept empty to tell "full" from "empty"
+    alignas(64) std::atomic<size_t> head_;  // Next slot to read (consumer)
+    alignas(64) std::atomic<size_t> tail_;  // Next slot to write (producer)
+};
+
+#endif // FRAME_QUEUE_H
@@ -0,0 +1,105 @@
+#ifndef FRAME_RECORDING_H
+#define FRAME_RECORDING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "components/frame_source.h"
+
+// Raw frame recordings for reproducible runs: the same frames, in the same order, with
+// the original timing, can be fed back into any runner (including real LED output).
+//
+// File layout (native byte order):
+//   64-byte header: magic "RPIMREC1", width, height, stride, pixel order, frame size,
+//                   record size, frame count
+//   records:        8-byte timestamp (ns), padding to 64 bytes, then stride * height
+//                   bytes of pixels; each record is padded to a multiple of 64 bytes
+// All frames in a file share one size; frames of any other size are not recorded.
+
+// Appends frames to a recording through a growing shared mapping, so recording a frame
+// is one memcpy on the frame path (the kernel writes the pages back later).
+class FrameRecorder {
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // Create (truncate) path; frame size and pixel order are taken from the first frame
+    bool open(const std::string& path);
+    // timestamp_ns = 0 stamps the frame with the steady clock
+    void record(const uint8_t* data, int width, int height, int stride, PixelOrder order,
+                uint64_t timestamp_ns = 0);
+    void record(const FrameView& frame) {
+        record(frame.data, frame.width, frame.height, frame.stride, frame.order, frame.timestamp_ns);
+    }
+    // Flush the header and trim the file to the recorded frames
+    void close();
+
+    bool isOpen() const { return fd_ >= 0; }
+    uint64_t getFrameCount() const { return frame_count_; }
+
+private:
+    bool reserve(size_t bytes);
+    void writeHeader();
+
+    int fd_;
+    std::string path_;
+    PixelOrder order_;
+    uint8_t* mapping_;
+    size_t mapping_size_;
+    int width_;
+    int height_;
+    int stride_;
+    size_t frame_bytes_;
+    size_t record_bytes_;
+    uint64_t frame_count_;
+    bool size_mismatch_logged_;
+};
+
+// Plays a recording back as a FrameSource, straight out of a read-only mapping
+// (frames are handed out without copying).
+class ReplayFrameSource : public FrameSource {
+public:
+    enum class Speed {
+        NATIVE,  // Honour the recorded frame intervals
+        MAX      // Hand out frames as fast as they are read
+    };
+
+    ReplayFrameSource(const std::string& path, Speed speed = Speed::NATIVE, bool loop = false);
+    ~ReplayFrameSource() override;
+
+    ReplayFrameSource(const ReplayFrameSource&) = delete;
+    ReplayFrameSource& operator=(const ReplayFrameSource&) = delete;
+
+    bool isOpen() const { return mapping_ != nullptr; }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+    PixelOrder getPixelOrder() const { return order_; }
+    uint64_t getFrameCount() const { return frame_count_; }
+
+    bool read(FrameView& frame) override;
+
+private:
+    Speed speed_;
+    bool loop_;
+    const uint8_t* mapping_;
+    size_t mapping_size_;
+    int width_;
+    int height_;
+    int stride_;
+    PixelOrder order_;
+    size_t header_bytes_;
+    size_t record_bytes_;
+    uint64_t frame_count_;
+    uint64_t next_frame_;
+
+    // Native pacing: wall time of the first frame of the current pass and its timestamp
+    std::chrono::steady_clock::time_point pass_start_;
+    uint64_t pass_first_timestamp_;
+};
+
+#endif // FRAME_RECORDING_H
@@ -0,0 +1,64 @@
+#ifndef FRAME_SCALER_H
+#define FRAME_SCALER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "components/output_curve.h"
+
+// Byte order of packed 3-channel frames
+enum class PixelOrder {
+    BGR,  // OpenCV / libcamera RGB888 (our app convention)
+    RGB   // FFmpeg rgb24
+};
+
+// Resamples packed 24-bit frames to matrix resolution.
+// Source row/column index tables are precomputed and only rebuilt when the input or
+// output size changes, so the per-frame cost is one table lookup per LED.
+// Output is always tightly packed RGB (3 bytes per LED), ready for bulk canvas writes.
+// An optional OutputCurve (gamma/brightness/dither) is applied to each output row as
+// soon as it is written, while it is still in cache.
+class FrameScaler {
+public:
+    enum class Mode {
+        NEAREST,  // One source pixel per LED (matches the old per-pixel sampling)
+        AREA      // Box filter: average of every source pixel covered by the LED
+    };
+
+    explicit FrameScaler(Mode mode = Mode::NEAREST);
+
+    void setMode(Mode mode);
+    Mode getMode() const { return mode_; }
+
+    // Output stage for every scaled frame (disabled by default: values pass through)
+    void setOutputCurve(const OutputCurve::Settings& settings);
+
+    // Scale src into dst_rgb, which must hold dst_width * dst_height * 3 bytes.
+    // src_stride is the row pitch in bytes (0 = src_width * 3).
+    void scale(const uint8_t *src, int src_width, int src_height, int src_stride,
+               PixelOrder order, uint8_t *dst_rgb, int dst_width, int dst_height);
+
+private:
+    void configure(int src_width, int src_height, int dst_width, int dst_height);
+    void scaleNearest(const uint8_t *src, int src_stride, PixelOrder order, uint8_t *dst_rgb);
+    void scaleArea(const uint8_t *src, int src_stride, PixelOrder order, uint8_t *dst_rgb);
+    void copyRows(const uint8_t *src, int src_stride, PixelOrder order, uint8_t *dst_rgb);
+
+    Mode mode_;
+    OutputCurve curve_;
+    int src_width_;
+    int src_height_;
+    int dst_width_;
+    int dst_height_;
+
+    // Source span [begin, end) for each output column / row.
+    // NEAREST only uses begin; col_begin_ is stored as a byte offset (x * 3).
+    std::vector<int> col_begin_;
+    std::vector<int> col_end_;
+    std::vector<int> row_begin_;
+    std::vector<int> row_end_;
+
+    std::vector<uint32_t> row_sums_;  // AREA accumulator for one output row (3 per LED)
+};
+
+#endif // FRAME_SCALER_H
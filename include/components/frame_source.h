@@ -0,0 +1,31 @@
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <cstdint>
+
+#include "components/frame_scaler.h"  // PixelOrder
+
+// One packed 24-bit frame handed out by a FrameSource. The pixels belong to the source
+// and stay valid until its next read().
+struct FrameView {
+    const uint8_t* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;               // Row pitch in bytes (>= width * 3)
+    PixelOrder order = PixelOrder::BGR;
+    uint64_t timestamp_ns = 0;    // Capture time; only differences are meaningful
+};
+
+// Pull-style frame input shared by the runners: stdin (rpicam-vid | ffmpeg), OpenCV
+// VideoCapture (desktop) and ReplayFrameSource (recordings from any of them).
+// CameraCapture stays push-based (libcamera completes requests on its own thread) and
+// feeds a FrameRecorder instead.
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Block until the next frame; false at end of stream or on error
+    virtual bool read(FrameView& frame) = 0;
+};
+
+#endif // FRAME_SOURCE_H
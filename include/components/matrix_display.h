@@ -2,9 +2,13 @@
 #define MATRIX_DISPLAY_H
 
 #include <string>
+#include <vector>
 #include <led-matrix.h>
 #include <functional>
 
+#include "components/debug_data_collector.h"
+#include "components/frame_scaler.h"
+
 using rgb_matrix::RGBMatrix;
 using rgb_matrix::FrameCanvas;
 
@@ -22,14 +26,28 @@ public:
     int getWidth() const;
     int getHeight() const;
 
+    // Resampling used when the frame size differs from the matrix size
+    void setScaleMode(FrameScaler::Mode mode);
+    // Byte order of frames passed to displayFrame (default BGR)
+    void setInputOrder(PixelOrder order);
+    // Apply gamma, brightness and dithering ourselves in the scaler (OutputCurve) instead
+    // of the library's luminance correction and brightness. pwm_bits comes from the
+    // constructor, so levels land on the panel's PWM steps. gamma <= 0 restores the library's.
+    void setOutputCurve(double gamma, bool dither);
+
+    // Time scale/write (DISPLAY) and SwapOnVSync (VSYNC) into collector; nullptr disables
+    void setTimingCollector(DebugDataCollector* collector) { timing_ = collector; }
+
     // Display frame with optional overlay callback
+    // stride is the row pitch in bytes (0 = tightly packed, width * 3)
     // The overlay callback is called before SwapOnVSync, allowing drawing on the canvas
-    void displayFrame(uint8_t *data, int width, int height, 
+    void displayFrame(uint8_t *data, int width, int height, int stride = 0,
                       std::function<void(FrameCanvas*)> overlay_callback = nullptr);
 
 private:
     void setup();
     void cleanup();
+    void writeCanvas();
 
     int rows_;
     int cols_;
@@ -44,6 +62,11 @@ private:
     int limit_refresh_rate_hz_;
     RGBMatrix *matrix_;
     FrameCanvas *canvas_;
+
+    FrameScaler scaler_;
+    PixelOrder input_order_;
+    std::vector<uint8_t> rgb_buffer_;  // Packed RGB at matrix resolution
+    DebugDataCollector* timing_ = nullptr;
 };
 
 #endif // MATRIX_DISPLAY_H
@@ -0,0 +1,39 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+class DebugDataCollector;
+
+// Minimal HTTP endpoint serving DebugDataCollector statistics in the Prometheus text
+// format (GET /metrics). Runs on its own thread and only performs relaxed atomic loads
+// on the collector, so a scrape never blocks or slows the frame path.
+class MetricsServer {
+public:
+    MetricsServer(const DebugDataCollector& collector, int port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Bind and start serving; returns false if the port cannot be opened
+    bool start();
+    void stop();
+
+    int getPort() const { return port_; }
+
+private:
+    const DebugDataCollector& collector_;
+    int port_;
+    int listen_fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    void serveLoop();
+    void handleClient(int client_fd);
+    std::string renderMetrics() const;
+};
+
+#endif // METRICS_SERVER_H
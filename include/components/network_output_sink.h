@@ -0,0 +1,66 @@
+#ifndef NETWORK_OUTPUT_SINK_H
+#define NETWORK_OUTPUT_SINK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+
+#include "components/frame_scaler.h"
+#include "components/output_sink.h"
+
+// Drives matrices on other nodes from this one's processed frames: each frame is split
+// into one tile per endpoint (left to right, the same split as AppCore's EXTEND panels),
+// each tile is resampled to tile_width x tile_height and sent as RGB565 over UDP
+// (tile_protocol.h) to a matrix_receiver. Not limited by AppCore's panel count.
+// Sends never block: a datagram the socket cannot take is dropped and the next keyframe
+// repairs the tile.
+class NetworkOutputSink : public OutputSink {
+public:
+    // endpoints: "host:port" per tile, leftmost first
+    NetworkOutputSink(const std::vector<std::string>& endpoints, int tile_width, int tile_height);
+    ~NetworkOutputSink() override;
+
+    NetworkOutputSink(const NetworkOutputSink&) = delete;
+    NetworkOutputSink& operator=(const NetworkOutputSink&) = delete;
+
+    bool isReady() const override { return fd_ >= 0 && !tiles_.empty(); }
+    int getTileCount() const { return static_cast<int>(tiles_.size()); }
+
+    void setScaleMode(FrameScaler::Mode mode);
+    // Every interval frames all rows are sent, unchanged or not (default 30; 1 = no deltas)
+    void setKeyframeInterval(int interval);
+
+    void writeFrame(const uint8_t* data, int width, int height, int stride, PixelOrder order) override;
+
+    // Split "host:port,host:port,..." into endpoints; false when an entry has no port
+    static bool parseEndpoints(const char* list, std::vector<std::string>& endpoints);
+    // Columns [x, x + width) of tile index out of count in a frame_width-wide frame
+    static void tileSpan(int frame_width, int count, int index, int& x, int& width);
+
+private:
+    struct Tile {
+        std::string endpoint;
+        sockaddr_in address;
+        FrameScaler scaler;
+        std::vector<uint16_t> pixels;       // RGB565 of this frame
+        std::vector<uint16_t> sent_pixels;  // As last sent, for the delta
+    };
+
+    bool resolve(const std::string& endpoint, sockaddr_in& address);
+    void sendTile(Tile& tile, int index, bool keyframe);
+    void sendDatagram(Tile& tile, const uint8_t* data, size_t bytes);
+
+    int fd_;
+    int tile_width_;
+    int tile_height_;
+    int keyframe_interval_;
+    uint32_t session_;   // TilePacketHeader::session
+    uint32_t sequence_;
+    uint64_t dropped_datagrams_;
+    std::vector<Tile> tiles_;
+    std::vector<uint8_t> rgb_;      // One tile at tile resolution, packed RGB
+    std::vector<uint8_t> datagram_;
+};
+
+#endif // NETWORK_OUTPUT_SINK_H
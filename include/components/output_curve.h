@@ -0,0 +1,45 @@
+#ifndef OUTPUT_CURVE_H
+#define OUTPUT_CURVE_H
+
+#include <cstdint>
+#include <vector>
+
+// Output stage applied to matrix-resolution pixels on their way to the LEDs: gamma,
+// brightness and quantization to the panel's PWM depth, from one table lookup per
+// channel. With dithering, each pixel picks one of 16 tables (ordered 4x4 Bayer
+// thresholds, rotated every frame), so a level between two PWM steps alternates between
+// them over time and averages out to the requested brightness. That keeps smooth
+// gradients at low pwm_bits, which buys refresh rate.
+class OutputCurve {
+public:
+    struct Settings {
+        double gamma = 0.0;      // Exponent from pixel value to LED duty cycle; <= 0 disables the stage
+        int brightness = 100;    // Percent, applied in linear light
+        int pwm_bits = 8;        // Levels the panel can show (capped at 8: output is 8-bit)
+        bool dither = false;     // Temporal ordered dithering between PWM levels
+    };
+
+    OutputCurve();
+
+    // preview = true encodes the result for a monitor (undoes gamma) instead of the LED
+    // duty cycle, so SoftwareMatrixDisplay shows quantization/dither/brightness as on the panel
+    void configure(const Settings& settings, bool preview = false);
+    bool isEnabled() const { return enabled_; }
+
+    // Call once per displayed frame: advances the dither phase
+    void beginFrame();
+    // Map one row of packed 3-channel pixels in place (any channel order); y is the row
+    // on the matrix, for the dither pattern
+    void applyRow(uint8_t* row, int width, int y) const;
+
+private:
+    static constexpr int DITHER_PHASES = 16;
+
+    bool enabled_;
+    bool dither_;
+    uint32_t phase_;
+    // DITHER_PHASES tables of 256 entries (only the first one without dithering)
+    std::vector<uint8_t> tables_;
+};
+
+#endif // OUTPUT_CURVE_H
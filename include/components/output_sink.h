@@ -0,0 +1,21 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <cstdint>
+
+#include "components/frame_scaler.h"  // PixelOrder
+
+// Push-style frame output next to the local display (MatrixDisplay on the Pi,
+// SoftwareMatrixDisplay on the desktop), e.g. NetworkOutputSink driving matrices on
+// other nodes. Runners hand every processed frame to their sinks after processing.
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    virtual bool isReady() const = 0;
+
+    // data is packed 24-bit with row pitch stride (bytes); it is only read during the call
+    virtual void writeFrame(const uint8_t* data, int width, int height, int stride, PixelOrder order) = 0;
+};
+
+#endif // OUTPUT_SINK_H
@@ -5,6 +5,8 @@
 #include <functional>
 #include <opencv2/core.hpp>
 
+#include "components/output_curve.h"
+
 // Desktop-only "software matrix" preview.
 // Mimics the physical matrix by downscaling to (matrix_width x matrix_height) and then upscaling.
 // All frames are expected to be CV_8UC3 in **BGR** order.
@@ -16,6 +18,10 @@ public:
     int getWidth() const;
     int getHeight() const;
 
+    // Preview the hardware output stage (see MatrixDisplay::setOutputCurve): PWM levels,
+    // dither and brightness as the panel would show them, re-encoded for the monitor
+    void setOutputCurve(const OutputCurve::Settings& settings);
+
     // Show what would be displayed on the matrix.
     // Optional overlay_callback is called on the matrix-resolution frame (e.g., 64x64)
     // before upscaling, allowing sharp text/graphics to be drawn.
@@ -33,6 +39,7 @@ private:
     int matrix_w_;
     int matrix_h_;
 
+    OutputCurve curve_;
     cv::Mat matrix_bgr_;
     cv::Mat preview_bgr_;
 };
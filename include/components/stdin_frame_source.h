@@ -0,0 +1,77 @@
+#ifndef STDIN_FRAME_SOURCE_H
+#define STDIN_FRAME_SOURCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "components/frame_source.h"
+
+// Raw, tightly packed 24-bit frames on stdin (rpicam-vid | ffmpeg -f rawvideo -pix_fmt rgb24
+// or bgr24), read with read(2) straight into frame buffers (no iostream layer).
+//
+// LATEST: a reader thread drains the pipe into a triple buffer and read() returns the
+//         newest complete frame, so the pipe never backs up behind LED output and bursts
+//         from the producer are absorbed by skipping stale frames.
+// SEQUENTIAL: every frame, in order, read on the calling thread (for files and replays
+//             where each frame matters).
+// Short reads only continue the current frame; they never cost a frame.
+class StdinFrameSource : public FrameSource {
+public:
+    enum class Mode {
+        LATEST,
+        SEQUENTIAL
+    };
+
+    // order: byte order the producer writes (ffmpeg rgb24 = RGB, bgr24 = BGR)
+    StdinFrameSource(int width, int height, Mode mode = Mode::LATEST, PixelOrder order = PixelOrder::RGB);
+    ~StdinFrameSource() override;
+
+    StdinFrameSource(const StdinFrameSource&) = delete;
+    StdinFrameSource& operator=(const StdinFrameSource&) = delete;
+
+    bool read(FrameView& frame) override;
+
+    // Make a blocked or later read() return false within ~100ms, also on an idle pipe.
+    // Only an atomic store, so it is safe to call from a signal handler.
+    void stop() { running_ = false; }
+
+    uint64_t getFrameCount() const { return frames_read_.load(); }
+    // Complete frames replaced by a newer one before read() got to them (LATEST only)
+    uint64_t getSkippedFrames() const { return frames_skipped_.load(); }
+
+private:
+    // Fill buffer with one whole frame; false on EOF/error or stop
+    bool readFrame(uint8_t* buffer);
+    void readerLoop();
+    void fillView(int slot, FrameView& frame);
+
+    int width_;
+    int height_;
+    size_t frame_size_;
+    Mode mode_;
+    PixelOrder order_;
+
+    // Triple buffer: the reader fills write_slot_, publishes it by swapping it with
+    // shared_slot_, and read() swaps its read_slot_ for shared_slot_ when it is marked new
+    static constexpr int NEW_FRAME = 4;
+    std::vector<uint8_t> slots_[3];
+    uint64_t timestamps_[3];
+    int write_slot_;
+    int read_slot_;
+    std::atomic<int> shared_slot_;  // Slot index | NEW_FRAME
+    std::mutex wake_mutex_;         // Only protects the wait/notify handshake
+    std::condition_variable frame_ready_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> end_of_stream_;
+    std::atomic<uint64_t> frames_read_;
+    std::atomic<uint64_t> frames_skipped_;
+    std::thread reader_thread_;
+};
+
+#endif // STDIN_FRAME_SOURCE_H
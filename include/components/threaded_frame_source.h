@@ -0,0 +1,72 @@
+#ifndef THREADED_FRAME_SOURCE_H
+#define THREADED_FRAME_SOURCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "components/frame_source.h"
+
+// Runs another FrameSource (VideoCapture, replay) on a capture thread, so decoding and
+// driver waits overlap processing instead of adding to it. Frames are copied out of the
+// inner source's buffer into a triple buffer (the same handoff as StdinFrameSource).
+//
+// LATEST: the capture thread never waits; read() returns the newest frame and older
+//         unread ones are skipped (a live camera, like the Pi's drop-oldest pipeline).
+// EVERY_FRAME: the capture thread waits until the previous frame was taken, so every
+//              frame is processed in order with one decoded ahead (video files, replays).
+class ThreadedFrameSource : public FrameSource {
+public:
+    enum class Mode {
+        LATEST,
+        EVERY_FRAME
+    };
+
+    ThreadedFrameSource(std::unique_ptr<FrameSource> source, Mode mode);
+    ~ThreadedFrameSource() override;
+
+    ThreadedFrameSource(const ThreadedFrameSource&) = delete;
+    ThreadedFrameSource& operator=(const ThreadedFrameSource&) = delete;
+
+    // The view keeps the inner source's timestamp
+    bool read(FrameView& frame) override;
+
+    // Steady-clock time (ns) the frame returned by the last read() came out of the inner
+    // source; now minus this is the capture-to-processing latency
+    uint64_t getReadyTimeNs() const { return ready_ns_[read_slot_]; }
+
+    uint64_t getFrameCount() const { return frames_read_.load(); }
+    // Frames replaced by a newer one before read() got to them (LATEST only)
+    uint64_t getSkippedFrames() const { return frames_skipped_.load(); }
+
+private:
+    void captureLoop();
+
+    std::unique_ptr<FrameSource> source_;
+    Mode mode_;
+
+    // The capture thread fills write_slot_ and swaps it into shared_slot_; read() swaps
+    // its read_slot_ for shared_slot_ when it is marked new
+    static constexpr int NEW_FRAME = 4;
+    std::vector<uint8_t> slots_[3];
+    FrameView views_[3];
+    uint64_t ready_ns_[3];
+    int write_slot_;
+    int read_slot_;
+    std::atomic<int> shared_slot_;  // Slot index | NEW_FRAME
+    std::mutex wake_mutex_;         // Only protects the wait/notify handshakes
+    std::condition_variable frame_ready_;
+    std::condition_variable slot_taken_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> end_of_stream_;
+    std::atomic<uint64_t> frames_read_;
+    std::atomic<uint64_t> frames_skipped_;
+    std::thread capture_thread_;
+};
+
+#endif // THREADED_FRAME_SOURCE_H
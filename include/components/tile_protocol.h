@@ -0,0 +1,47 @@
+#ifndef TILE_PROTOCOL_H
+#define TILE_PROTOCOL_H
+
+#include <cstdint>
+
+// UDP wire format between NetworkOutputSink (capture node) and TileReceiver
+// (matrix_receiver on each display node). A frame of one tile is a run of ROWS
+// datagrams, each holding whole rows of RGB565 pixels, followed by one END datagram
+// that tells the receiver to show what it has. Row chunks that did not change since
+// the previous frame are not sent (the receiver keeps them), except on keyframes.
+// Fields are in host byte order: every node is a little-endian Pi or PC.
+constexpr uint32_t TILE_MAGIC = 0x544D5052;  // "RPMT"
+constexpr int TILE_MAX_DATAGRAM = 1400;      // Stays below an Ethernet MTU (no IP fragments)
+// Largest tile side: a whole row still fits one datagram, and a stray datagram can
+// make a receiver allocate at most 512 * 512 * 3 bytes
+constexpr int TILE_MAX_SIDE = 512;
+
+enum class TilePacketType : uint16_t {
+    ROWS = 0,  // row_count rows starting at row_start
+    END = 1    // Frame complete (row fields unused)
+};
+
+struct TilePacketHeader {
+    uint32_t magic;
+    uint32_t session;      // Random per sender start, so receivers resync after a restart
+    uint32_t sequence;     // Frame number (wraps), shared by all tiles of a frame
+    uint16_t tile_index;   // Left to right
+    uint16_t type;         // TilePacketType
+    uint16_t width;        // Tile size in pixels
+    uint16_t height;
+    uint16_t row_start;
+    uint16_t row_count;
+};
+static_assert(sizeof(TilePacketHeader) == 24, "tile packet header must stay 24 bytes");
+
+// Most whole rows of a width-pixel RGB565 tile per datagram (at least 1)
+inline int tileRowsPerPacket(int width) {
+    int rows = static_cast<int>((TILE_MAX_DATAGRAM - sizeof(TilePacketHeader)) / (width * 2));
+    return rows > 0 ? rows : 1;
+}
+
+// True when sequence a was sent after b (modulo wrap-around)
+inline bool tileSequenceAfter(uint32_t a, uint32_t b) {
+    return static_cast<int32_t>(a - b) > 0;
+}
+
+#endif // TILE_PROTOCOL_H
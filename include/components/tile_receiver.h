@@ -0,0 +1,52 @@
+#ifndef TILE_RECEIVER_H
+#define TILE_RECEIVER_H
+
+#include <cstdint>
+#include <vector>
+
+// Display-node side of NetworkOutputSink: reassembles the RGB565 row datagrams of one
+// tile (tile_protocol.h) into a packed RGB frame. Rows that were not resent (unchanged,
+// or lost) keep their previous content; datagrams of older frames are discarded. A new
+// sender session (the capture node restarted) is followed from its first datagram.
+class TileReceiver {
+public:
+    TileReceiver(int port, int tile_index);
+    ~TileReceiver();
+
+    TileReceiver(const TileReceiver&) = delete;
+    TileReceiver& operator=(const TileReceiver&) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    // Read datagrams until a frame completes (true: getData() holds it) or none arrives
+    // for timeout_ms (false)
+    bool receive(int timeout_ms);
+
+    // Packed RGB, getWidth() * getHeight() * 3 bytes (empty until the first datagram)
+    const uint8_t* getData() const { return rgb_.data(); }
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
+
+    uint64_t getFrameCount() const { return frames_; }
+    // Frames the sender numbered but whose end marker never arrived
+    uint64_t getLostFrames() const { return lost_frames_; }
+
+private:
+    void handleRows(const uint8_t* payload, int row_start, int row_count);
+
+    int fd_;
+    int tile_index_;
+    int width_;
+    int height_;
+    bool have_sequence_;      // Following session_
+    uint32_t session_;
+    bool have_shown_;         // last_shown_ is from session_
+    uint32_t sequence_;       // Frame being assembled (or last shown)
+    uint32_t last_shown_;
+    uint64_t frames_;
+    uint64_t lost_frames_;
+    std::vector<uint8_t> rgb_;
+    std::vector<uint8_t> datagram_;
+};
+
+#endif // TILE_RECEIVER_H
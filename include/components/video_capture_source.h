@@ -0,0 +1,25 @@
+#ifndef VIDEO_CAPTURE_SOURCE_H
+#define VIDEO_CAPTURE_SOURCE_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "components/frame_source.h"
+
+// OpenCV VideoCapture (camera device or video file) as a FrameSource; frames are BGR
+class VideoCaptureSource : public FrameSource {
+public:
+    VideoCaptureSource() = default;
+
+    bool openDevice(int device_index, int width, int height);
+    bool openFile(const char* path);
+    bool isOpened() const { return capture_.isOpened(); }
+
+    bool read(FrameView& frame) override;
+
+private:
+    cv::VideoCapture capture_;
+    cv::Mat frame_;
+};
+
+#endif // VIDEO_CAPTURE_SOURCE_H
@@ -0,0 +1,33 @@
+#ifndef DOUBLE_EXPOSURE_EFFECT_H
+#define DOUBLE_EXPOSURE_EFFECT_H
+
+#include <vector>
+
+#include "effects/effect.h"
+
+// Effect 6: the moving foreground blended with the same region from a random 0.5-2.5 s ago
+class DoubleExposureEffect : public IEffect {
+public:
+    // Time offset range in frames; the frame history must be at least MAX_TIME_OFFSET deep
+    static constexpr int MIN_TIME_OFFSET = 15;    // Min 0.5 sec at 30fps
+    static constexpr int MAX_TIME_OFFSET = 75;    // Max 2.5 sec at 30fps
+
+    DoubleExposureEffect();
+
+    uint32_t inputs() const override { return INPUT_CAMERA | INPUT_FG_MASK | INPUT_HISTORY; }
+    void prepare(const cv::Size&) override {}
+    void process(const FrameContext& context, cv::Mat& out) override;
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
+
+private:
+    int frame_counter_;   // Frames since the offset last changed
+    int time_offset_;     // Current random offset (in frames)
+    cv::Mat kernel_;      // 3x3 ellipse, created once
+    cv::Mat past_;        // Decoded past frame (compact history only)
+    cv::Mat mask_;        // Blend mask
+    cv::Mat blended_;
+    cv::Mat output_;
+};
+
+#endif // DOUBLE_EXPOSURE_EFFECT_H
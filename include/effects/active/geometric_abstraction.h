@@ -0,0 +1,22 @@
+#ifndef GEOMETRIC_ABSTRACTION_EFFECT_H
+#define GEOMETRIC_ABSTRACTION_EFFECT_H
+
+#include <vector>
+
+#include "effects/effect.h"
+
+// Effect 9: foreground contours simplified to outlined polygons, coloured by area
+class GeometricAbstractionEffect : public IEffect {
+public:
+    uint32_t inputs() const override { return INPUT_CLEANED; }
+    void prepare(const cv::Size& size) override;
+    void process(const FrameContext& context, cv::Mat& out) override;
+
+private:
+    cv::Scalar hsvToBgr(float h, float s, float v);
+
+    cv::Mat output_;
+    std::vector<cv::Point> approx_;  // Simplified polygon scratch
+};
+
+#endif // GEOMETRIC_ABSTRACTION_EFFECT_H
@@ -0,0 +1,22 @@
+#ifndef MOTION_TRAILS_EFFECT_H
+#define MOTION_TRAILS_EFFECT_H
+
+#include "effects/effect.h"
+
+// Effect 4: filled silhouettes drawn over a fading copy of the previous frames
+class MotionTrailsEffect : public IEffect {
+public:
+    explicit MotionTrailsEffect(float trail_alpha = 0.7f);
+
+    uint32_t inputs() const override { return INPUT_CONTOURS; }
+    void prepare(const cv::Size& size) override;
+    void process(const FrameContext& context, cv::Mat& out) override;
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
+
+private:
+    float trail_alpha_;   // Per-frame decay of the trail image
+    cv::Mat trails_;      // Persistent trail image (CV_8UC3)
+};
+
+#endif // MOTION_TRAILS_EFFECT_H
@@ -0,0 +1,14 @@
+#ifndef PASS_THROUGH_EFFECT_H
+#define PASS_THROUGH_EFFECT_H
+
+#include "effects/effect.h"
+
+// Effect 1: Debug view, the processed camera image unchanged
+class PassThroughEffect : public IEffect {
+public:
+    uint32_t inputs() const override { return INPUT_CAMERA; }
+    void prepare(const cv::Size&) override {}
+    void process(const FrameContext& context, cv::Mat& out) override;
+};
+
+#endif // PASS_THROUGH_EFFECT_H
@@ -0,0 +1,37 @@
+#ifndef RAINBOW_TRAILS_EFFECT_H
+#define RAINBOW_TRAILS_EFFECT_H
+
+#include <vector>
+
+#include "effects/effect.h"
+
+// Effect 5: decaying rainbow-coloured trails behind the moving person, over the camera feed
+class RainbowTrailsEffect : public IEffect {
+public:
+    RainbowTrailsEffect();
+
+    uint32_t inputs() const override { return INPUT_CAMERA | INPUT_CLEANED; }
+    // Ignores smaller blobs than the other effects: every stray contour leaves a trail
+    int minContourArea() const override { return 1500; }
+    void prepare(const cv::Size& size) override;
+    void process(const FrameContext& context, cv::Mat& out) override;
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
+
+private:
+    void initTables();
+
+    // Fixed-point age per pixel (CV_16UC1, Q8.8, 255.0 = just touched)
+    // and tables for the fused decay/gamma/hue/blend kernel
+    static constexpr int RAINBOW_HUES = 180;  // OpenCV 8-bit hue range
+    cv::Mat trail_age_;
+    cv::Mat fg_mask_;                     // Current silhouette, reused every frame
+    std::vector<uint8_t> intensity_row_;  // Rounded 8-bit age of the row being blended
+    cv::Mat output_;
+    float hue_offset_;
+    uint8_t palette_[RAINBOW_HUES * 3];   // BGR at S = V = 255
+    uint16_t trail_weight_[256];  // Q8 palette weight per intensity (gamma * alpha)
+    uint16_t cam_weight_[256];    // Q8 camera weight per intensity (1 - alpha)
+};
+
+#endif // RAINBOW_TRAILS_EFFECT_H
@@ -0,0 +1,25 @@
+#ifndef SILHOUETTE_EFFECT_H
+#define SILHOUETTE_EFFECT_H
+
+#include "effects/effect.h"
+
+// Effects 2 and 3: foreground contours in white on black, filled or as a 2px outline
+class SilhouetteEffect : public IEffect {
+public:
+    enum class Style {
+        FILLED,
+        OUTLINE
+    };
+
+    explicit SilhouetteEffect(Style style);
+
+    uint32_t inputs() const override { return INPUT_CONTOURS; }
+    void prepare(const cv::Size& size) override;
+    void process(const FrameContext& context, cv::Mat& out) override;
+
+private:
+    Style style_;
+    cv::Mat output_;
+};
+
+#endif // SILHOUETTE_EFFECT_H
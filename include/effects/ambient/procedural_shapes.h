@@ -1,12 +1,23 @@
 #ifndef PROCEDURAL_SHAPES_EFFECT_H
 #define PROCEDURAL_SHAPES_EFFECT_H
 
+#include <cstdint>
 #include <vector>
 #include <opencv2/core.hpp>
 
-class ProceduralShapesEffect {
+#include "effects/effect.h"
+
+// Effect 7: generated without reading the camera image
+class ProceduralShapesEffect : public IEffect {
 public:
-    explicit ProceduralShapesEffect(int width, int height);
+    explicit ProceduralShapesEffect(int width = 0, int height = 0);
+
+    // IEffect: renders at the context size into an owned buffer
+    uint32_t inputs() const override { return 0; }
+    void prepare(const cv::Size& size) override;
+    void process(const FrameContext& context, cv::Mat& out) override;
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
 
     void reset();
     void process(cv::Mat& out_bgr, int target_width = -1, int target_height = -1);
@@ -14,13 +25,13 @@ public:
 private:
     // Helper functions
     cv::Scalar hsvToBgr(float h, float s, float v);
-    void drawMorphingShape(cv::Mat& img, int cx, int cy, int radius,
-                          int shape_type, float morph_progress, cv::Scalar color,
-                          float fill_mode);
+    void updateShapeStamp(int radius, int shape_type, float morph_progress, float fill_mode);
+    void stampShape(cv::Mat& img, int cx, int cy, const cv::Scalar& color);
     std::vector<cv::Point> getShapePoints(int shape_type, int cx, int cy, int radius);
 
     int width_;
     int height_;
+    cv::Mat output_;  // IEffect output
 
     // Procedural shapes state
     int procedural_frame_counter_;
@@ -30,6 +41,14 @@ private:
     float hue_shift_;
     float fill_mode_progress_;  // 0.0 = outline only, 1.0 = filled
     float color_morph_progress_;  // For color morphing
+
+    // Shape stamp shared by every tile of a frame (CV_8UC1, 255 = shape pixel)
+    cv::Mat stamp_;
+    cv::Point stamp_origin_;                 // Stamp pixel of the tile centre
+    std::vector<cv::Point> stamp_points_;    // Morphed outline the stamp was drawn from
+    bool stamp_filled_ = false;
+    int stamp_thickness_ = 0;
+    std::vector<cv::Point> morph_points_;    // Scratch for the current outline
 };
 
 #endif // PROCEDURAL_SHAPES_EFFECT_H
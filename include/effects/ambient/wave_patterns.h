@@ -1,11 +1,23 @@
 #ifndef WAVE_PATTERNS_EFFECT_H
 #define WAVE_PATTERNS_EFFECT_H
 
+#include <cstdint>
+#include <vector>
 #include <opencv2/core.hpp>
 
-class WavePatternsEffect {
+#include "effects/effect.h"
+
+// Effect 8: generated without reading the camera image
+class WavePatternsEffect : public IEffect {
 public:
-    explicit WavePatternsEffect(int width, int height);
+    explicit WavePatternsEffect(int width = 0, int height = 0);
+
+    // IEffect: renders at the context size into an owned buffer
+    uint32_t inputs() const override { return 0; }
+    void prepare(const cv::Size& size) override;
+    void process(const FrameContext& context, cv::Mat& out) override;
+    void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const override;
+    void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) override;
 
     void reset();
     void process(cv::Mat& out_bgr, int target_width = -1, int target_height = -1);
@@ -15,10 +27,20 @@ private:
 
     int width_;
     int height_;
+    cv::Mat output_;  // IEffect output
 
     // Wave patterns state
     float wave_time_;
     float wave_phase_;
+
+    // Per-frame wave tables (sized to the output width) and the per-row Q8 brightness
+    std::vector<float> col_wave_;   // sin(fx + t)
+    std::vector<float> col_sin3_;   // sin(0.07 fx + phase)
+    std::vector<float> col_cos3_;   // cos(0.07 fx + phase)
+    std::vector<int32_t> row_brightness_;
+
+    static constexpr int PALETTE_HUES = 360;
+    uint8_t palette_[PALETTE_HUES * 3];  // BGR at S = V = 1, one entry per degree
 };
 
 #endif // WAVE_PATTERNS_EFFECT_H
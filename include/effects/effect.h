@@ -0,0 +1,90 @@
+#ifndef EFFECT_H
+#define EFFECT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+#include "app/frame_history.h"
+#include "app/segmentation_stage.h"
+
+class StateCheckpoint;
+
+// Everything an effect may read for one frame of one processing context (the full
+// frame, or one panel). input is a region of the frame that segmentation and history
+// were computed on; roi locates it there, so panels share those stages.
+struct FrameContext {
+    cv::Mat input;                      // CV_8UC3 BGR view at processing resolution
+    SegmentationStage* segmentation;    // Segmentation of the frame input is cut from
+    const FrameHistory* history;        // Past frames of that frame (already holds this one)
+    cv::Rect roi;                       // input's rectangle in segmentation's/history's frame
+    uint64_t sequence;                  // Frame sequence number
+    int panel_index;                    // -1 for the full frame
+    int min_contour_area;               // Contour area threshold at processing resolution
+    double area_scale;                  // Processing / input pixel count
+
+    // Foreground contours inside roi (ROI-relative points), cached per frame
+    const std::vector<std::vector<cv::Point>>& contours(bool cleaned) const;
+    // Raw foreground mask restricted to roi (a view)
+    cv::Mat foregroundMask() const;
+
+    // Detection parameters are tuned for input resolution; these rescale them
+    // to the processing resolution
+    double scaledLength(double length) const;
+    int scaledKernelSize(int size) const;
+    // The same for stages outside any context (AppCore's segmentation cleanup)
+    static int scaledKernelSize(int size, double area_scale);
+};
+
+// Uniform interface for every display effect. One instance renders one context, so
+// per-effect state (trail buffers, animation clocks) lives in the instance and each
+// panel gets its own. Instances of different panels run in parallel; everything they
+// read from FrameContext is computed beforehand according to inputs().
+class IEffect {
+public:
+    // inputs() flags
+    static constexpr uint32_t INPUT_CAMERA = 1u << 0;    // Reads the input pixels
+    static constexpr uint32_t INPUT_FG_MASK = 1u << 1;   // Raw foreground mask
+    static constexpr uint32_t INPUT_CONTOURS = 1u << 2;  // Contours on the raw mask
+    static constexpr uint32_t INPUT_CLEANED = 1u << 3;   // Contours on the cleaned mask
+    static constexpr uint32_t INPUT_HISTORY = 1u << 4;   // Past frames
+    // Any flag that needs the segmentation stage (MOG2)
+    static constexpr uint32_t INPUT_SEGMENTATION = INPUT_FG_MASK | INPUT_CONTOURS | INPUT_CLEANED;
+
+    virtual ~IEffect() = default;
+
+    // Fixed for the effect type; decides which shared stages run for it
+    virtual uint32_t inputs() const = 0;
+
+    // Called before the first process() and whenever the context size changes;
+    // (re)allocates size-dependent state
+    virtual void prepare(const cv::Size& size) = 0;
+
+    // Render one frame. out is set to the result: an instance-owned buffer or a view of
+    // context.input, valid until the next process() call on this instance.
+    virtual void process(const FrameContext& context, cv::Mat& out) = 0;
+
+    // Contour area threshold on the full-frame path, at input resolution (AppCore scales it
+    // to the processing resolution). Panels use a fixed smaller threshold.
+    virtual int minContourArea() const { return 1000; }
+
+    // Warm-state checkpoint (AppCore --state-file): write/read the state worth keeping
+    // across restarts (trail buffers, animation clocks) under keys starting with prefix.
+    // loadState() runs after prepare() and skips entries that don't match the new size.
+    // Stateless effects keep the defaults.
+    virtual void saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+        (void)checkpoint;
+        (void)prefix;
+    }
+    virtual void loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+        (void)checkpoint;
+        (void)prefix;
+    }
+};
+
+// Draw every contour by index (no per-contour vector-of-vectors copy)
+void drawAllContours(cv::Mat& img, const std::vector<std::vector<cv::Point>>& contours,
+                     const cv::Scalar& color, int thickness);
+
+#endif // EFFECT_H
@@ -0,0 +1,45 @@
+#ifndef EFFECT_REGISTRY_H
+#define EFFECT_REGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "effects/effect.h"
+
+// Effect id -> factory. AppCore creates one instance per processing context (the full
+// frame and each panel) from here, so the single-effect and multi-panel paths run the
+// same code. Ids are the Effect enum values. Register before processing starts;
+// lookups are not synchronised against registration.
+class EffectRegistry {
+public:
+    using Factory = std::function<std::unique_ptr<IEffect>()>;
+
+    // Registry holding every built-in effect
+    static EffectRegistry& instance();
+
+    // Add an effect, or replace the one with this id
+    void registerEffect(int id, const std::string& name, Factory factory);
+
+    bool contains(int id) const;
+    // New instance, or nullptr for an unknown id
+    std::unique_ptr<IEffect> create(int id) const;
+    // The effect's IEffect::inputs() (0 for an unknown id)
+    uint32_t getInputs(int id) const;
+    const char* getName(int id) const;
+    std::vector<int> getIds() const;
+
+private:
+    struct Entry {
+        std::string name;
+        uint32_t inputs;
+        Factory factory;
+    };
+
+    std::map<int, Entry> entries_;
+};
+
+#endif // EFFECT_REGISTRY_H
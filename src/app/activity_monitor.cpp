@@ -0,0 +1,42 @@
+#include "app/activity_monitor.h"
+
+#include <opencv2/imgproc.hpp>
+
+ActivityMonitor::ActivityMonitor(int pixel_threshold)
+    : pixel_threshold_(pixel_threshold),
+      last_score_(0.0) {
+}
+
+void ActivityMonitor::reset() {
+    prev_luma_.release();
+    last_score_ = 0.0;
+}
+
+void ActivityMonitor::keepLatestAsReference() {
+    if (!luma_.empty()) {
+        luma_.copyTo(prev_luma_);
+    }
+}
+
+double ActivityMonitor::update(const cv::Mat& frame_bgr, bool advance) {
+    if (frame_bgr.empty()) return last_score_;
+
+    // Averaging down to the probe size also filters out sensor noise
+    cv::resize(frame_bgr, small_bgr_, cv::Size(PROBE_WIDTH, PROBE_HEIGHT), 0, 0, cv::INTER_AREA);
+    cv::cvtColor(small_bgr_, luma_, cv::COLOR_BGR2GRAY);
+
+    if (prev_luma_.empty()) {
+        luma_.copyTo(prev_luma_);
+        last_score_ = 0.0;
+        return last_score_;
+    }
+
+    cv::absdiff(luma_, prev_luma_, diff_);
+    cv::threshold(diff_, diff_, pixel_threshold_, 255, cv::THRESH_BINARY);
+    last_score_ = static_cast<double>(cv::countNonZero(diff_)) / (PROBE_WIDTH * PROBE_HEIGHT);
+
+    if (advance) {
+        cv::swap(luma_, prev_luma_);
+    }
+    return last_score_;
+}
@@ -1,30 +1,40 @@
 #include "app/app_core.h"
+#include "app/frame_alloc_tracker.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <future>
+#include <memory>
 #include <iostream>
+#include <opencv2/core/utility.hpp>
 #include <opencv2/imgproc.hpp>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
 AppCore::AppCore(int width, int height, int num_panels)
     : width_(width),
       height_(height),
-      num_panels_(num_panels),
-      background_subtractor_(cv::createBackgroundSubtractorMOG2(500, 16, true)) {
-    silhouette_frame_ = cv::Mat::zeros(height_, width_, CV_8UC3);
-    trail_age_buffer_ = cv::Mat::zeros(height_, width_, CV_32FC1);  // Float buffer for age tracking
+      num_panels_(num_panels) {
+    allocateFrameBuffers();
 
     // Initialize panel effects to default (resources created lazily)
     for (int i = 0; i < num_panels_; i++) {
         panel_effects_[i].store(1);  // Default to pass-through
     }
+    frame_context_.state_prefix = "frame/";
+}
 
-    // Initialize effect classes
-    procedural_shapes_effect_ = std::make_unique<ProceduralShapesEffect>(width_, height_);
-    wave_patterns_effect_ = std::make_unique<WavePatternsEffect>(width_, height_);
+AppCore::~AppCore() {
+    if (!state_path_.empty()) {
+        saveState();
+    }
+    if (history_thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(history_mutex_);
+            history_thread_stop_ = true;
+        }
+        history_wake_.notify_one();
+        history_thread_.join();
+    }
 }
 
 void AppCore::setSystemMode(SystemMode mode) {
@@ -65,11 +75,54 @@ int AppCore::getPanelEffect(int panel_index) const {
 }
 
 void AppCore::ensureSize(int w, int h) {
-    if (w == width_ && h == height_ && !silhouette_frame_.empty()) return;
+    if (w == width_ && h == height_ && !multi_panel_output_.empty()) return;
     width_ = w;
     height_ = h;
-    silhouette_frame_ = cv::Mat::zeros(height_, width_, CV_8UC3);
-    trail_age_buffer_ = cv::Mat::zeros(height_, width_, CV_32FC1);
+    allocateFrameBuffers();
+}
+
+void AppCore::allocateFrameBuffers() {
+    // Effects size their own buffers in IEffect::prepare(); only the composite is shared
+    multi_panel_output_.create(height_, width_, CV_8UC3);
+}
+
+void AppCore::setProcessingSize(int width, int height) {
+    if (width > 0 && height > 0) {
+        processing_width_ = width;
+        processing_height_ = height;
+    } else {
+        processing_width_ = 0;
+        processing_height_ = 0;
+    }
+}
+
+const cv::Mat& AppCore::downscaleInput(const cv::Mat& in_bgr, bool read_pixels) {
+    // Configured processing size (or the input size), reduced by the quality governor
+    cv::Size size = processing_width_ > 0 && processing_height_ > 0
+                        ? cv::Size(processing_width_, processing_height_) : in_bgr.size();
+    if (governor_scale_ < 1.0) {
+        size = cv::Size(std::max(1, static_cast<int>(size.width * governor_scale_)),
+                        std::max(1, static_cast<int>(size.height * governor_scale_)));
+    }
+    if (size == in_bgr.size()) {
+        area_scale_ = 1.0;
+        return in_bgr;
+    }
+
+    // Single downscale for the whole frame; INTER_AREA averages instead of skipping pixels.
+    // When no effect reads pixels only the size matters, so the buffer is left as is.
+    if (read_pixels) {
+        cv::resize(in_bgr, processing_frame_, size, 0, 0, cv::INTER_AREA);
+    } else {
+        processing_frame_.create(size, CV_8UC3);
+    }
+    area_scale_ = static_cast<double>(size.width) * size.height /
+                  (static_cast<double>(in_bgr.cols) * in_bgr.rows);
+    return processing_frame_;
+}
+
+int AppCore::scaledArea(int area) const {
+    return static_cast<int>(area * area_scale_);
 }
 
 void AppCore::setMultiPanelEnabled(bool enabled) {
@@ -84,754 +137,667 @@ PanelMode AppCore::getPanelMode() const {
     return static_cast<PanelMode>(panel_mode_.load());
 }
 
-void AppCore::processFrame(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    if (in_bgr.empty()) return;
-    ensureSize(in_bgr.cols, in_bgr.rows);
-
-    // Update auto-cycling
-    updateAutoCycling();
-
-    // Check if we need special multi-panel processing
-    // This happens when:
-    // 1. Multi-panel mode is explicitly enabled (different effects per panel), OR
-    // 2. We have multiple panels AND panel mode is REPEAT (same view, potentially different effects)
-    bool use_multi_panel = multi_panel_enabled_.load() ||
-                          (num_panels_ > 1 && getPanelMode() == PanelMode::REPEAT);
-
-    if (use_multi_panel) {
-        processMultiPanel(in_bgr, out_bgr);
-        return;
+void AppCore::setAllocationCheck(bool enabled) {
+    if (enabled) {
+        FrameAllocTracker::instance().install();
     }
+    alloc_check_enabled_ = enabled;
+}
 
-    // Get current system mode and effect
-    SystemMode current_mode = getSystemMode();
-    Effect current_effect = getEffect();
+void AppCore::setHistoryFormat(FrameHistory::Format format) {
+    frame_history_.setFormat(format);
+    repeat_history_.setFormat(format);
+}
 
-    // Validate effect is allowed in current mode, and adjust if necessary
-    bool effect_valid = isEffectValidForMode(current_effect, current_mode);
-    if (!effect_valid) {
-        // Set to a valid default effect for this mode
-        current_effect = getDefaultEffectForMode(current_mode);
-        setEffect(current_effect);
+void AppCore::setBackgroundModel(BackgroundModel::Type type) {
+    // One model per segmentation stage: each learns its own frame
+    background_model_type_ = type;
+    segmentation_.setBackgroundModel(BackgroundModel::create(type));
+    repeat_segmentation_.setBackgroundModel(BackgroundModel::create(type));
+    if (!restored_state_.empty()) {
+        segmentation_.loadState(restored_state_, segmentationStatePrefix("segmentation"));
+        repeat_segmentation_.loadState(restored_state_, segmentationStatePrefix("repeat_segmentation"));
     }
+}
 
-    // Process based on current effect
-    processEffect(current_effect, in_bgr, out_bgr);
+void AppCore::setSegmentationRate(int interval, double change_threshold) {
+    segmentation_.setRefreshPolicy(interval, change_threshold);
+    repeat_segmentation_.setRefreshPolicy(interval, change_threshold);
 }
 
-bool AppCore::isEffectValidForMode(Effect effect, SystemMode mode) const {
-    // All effects are now valid in all modes
-    return true;
+std::string AppCore::segmentationStatePrefix(const char* name) const {
+    // Per backend: a checkpoint written with another --bg-model is ignored, not misread
+    return std::string(name) + "/" + BackgroundModel::getTypeName(background_model_type_) + "/";
 }
 
-Effect AppCore::getDefaultEffectForMode(SystemMode mode) const {
-    switch (mode) {
-        case SystemMode::AMBIENT:
-            return Effect::PROCEDURAL_SHAPES;  // Default to Procedural Shapes
-        case SystemMode::ACTIVE:
-            return Effect::FILLED_SILHOUETTE;  // Default to Filled Silhouette
-        default:
-            return Effect::DEBUG;  // Fallback
+void AppCore::setStateFile(const std::string& path, double interval_seconds) {
+    state_path_ = path;
+    state_interval_seconds_ = std::max(1.0, interval_seconds);
+    last_state_save_ = std::chrono::steady_clock::now();
+
+    if (!restored_state_.load(path)) {
+        std::cout << "[STATE] No checkpoint restored from " << path << ", starting cold" << std::endl;
+        return;
+    }
+    segmentation_.loadState(restored_state_, segmentationStatePrefix("segmentation"));
+    repeat_segmentation_.loadState(restored_state_, segmentationStatePrefix("repeat_segmentation"));
+    std::cout << "[STATE] Restored " << restored_state_.size() << " entries from " << path << std::endl;
+}
+
+void AppCore::collectState(StateCheckpoint& checkpoint) const {
+    // Start from what was restored so effects not shown this run keep their state
+    // (the copy shares restored_state_'s matrices, which are never written again)
+    checkpoint = restored_state_;
+    segmentation_.saveState(checkpoint, segmentationStatePrefix("segmentation"));
+    repeat_segmentation_.saveState(checkpoint, segmentationStatePrefix("repeat_segmentation"));
+    auto save_context = [&checkpoint](const ProcessingContext& context) {
+        for (const auto& entry : context.instances) {
+            if (entry.second.effect && !entry.second.size.empty()) {
+                entry.second.effect->saveState(checkpoint,
+                                               context.state_prefix + std::to_string(entry.first) + "/");
+            }
+        }
+    };
+    save_context(frame_context_);
+    for (const ProcessingContext& context : panel_contexts_) {
+        save_context(context);
     }
 }
 
-SystemMode AppCore::getAppropriateModeForEffect(Effect effect) const {
-    switch (effect) {
-        case Effect::PROCEDURAL_SHAPES:
-        case Effect::WAVE_PATTERNS:
-            return SystemMode::AMBIENT;
-        case Effect::DEBUG:
-            // Debug effect doesn't change mode - keep current mode
-            return getSystemMode();
-        default:
-            return SystemMode::ACTIVE;
+bool AppCore::saveState() {
+    if (state_path_.empty()) return false;
+    last_state_save_ = std::chrono::steady_clock::now();
+    if (state_save_.valid()) {
+        state_save_.get();  // Both write path + ".tmp"
     }
+
+    StateCheckpoint checkpoint;
+    collectState(checkpoint);
+    return checkpoint.save(state_path_);
 }
 
-void AppCore::processEffect(Effect effect, const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    // If in transition, we need to render both old and new effects
-    if (transition_frames_remaining_ > 0) {
-        // For now, keep the old transition logic but adapt it to effects
-        // This would need more work to properly handle effect transitions
-        // For simplicity, just render the current effect
-        transition_frames_remaining_ = 0;  // Disable transitions for now
+void AppCore::saveStateInBackground() {
+    // On an SD card msync can take hundreds of ms; if the last write is still going,
+    // try again on the next frame rather than wait for it
+    if (state_save_.valid()) {
+        if (state_save_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        state_save_.get();
     }
+    last_state_save_ = std::chrono::steady_clock::now();
 
-    // Process the current effect
-    switch (effect) {
-        case Effect::DEBUG:
-            processPassThrough(in_bgr, out_bgr);
-            break;
-        case Effect::FILLED_SILHOUETTE:
-            processFilledSilhouette(in_bgr, out_bgr);
-            break;
-        case Effect::OUTLINE_ONLY:
-            processOutline(in_bgr, out_bgr);
-            break;
-        case Effect::MOTION_TRAILS:
-            processMotionTrails(in_bgr, out_bgr);
-            break;
-        case Effect::RAINBOW_MOTION_TRAILS:
-            processRainbowTrails(in_bgr, out_bgr);
-            break;
-        case Effect::DOUBLE_EXPOSURE:
-            processDoubleExposure(in_bgr, out_bgr);
-            break;
-        case Effect::PROCEDURAL_SHAPES:
-            if (procedural_shapes_effect_) {
-                procedural_shapes_effect_->process(out_bgr, width_, height_);
-            }
-            break;
-        case Effect::WAVE_PATTERNS:
-            if (wave_patterns_effect_) {
-                wave_patterns_effect_->process(out_bgr, width_, height_);
-            }
-            break;
-        case Effect::GEOMETRIC_ABSTRACTION:
-            processGeometricAbstraction(in_bgr, out_bgr);
-            break;
-        default:
-            processPassThrough(in_bgr, out_bgr);
-            break;
-    }
+    // The snapshot (a few hundred KB of copies) is the only part on the frame thread
+    std::shared_ptr<StateCheckpoint> checkpoint = std::make_shared<StateCheckpoint>();
+    collectState(*checkpoint);
+    state_save_ = std::async(std::launch::async, [checkpoint, path = state_path_]() {
+        return checkpoint->save(path);
+    });
 }
 
-void AppCore::processPassThrough(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    out_bgr = in_bgr; // shallow copy ok; display should not mutate
+void AppCore::setQualityGovernor(double target_fps, float target_temp_c,
+                                 std::function<float()> temperature) {
+    governor_.configure(target_fps, target_temp_c);
+    temperature_source_ = std::move(temperature);
+    applyQualityLevel(governor_.getLevel());
 }
 
-static void findPersonContours(const cv::Mat& fg_mask,
-                               std::vector<std::vector<cv::Point>>& contours_out,
-                               int min_contour_area) {
-    std::vector<cv::Vec4i> hierarchy;
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(fg_mask, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-
-    contours_out.clear();
-    contours_out.reserve(contours.size());
-    for (const auto& c : contours) {
-        if (cv::contourArea(c) > min_contour_area) contours_out.push_back(c);
+void AppCore::updateGovernor(double process_ms) {
+    float temperature = temperature_source_ ? temperature_source_() : 0.0f;
+    int previous = governor_.getLevel();
+    if (!governor_.update(process_ms, temperature)) return;
+
+    int level = governor_.getLevel();
+    std::cout << "[GOVERNOR] Quality level " << previous << " -> " << level << " ("
+              << (level > previous ? "adds " : "drops ")
+              << QualityGovernor::describeLevel(std::max(level, previous))
+              << "; process " << governor_.getAverageProcessMs() << "ms";
+    if (temperature > 0.0f) {
+        std::cout << ", " << temperature << "C";
     }
+    std::cout << ")" << std::endl;
+    applyQualityLevel(level);
 }
 
-void AppCore::processFilledSilhouette(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    cv::Mat fg_mask;
-    background_subtractor_->apply(in_bgr, fg_mask);
+void AppCore::applyQualityLevel(int level) {
+    // Each level keeps the steps of the levels below it (QualityGovernor::describeLevel())
+    int slowdown = level >= 1 ? 2 : 1;
+    segmentation_.setModelUpdateSlowdown(slowdown);
+    repeat_segmentation_.setModelUpdateSlowdown(slowdown);
 
-    std::vector<std::vector<cv::Point>> contours;
-    findPersonContours(fg_mask, contours, /*min_contour_area=*/1000);
+    // Epsilon in processing-resolution pixels; the outline stays within a pixel
+    double epsilon = level >= 2 ? 1.0 : 0.0;
+    segmentation_.setContourEpsilon(epsilon);
+    repeat_segmentation_.setContourEpsilon(epsilon);
 
-    out_bgr = cv::Mat::zeros(in_bgr.rows, in_bgr.cols, CV_8UC3);
-    for (const auto& c : contours) {
-        cv::drawContours(out_bgr, std::vector<std::vector<cv::Point>>{c}, -1,
-                         cv::Scalar(255, 255, 255), cv::FILLED);
+    int depth = level >= 3 ? DoubleExposureEffect::MAX_TIME_OFFSET / 2 : DoubleExposureEffect::MAX_TIME_OFFSET;
+    frame_history_.setCapacity(depth);
+    repeat_history_.setCapacity(depth);
+
+    // Resolution last: it restarts the background model and history at the new size
+    governor_scale_ = level >= 5 ? 0.5 : (level >= 4 ? 0.75 : 1.0);
+}
+
+void AppCore::setAutoModeSwitching(bool enabled) {
+    if (enabled && !auto_mode_enabled_) {
+        activity_monitor_.reset();
+        active_streak_ = 0;
+        last_activity_time_ = std::chrono::steady_clock::now();
     }
+    auto_mode_enabled_ = enabled;
+}
+
+void AppCore::setActivityThresholds(double active_threshold, double idle_threshold) {
+    active_threshold_ = active_threshold;
+    // Hysteresis: staying active must never need more activity than becoming active
+    idle_threshold_ = std::min(idle_threshold, active_threshold);
 }
 
-void AppCore::processOutline(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    cv::Mat fg_mask;
-    background_subtractor_->apply(in_bgr, fg_mask);
+void AppCore::setIdleTimeout(double seconds) {
+    idle_timeout_seconds_ = std::max(0.0, seconds);
+}
 
-    std::vector<std::vector<cv::Point>> contours;
-    findPersonContours(fg_mask, contours, /*min_contour_area=*/1000);
+void AppCore::observeActivity(const cv::Mat& in_bgr) {
+    if (!auto_mode_enabled_) return;
+    double score = activity_monitor_.update(in_bgr);
+    updateAutoMode(score);
+}
 
-    out_bgr = cv::Mat::zeros(in_bgr.rows, in_bgr.cols, CV_8UC3);
-    for (const auto& c : contours) {
-        cv::drawContours(out_bgr, std::vector<std::vector<cv::Point>>{c}, -1,
-                         cv::Scalar(255, 255, 255), /*thickness=*/2);
+void AppCore::updateAutoMode(double score) {
+    auto now = std::chrono::steady_clock::now();
+    if (score >= idle_threshold_) {
+        last_activity_time_ = now;
     }
+
+    SystemMode mode = getSystemMode();
+    SystemMode new_mode = mode;
+    if (mode == SystemMode::AMBIENT) {
+        // A few consecutive frames above the (higher) active threshold, so a single noisy
+        // frame or a flicker does not wake the pipeline
+        active_streak_ = (score >= active_threshold_) ? active_streak_ + 1 : 0;
+        if (active_streak_ >= ACTIVATE_FRAMES) {
+            new_mode = SystemMode::ACTIVE;
+        }
+    } else {
+        active_streak_ = 0;
+        double idle_seconds = std::chrono::duration<double>(now - last_activity_time_).count();
+        if (idle_seconds >= idle_timeout_seconds_) {
+            new_mode = SystemMode::AMBIENT;
+        }
+    }
+    if (new_mode == mode) return;
+
+    Effect effect = getDefaultEffectForMode(new_mode);
+    setSystemMode(new_mode);
+    setEffect(effect);
+    active_streak_ = 0;
+    last_activity_time_ = now;
+
+    const char* mode_names[] = {"Ambient", "Active"};
+    std::cout << "[AUTO-MODE] Activity " << static_cast<int>(score * 100.0 + 0.5) << "% -> "
+              << mode_names[static_cast<int>(new_mode)] << " mode (effect "
+              << static_cast<int>(effect) << ")" << std::endl;
+}
+
+void AppCore::processFrame(const cv::Mat& in_frame, cv::Mat& out_bgr) {
+    runFrame(in_frame, out_bgr, /*camera_input=*/true);
 }
 
-void AppCore::processMotionTrails(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    cv::Mat fg_mask;
-    background_subtractor_->apply(in_bgr, fg_mask);
+void AppCore::runFrame(const cv::Mat& in_frame, cv::Mat& out_bgr, bool camera_input) {
+    if (in_frame.empty()) return;
+    uint64_t before = alloc_check_enabled_ ? FrameAllocTracker::instance().getAllocationCount() : 0;
+    auto start = std::chrono::steady_clock::now();
 
-    std::vector<std::vector<cv::Point>> contours;
-    findPersonContours(fg_mask, contours, /*min_contour_area=*/1000);
+    processFrameStages(in_frame, out_bgr, camera_input);
 
-    silhouette_frame_ *= trail_alpha_;
-    for (const auto& c : contours) {
-        cv::drawContours(silhouette_frame_, std::vector<std::vector<cv::Point>>{c}, -1,
-                         cv::Scalar(255, 255, 255), cv::FILLED);
+    if (governor_.isEnabled()) {
+        updateGovernor(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
     }
-    out_bgr = silhouette_frame_;
+    if (!state_path_.empty() && std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - last_state_save_).count() >= state_interval_seconds_) {
+        saveStateInBackground();
+    }
+    if (!alloc_check_enabled_) return;
+
+    uint64_t allocations = FrameAllocTracker::instance().getAllocationCount() - before;
+
+    // Only report changes so a steady state stays quiet; the first frames after an
+    // effect switch are expected to allocate that effect's buffers
+    if (allocations != last_frame_allocations_) {
+        std::cout << "[ALLOC] Frame " << frame_sequence_ << ": " << allocations
+                  << " cv::Mat allocation(s)" << std::endl;
+    }
+    last_frame_allocations_ = allocations;
+}
+
+int AppCore::resolveEffectId(int effect) {
+    return EffectRegistry::instance().contains(effect) ? effect : static_cast<int>(Effect::DEBUG);
 }
 
-void AppCore::processRainbowTrails(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    // Detect current foreground (moving person)
-    cv::Mat fg_mask;
-    background_subtractor_->apply(in_bgr, fg_mask);
-    
-    // Apply morphological operations to reduce noise (removes small facial feature detections)
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
-    cv::morphologyEx(fg_mask, fg_mask, cv::MORPH_OPEN, kernel);  // Remove small noise
-    cv::morphologyEx(fg_mask, fg_mask, cv::MORPH_CLOSE, kernel); // Fill small holes
-    
-    std::vector<std::vector<cv::Point>> contours;
-    findPersonContours(fg_mask, contours, /*min_contour_area=*/1500);  // Increased from 1000
-    
-    // Create mask for current foreground
-    cv::Mat current_fg_mask = cv::Mat::zeros(in_bgr.rows, in_bgr.cols, CV_8UC1);
-    for (const auto& c : contours) {
-        cv::drawContours(current_fg_mask, std::vector<std::vector<cv::Point>>{c}, -1,
-                        cv::Scalar(255), cv::FILLED);
+// Effects without INPUT_CAMERA (procedural shapes, wave patterns) never read the frame
+static bool effectReadsInput(int effect) {
+    return (EffectRegistry::instance().getInputs(effect) & IEffect::INPUT_CAMERA) != 0;
+}
+
+bool AppCore::needsCameraInput() const {
+    // Mirrors the routing in processFrameStages() / processMultiPanel()
+    PanelMode mode = getPanelMode();
+    bool use_multi_panel = multi_panel_enabled_.load() ||
+                          (num_panels_ > 1 && mode == PanelMode::REPEAT);
+    if (!use_multi_panel) {
+        return effectReadsInput(resolveEffectId(static_cast<int>(getEffect())));
     }
-    
-    // Decay existing trails slower for longer-lasting effect
-    trail_age_buffer_ *= 0.93f;  // Increased from 0.88 (slower decay = longer trails)
-    
-    // Add new motion to trail buffer (full brightness)
-    trail_age_buffer_.setTo(255.0f, current_fg_mask);
-    
-    // Convert trail age buffer to 8-bit for processing
-    cv::Mat trail_intensity;
-    trail_age_buffer_.convertTo(trail_intensity, CV_8UC1);
-    
-    // Higher threshold to remove more noise
-    cv::threshold(trail_intensity, trail_intensity, 20, 255, cv::THRESH_TOZERO);  // Increased from 10
-    
-    // Create HSV image for rainbow effect
-    // Strategy: Use trail intensity for both hue variation AND brightness
-    // - Hue: cycles through rainbow (time-based + spatial variation)
-    // - Saturation: full (255)
-    // - Value: based on trail intensity (brighter = more recent)
-    cv::Mat trail_hsv = cv::Mat::zeros(in_bgr.rows, in_bgr.cols, CV_8UC3);
-    
-    // Create dynamic hue map (time-based cycling for animation effect)
-    static float hue_offset = 0.0f;
-    hue_offset = fmod(hue_offset + 3.0f, 180.0f);  // Faster animation (was 2.0)
-    
-    // Vectorized operation: create hue based on intensity + position
-    for (int y = 0; y < trail_intensity.rows; y++) {
-        uint8_t* intensity_row = trail_intensity.ptr<uint8_t>(y);
-        cv::Vec3b* hsv_row = trail_hsv.ptr<cv::Vec3b>(y);
-        
-        for (int x = 0; x < trail_intensity.cols; x++) {
-            uint8_t intensity = intensity_row[x];
-            if (intensity > 20) {  // Match new threshold
-                // Multi-color rainbow effect:
-                // - Base hue from position for spatial variation
-                // - Animated with time offset
-                // - Intensity affects brightness (V channel)
-                float base_hue = fmod((x * 0.5f + y * 0.4f + hue_offset), 180.0f);  // More variation (was 0.3, 0.2)
-                uint8_t hue = static_cast<uint8_t>(base_hue);
-                uint8_t saturation = 255;  // Full saturation for vivid colors
-                
-                // Boost brightness for more dramatic effect (gamma correction)
-                float normalized = intensity / 255.0f;
-                float boosted = std::pow(normalized, 0.7f);  // Gamma < 1 = brighter
-                uint8_t value = cv::saturate_cast<uint8_t>(boosted * 255.0f);
-                
-                hsv_row[x] = cv::Vec3b(hue, saturation, value);
-            }
+
+    if (mode == PanelMode::REPEAT) {
+        std::vector<Effect> valid_effects = getValidEffectsForMode(getSystemMode());
+        if (valid_effects.empty()) return true;  // DEBUG fallback
+        int offset = repeat_cycle_offset_.load();
+        for (int i = 0; i < num_panels_; i++) {
+            if (effectReadsInput(static_cast<int>(valid_effects[(i + offset) % valid_effects.size()]))) return true;
         }
+        return false;
     }
-    
-    // Convert HSV to BGR (vectorized operation)
-    cv::Mat trail_colored;
-    cv::cvtColor(trail_hsv, trail_colored, cv::COLOR_HSV2BGR);
-    
-    // Start with camera feed
-    out_bgr = in_bgr.clone();
-    
-    // Create inverse mask (where trails SHOULD appear - not on current person)
-    cv::Mat trail_mask;
-    cv::bitwise_not(current_fg_mask, trail_mask);
-    
-    // Apply alpha blending based on trail intensity (opacity from intensity)
-    // Brighter trails = more opaque, fading trails = more transparent
-    cv::Mat trail_alpha_float;
-    trail_age_buffer_.convertTo(trail_alpha_float, CV_32FC1, 1.0 / 255.0);  // 0.0 to 1.0
-    
-    // Blend trails onto output using vectorized operation
-    for (int y = 0; y < out_bgr.rows; y++) {
-        cv::Vec3b* out_row = out_bgr.ptr<cv::Vec3b>(y);
-        const cv::Vec3b* trail_row = trail_colored.ptr<cv::Vec3b>(y);
-        const cv::Vec3b* cam_row = in_bgr.ptr<cv::Vec3b>(y);
-        const uint8_t* mask_row = trail_mask.ptr<uint8_t>(y);
-        const float* alpha_row = trail_alpha_float.ptr<float>(y);
-        
-        for (int x = 0; x < out_bgr.cols; x++) {
-            if (mask_row[x] > 0) {  // Only where no current person
-                float alpha = alpha_row[x];
-                if (alpha > 0.08f) {  // Higher threshold to match trail threshold (was 0.04)
-                    // Alpha blend: out = trail * alpha + camera * (1 - alpha)
-                    // Boost alpha for more dramatic visibility
-                    float boosted_alpha = std::min(1.0f, alpha * 1.2f);
-                    out_row[x][0] = cv::saturate_cast<uint8_t>(trail_row[x][0] * boosted_alpha + cam_row[x][0] * (1.0f - boosted_alpha));
-                    out_row[x][1] = cv::saturate_cast<uint8_t>(trail_row[x][1] * boosted_alpha + cam_row[x][1] * (1.0f - boosted_alpha));
-                    out_row[x][2] = cv::saturate_cast<uint8_t>(trail_row[x][2] * boosted_alpha + cam_row[x][2] * (1.0f - boosted_alpha));
-                }
-            }
-        }
+
+    for (int i = 0; i < num_panels_; i++) {
+        if (effectReadsInput(resolveEffectId(panel_effects_[i].load()))) return true;
     }
+    return false;
 }
 
-void AppCore::processDoubleExposure(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    processDoubleExposureWithState(in_bgr, out_bgr, 
-                                   frame_history_, 
-                                   frame_history_index_, 
-                                   frame_counter_, 
-                                   current_time_offset_,
-                                   background_subtractor_);
+void AppCore::renderFrame(cv::Mat& out_bgr) {
+    int w = processing_width_ > 0 ? processing_width_ : width_;
+    int h = processing_height_ > 0 ? processing_height_ : height_;
+    if (idle_input_.cols != w || idle_input_.rows != h) {
+        idle_input_ = cv::Mat::zeros(h, w, CV_8UC3);
+    }
+    // Same path as a camera frame (auto-cycling, panels); ambient effects ignore the pixels
+    runFrame(idle_input_, out_bgr, /*camera_input=*/false);
 }
 
+void AppCore::processFrameStages(const cv::Mat& in_frame, cv::Mat& out_bgr, bool camera_input) {
+    // Activity score for automatic mode switching (before effect selection, so a switch
+    // applies to this frame). The monitor downsamples to its own probe, so it reads the
+    // input frame and does not depend on the downscale stage.
+    if (camera_input) {
+        observeActivity(in_frame);
+    }
+
+    frame_sequence_++;
+
+    // Update auto-cycling
+    updateAutoCycling();
+
+    // Check if we need special multi-panel processing
+    // This happens when:
+    // 1. Multi-panel mode is explicitly enabled (different effects per panel), OR
+    // 2. We have multiple panels AND panel mode is REPEAT (same view, potentially different effects)
+    bool use_multi_panel = multi_panel_enabled_.load() ||
+                          (num_panels_ > 1 && getPanelMode() == PanelMode::REPEAT);
+
+    // Select this frame's effects first: the union of their inputs() is the stage
+    // schedule, and stages no effect reads are skipped
+    const EffectRegistry& registry = EffectRegistry::instance();
+    Effect current_effect = getEffect();
+    uint32_t inputs = 0;
+    if (use_multi_panel) {
+        ensurePanelResourcesInitialized();
+        selectPanelEffects();
+        for (int i = 0; i < num_panels_; i++) {
+            inputs |= registry.getInputs(resolveEffectId(panel_effect_ids_[i]));
+        }
+    } else {
+        // Validate effect is allowed in current mode, and adjust if necessary
+        SystemMode current_mode = getSystemMode();
+        if (!isEffectValidForMode(current_effect, current_mode)) {
+            // Set to a valid default effect for this mode
+            current_effect = getDefaultEffectForMode(current_mode);
+            setEffect(current_effect);
+        }
+        inputs = registry.getInputs(resolveEffectId(static_cast<int>(current_effect)));
+    }
+    scheduled_inputs_ = inputs;
+
+    // All effects run on the processing-resolution frame; ambient-only frames skip the
+    // downscale (every input flag implies reading the frame)
+    const cv::Mat& in_bgr = downscaleInput(in_frame, /*read_pixels=*/inputs != 0);
+    ensureSize(in_bgr.cols, in_bgr.rows);
 
+    // A transition in progress on the path being left would resume with a stale snapshot
+    if (use_multi_panel != last_frame_multi_panel_) {
+        frame_context_.transition.cancel();
+        for (ProcessingContext& context : panel_contexts_) {
+            context.transition.cancel();
+        }
+        last_frame_multi_panel_ = use_multi_panel;
+    }
 
-// Helper function to convert HSV to BGR
-cv::Scalar AppCore::hsvToBgr(float h, float s, float v) {
-    float c = v * s;
-    float x = c * (1.0f - std::abs(fmod(h / 60.0f, 2.0f) - 1.0f));
-    float m = v - c;
-    
-    float r, g, b;
-    if (h < 60) {
-        r = c; g = x; b = 0;
-    } else if (h < 120) {
-        r = x; g = c; b = 0;
-    } else if (h < 180) {
-        r = 0; g = c; b = x;
-    } else if (h < 240) {
-        r = 0; g = x; b = c;
-    } else if (h < 300) {
-        r = x; g = 0; b = c;
+    if (use_multi_panel) {
+        processMultiPanel(in_bgr, out_bgr);
     } else {
-        r = c; g = 0; b = x;
+        // Process based on current effect
+        processEffect(current_effect, in_bgr, out_bgr);
     }
-    
-    return cv::Scalar((b + m) * 255, (g + m) * 255, (r + m) * 255);
+    last_output_ = out_bgr;
 }
 
-// Helper function to draw morphing shapes
-void AppCore::drawMorphingShape(cv::Mat& img, int cx, int cy, int radius, 
-                                int shape_type, float morph_progress, cv::Scalar color,
-                                float fill_mode) {
-    std::vector<cv::Point> points;
-    
-    // Generate points for current and next shape
-    int next_shape = (shape_type + 1) % 5;
-    
-    std::vector<cv::Point> current_points = getShapePoints(shape_type, cx, cy, radius);
-    std::vector<cv::Point> next_points = getShapePoints(next_shape, cx, cy, radius);
-    
-    // Interpolate between shapes
-    for (size_t i = 0; i < std::max(current_points.size(), next_points.size()); i++) {
-        cv::Point p1 = current_points[i % current_points.size()];
-        cv::Point p2 = next_points[i % next_points.size()];
-        cv::Point interpolated(
-            (int)(p1.x + (p2.x - p1.x) * morph_progress),
-            (int)(p1.y + (p2.y - p1.y) * morph_progress)
-        );
-        points.push_back(interpolated);
+void AppCore::setTransitionDuration(int frames) {
+    transition_frames_ = std::max(0, frames);
+    frame_context_.transition.setDuration(transition_frames_);
+    for (ProcessingContext& context : panel_contexts_) {
+        context.transition.setDuration(transition_frames_);
     }
-    
-    if (points.size() >= 3) {
-        // Draw based on fill_mode: 0.0 = outline only, 1.0 = filled
-        if (fill_mode > 0.3f) {
-            // Draw filled shape
-            cv::fillPoly(img, std::vector<std::vector<cv::Point>>{points}, color);
-        }
-        
-        // Always draw border, but make it more prominent when in outline mode
-        int border_thickness = (fill_mode < 0.5f) ? 3 : 2;
-        cv::polylines(img, std::vector<std::vector<cv::Point>>{points}, true, color, border_thickness);
+}
+
+// The last frame shown can be snapshotted if it has the expected size; views of caller
+// memory (pass-through over a wrapped camera buffer) count too, since
+// TransitionEngine::begin() deep-copies the snapshot
+static bool canSnapshot(const cv::Mat& last_output, const cv::Size& size) {
+    return !last_output.empty() && last_output.size() == size && last_output.type() == CV_8UC3;
+}
+
+bool AppCore::isEffectValidForMode(Effect effect, SystemMode mode) const {
+    // All effects are now valid in all modes
+    return true;
+}
+
+Effect AppCore::getDefaultEffectForMode(SystemMode mode) const {
+    switch (mode) {
+        case SystemMode::AMBIENT:
+            return Effect::PROCEDURAL_SHAPES;  // Default to Procedural Shapes
+        case SystemMode::ACTIVE:
+            return Effect::FILLED_SILHOUETTE;  // Default to Filled Silhouette
+        default:
+            return Effect::DEBUG;  // Fallback
     }
 }
 
-// Helper to get points for different shape types
-std::vector<cv::Point> AppCore::getShapePoints(int shape_type, int cx, int cy, int radius) {
-    std::vector<cv::Point> points;
-    
-    switch (shape_type) {
-        case 0: { // Circle (approximated with many points)
-            int num_points = 32;
-            for (int i = 0; i < num_points; i++) {
-                float angle = (i * 2.0f * M_PI) / num_points;
-                points.push_back(cv::Point(
-                    cx + (int)(radius * std::cos(angle)),
-                    cy + (int)(radius * std::sin(angle))
-                ));
-            }
-            break;
-        }
-        case 1: { // Triangle
-            for (int i = 0; i < 3; i++) {
-                float angle = (i * 2.0f * M_PI / 3.0f) - M_PI / 2.0f;
-                points.push_back(cv::Point(
-                    cx + (int)(radius * std::cos(angle)),
-                    cy + (int)(radius * std::sin(angle))
-                ));
-            }
-            break;
-        }
-        case 2: { // Square
-            for (int i = 0; i < 4; i++) {
-                float angle = (i * 2.0f * M_PI / 4.0f) - M_PI / 4.0f;
-                points.push_back(cv::Point(
-                    cx + (int)(radius * std::cos(angle)),
-                    cy + (int)(radius * std::sin(angle))
-                ));
-            }
-            break;
-        }
-        case 3: { // Hexagon
-            for (int i = 0; i < 6; i++) {
-                float angle = (i * 2.0f * M_PI / 6.0f) - M_PI / 2.0f;
-                points.push_back(cv::Point(
-                    cx + (int)(radius * std::cos(angle)),
-                    cy + (int)(radius * std::sin(angle))
-                ));
-            }
-            break;
-        }
-        case 4: { // Star (5-pointed)
-            for (int i = 0; i < 10; i++) {
-                float angle = (i * 2.0f * M_PI / 10.0f) - M_PI / 2.0f;
-                int r = (i % 2 == 0) ? radius : radius / 2;
-                points.push_back(cv::Point(
-                    cx + (int)(r * std::cos(angle)),
-                    cy + (int)(r * std::sin(angle))
-                ));
-            }
-            break;
-        }
+SystemMode AppCore::getAppropriateModeForEffect(Effect effect) const {
+    switch (effect) {
+        case Effect::PROCEDURAL_SHAPES:
+        case Effect::WAVE_PATTERNS:
+            return SystemMode::AMBIENT;
+        case Effect::DEBUG:
+            // Debug effect doesn't change mode - keep current mode
+            return getSystemMode();
+        default:
+            return SystemMode::ACTIVE;
     }
-    
-    return points;
 }
 
-void AppCore::processDoubleExposureWithState(const cv::Mat& in_bgr, cv::Mat& out_bgr,
-                                             std::vector<cv::Mat>& history,
-                                             int& history_index,
-                                             int& frame_counter,
-                                             int& time_offset,
-                                             cv::Ptr<cv::BackgroundSubtractor> bg_subtractor) {
-    // Ensure frame history buffer is initialized
-    if (history.empty()) {
-        history.resize(MAX_FRAME_HISTORY);
+void AppCore::processEffect(Effect effect, const cv::Mat& in_bgr, cv::Mat& out_bgr) {
+    // Same registry instances and shared stages as the panel path, on the whole frame
+    if (scheduled_inputs_ & IEffect::INPUT_SEGMENTATION) {
+        segmentation_.setCleanupKernelSize(FrameContext::scaledKernelSize(5, area_scale_));
+        segmentation_.beginFrame(in_bgr, frame_sequence_);
     }
-    
-    // Store current frame in history
-    in_bgr.copyTo(history[history_index]);
-    history_index = (history_index + 1) % MAX_FRAME_HISTORY;
-    
-    // Change time offset randomly every 60 frames (~2 seconds at 30fps)
-    frame_counter++;
-    if (frame_counter >= 60) {
-        // Generate random offset between MIN_TIME_OFFSET and MAX_TIME_OFFSET
-        time_offset = MIN_TIME_OFFSET + (rand() % (MAX_TIME_OFFSET - MIN_TIME_OFFSET + 1));
-        frame_counter = 0;
+    bool switched = prepareContext(frame_context_, static_cast<int>(effect), in_bgr, segmentation_,
+                                   frame_history_, segmentation_.getFrameRect(), /*panel_index=*/-1,
+                                   /*min_contour_area=*/0);
+    if (switched && canSnapshot(last_output_, in_bgr.size())) {
+        frame_context_.transition.begin(last_output_);
     }
-    
-    // Calculate index for past frame with current random offset
-    int past_frame_index = (history_index - time_offset + MAX_FRAME_HISTORY) % MAX_FRAME_HISTORY;
-    
-    // Check if past frame exists
-    if (!history[past_frame_index].empty()) {
-        // Detect motion using background subtractor
-        cv::Mat fg_mask;
-        bg_subtractor->apply(in_bgr, fg_mask);
-        
-        // Minimal cleanup
-        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3));
-        cv::morphologyEx(fg_mask, fg_mask, cv::MORPH_CLOSE, kernel);
-        
-        // Blur for smooth edges
-        cv::GaussianBlur(fg_mask, fg_mask, cv::Size(15, 15), 0);
-        
-        // Create stronger double exposure blend (25% current, 75% past for more opaque ghosting)
-        cv::Mat blended;
-        cv::addWeighted(in_bgr, 0.25, history[past_frame_index], 0.75, 0, blended);
-        
-        // Fast blending without float conversion:
-        // Use OpenCV's built-in blending with mask weights
-        out_bgr = in_bgr.clone();
-        
-        // Apply stronger double exposure where mask is above threshold
-        // This avoids all float conversions and uses optimized copyTo
-        blended.copyTo(out_bgr, fg_mask);
-    } else {
-        // Not enough history yet, just pass through
-        out_bgr = in_bgr.clone();
+    runSharedStages(&frame_context_, 1, frame_history_, in_bgr);
+    frame_context_.current->process(frame_context_.frame, out_bgr);
+
+    // Blend into our own buffer: out_bgr is the effect's state (trails) or a view of the input
+    TransitionEngine& transition = frame_context_.transition;
+    if (transition.isActive()) {
+        transition.apply(out_bgr, transition_output_);
+        out_bgr = transition_output_;
     }
 }
 
 void AppCore::ensurePanelResourcesInitialized() {
     if (!panel_resources_initialized_) {
-        panel_bg_subtractors_.resize(num_panels_);
-        panel_silhouette_frames_.resize(num_panels_);
-        
-        // Initialize per-panel Mode 7 (Double Exposure) resources
-        panel_frame_history_.resize(num_panels_);
-        panel_frame_history_index_.resize(num_panels_, 0);
-        panel_frame_counter_.resize(num_panels_, 0);
-        panel_time_offset_.resize(num_panels_, MIN_TIME_OFFSET);
-        
+        // Every panel gets its own effect instances (effects keep state), so panels
+        // can be processed in parallel
+        panel_contexts_ = std::vector<ProcessingContext>(num_panels_);
         for (int i = 0; i < num_panels_; i++) {
-            panel_bg_subtractors_[i] = cv::createBackgroundSubtractorMOG2(500, 16, true);
-            panel_silhouette_frames_[i] = cv::Mat::zeros(height_, width_ / num_panels_, CV_8UC3);
-            // Frame history will be lazy-initialized when Mode 7 is first used
+            panel_contexts_[i].transition.setDuration(transition_frames_);
+            panel_contexts_[i].state_prefix = "panel" + std::to_string(i) + "/";
         }
+        panel_rois_.resize(num_panels_);
+        panel_effect_ids_.resize(num_panels_);
         panel_resources_initialized_ = true;
     }
 }
 
-void AppCore::processMultiPanel(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    // Lazy initialization of per-panel resources
-    ensurePanelResourcesInitialized();
-    
+void AppCore::selectPanelEffects() {
     PanelMode mode = getPanelMode();
-    int panel_width = in_bgr.cols / num_panels_;
     bool individual_effects = multi_panel_enabled_.load();
-    
-    out_bgr = cv::Mat(in_bgr.rows, in_bgr.cols, CV_8UC3);
-    
-    // Special handling for Mode 7 (Double Exposure) in EXTEND mode when NOT using individual effects
-    // In REPEAT mode or when using individual effects, each panel gets its own state via processPanelRegion
-    bool use_fullframe_mode7 = false;
-    if (mode == PanelMode::EXTEND && !individual_effects && display_mode_.load() == 7) {
-        use_fullframe_mode7 = true;
+    std::vector<int>& effects = panel_effect_ids_;
+    std::vector<Effect> valid_effects;
+    int repeat_offset = repeat_cycle_offset_.load();
+    if (mode == PanelMode::REPEAT) {
+        // In REPEAT mode, automatically assign different effects to each panel
+        // Get all valid effects for current system mode and cycle through them
+        valid_effects = getValidEffectsForMode(getSystemMode());
+        if (valid_effects.empty()) {
+            valid_effects = {Effect::DEBUG};  // fallback
+        }
     }
-    
-    if (mode == PanelMode::EXTEND) {
-        // EXTEND mode: Split input horizontally across panels
-        
-        // If Mode 7 is used in shared mode, process full frame first, then split
-        if (use_fullframe_mode7) {
-            cv::Mat processed_full;
-            processDoubleExposure(in_bgr, processed_full);
-            
-            // Now split across panels
-            for (int i = 0; i < num_panels_; i++) {
-                int x_start = i * panel_width;
-                int x_end = (i == num_panels_ - 1) ? in_bgr.cols : (i + 1) * panel_width;
-                
-                int effect = individual_effects ? panel_effects_[i].load() : display_mode_.load();
-                
-                cv::Rect panel_roi(x_start, 0, x_end - x_start, in_bgr.rows);
-                cv::Mat out_region = out_bgr(panel_roi);
-                
-                if (effect == 7) {
-                    // Use the processed full frame
-                    processed_full(panel_roi).copyTo(out_region);
-                } else if (effect == 8) {
-                    // Procedural shapes - generate for this panel region
-                    if (procedural_shapes_effect_) {
-                        procedural_shapes_effect_->process(out_region);
-                    }
-                } else {
-                    // Use standard processing for other effects
-                    cv::Mat in_region = in_bgr(panel_roi);
-                    processPanelRegion(in_region, out_region, effect, i);
-                }
-            }
+    for (int i = 0; i < num_panels_; i++) {
+        if (mode == PanelMode::REPEAT) {
+            // Cycle through valid effects based on panel index and the auto-cycle offset
+            effects[i] = static_cast<int>(valid_effects[(i + repeat_offset) % valid_effects.size()]);
         } else {
-            // Standard extend mode (no Mode 7)
-            for (int i = 0; i < num_panels_; i++) {
-                int x_start = i * panel_width;
-                int x_end = (i == num_panels_ - 1) ? in_bgr.cols : (i + 1) * panel_width;
-                
-                cv::Rect panel_roi(x_start, 0, x_end - x_start, in_bgr.rows);
-                cv::Mat in_region = in_bgr(panel_roi);
-                cv::Mat out_region = out_bgr(panel_roi);
-                
-                int effect = individual_effects ? panel_effects_[i].load() : display_mode_.load();
-                processPanelRegion(in_region, out_region, effect, i);
-            }
+            effects[i] = individual_effects ? panel_effects_[i].load() : display_mode_.load();
         }
-    } else {
-        // REPEAT mode: Show the same image on each panel with different effects per panel
-        // Each panel gets a different effect automatically cycled through available effects
-        for (int i = 0; i < num_panels_; i++) {
-            int x_start = i * panel_width;
-            int x_end = (i == num_panels_ - 1) ? in_bgr.cols : (i + 1) * panel_width;
-            int current_panel_width = x_end - x_start;
-
-            // Resize input to single panel size
-            cv::Mat resized_input;
-            cv::resize(in_bgr, resized_input, cv::Size(current_panel_width, in_bgr.rows));
+    }
+}
 
-            // In REPEAT mode, automatically assign different effects to each panel
-            // Get all valid effects for current system mode and cycle through them
-            std::vector<Effect> valid_effects = getValidEffectsForMode(getSystemMode());
-            if (valid_effects.empty()) {
-                valid_effects = {Effect::DEBUG};  // fallback
-            }
+void AppCore::processMultiPanel(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
+    PanelMode mode = getPanelMode();
+    int panel_width = in_bgr.cols / num_panels_;
+    bool segment = (scheduled_inputs_ & IEffect::INPUT_SEGMENTATION) != 0;
 
-            // Cycle through valid effects based on panel index
-            Effect panel_effect = valid_effects[i % valid_effects.size()];
+    multi_panel_output_.create(in_bgr.rows, in_bgr.cols, CV_8UC3);
+    out_bgr = multi_panel_output_;
 
-            // Convert effect enum to int for processPanelRegion
-            int effect_num = static_cast<int>(panel_effect);
+    // Every panel's region and effect are worked out up front (serially), so the parallel
+    // section below only touches per-panel state and its own slice of out_bgr
+    std::vector<cv::Rect>& panel_rois = panel_rois_;
+    const std::vector<int>& effects = panel_effect_ids_;
+    for (int i = 0; i < num_panels_; i++) {
+        int x_start = i * panel_width;
+        int x_end = (i == num_panels_ - 1) ? in_bgr.cols : (i + 1) * panel_width;
+        panel_rois[i] = cv::Rect(x_start, 0, x_end - x_start, in_bgr.rows);
+    }
 
-            // Process the resized input with panel-specific effect
-            cv::Mat processed_panel;
-            processPanelRegion(resized_input, processed_panel, effect_num, i);
+    // Panels run on OpenCV's thread pool, one stripe per panel up to the core count
+    double stripes = std::min(num_panels_, cv::getNumberOfCPUs());
 
-            // Copy processed panel to output region
-            cv::Rect panel_roi(x_start, 0, current_panel_width, in_bgr.rows);
-            cv::Mat out_region = out_bgr(panel_roi);
-            processed_panel.copyTo(out_region);
+    if (mode == PanelMode::EXTEND) {
+        // EXTEND mode: Split input horizontally across panels. Each panel's effect
+        // renders its region against the full-frame segmentation and history.
+        if (segment) {
+            segmentation_.setCleanupKernelSize(FrameContext::scaledKernelSize(5, area_scale_));
+            segmentation_.beginFrame(in_bgr, frame_sequence_);
         }
-    }
-}
-
-void AppCore::processPanelRegion(const cv::Mat& in_region, cv::Mat& out_region, int effect, int panel_index) {
-    // Ensure per-panel buffers are correctly sized
-    int w = in_region.cols;
-    int h = in_region.rows;
-    if (panel_silhouette_frames_[panel_index].cols != w || 
-        panel_silhouette_frames_[panel_index].rows != h) {
-        panel_silhouette_frames_[panel_index] = cv::Mat::zeros(h, w, CV_8UC3);
-    }
-    
-    cv::Mat temp_output;
-    
-    // Apply the specified effect to this region
-    switch (effect) {
-        case 1:
-            // Pass-through
-            in_region.copyTo(out_region);
-            break;
-        case 2:
-            // Filled silhouette
-            {
-                cv::Mat fg_mask;
-                panel_bg_subtractors_[panel_index]->apply(in_region, fg_mask);
-                
-                std::vector<std::vector<cv::Point>> contours;
-                findPersonContours(fg_mask, contours, /*min_contour_area=*/500);
-                
-                temp_output = cv::Mat::zeros(h, w, CV_8UC3);
-                for (const auto& c : contours) {
-                    cv::drawContours(temp_output, std::vector<std::vector<cv::Point>>{c}, -1,
-                                   cv::Scalar(255, 255, 255), cv::FILLED);
-                }
-                temp_output.copyTo(out_region);
+        for (int i = 0; i < num_panels_; i++) {
+            if (prepareContext(panel_contexts_[i], effects[i], in_bgr(panel_rois[i]), segmentation_,
+                               frame_history_, panel_rois[i], i, /*min_contour_area=*/scaledArea(500))) {
+                beginPanelTransition(i, in_bgr.size());
             }
-            break;
-        case 3:
-            // Outline
-            {
-                cv::Mat fg_mask;
-                panel_bg_subtractors_[panel_index]->apply(in_region, fg_mask);
-                
-                std::vector<std::vector<cv::Point>> contours;
-                findPersonContours(fg_mask, contours, /*min_contour_area=*/500);
-                
-                temp_output = cv::Mat::zeros(h, w, CV_8UC3);
-                for (const auto& c : contours) {
-                    cv::drawContours(temp_output, std::vector<std::vector<cv::Point>>{c}, -1,
-                                   cv::Scalar(255, 255, 255), /*thickness=*/2);
+        }
+        runSharedStages(panel_contexts_.data(), num_panels_, frame_history_, in_bgr);
+
+        cv::parallel_for_(cv::Range(0, num_panels_), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                ProcessingContext& context = panel_contexts_[i];
+                context.current->process(context.frame, context.result);
+                cv::Mat out_region = out_bgr(panel_rois[i]);
+                context.result.copyTo(out_region);
+                if (context.transition.isActive()) {
+                    context.transition.apply(out_region, out_region);
                 }
-                temp_output.copyTo(out_region);
             }
-            break;
-        case 4:
-            // Motion trails
-            {
-                cv::Mat fg_mask;
-                panel_bg_subtractors_[panel_index]->apply(in_region, fg_mask);
-                
-                std::vector<std::vector<cv::Point>> contours;
-                findPersonContours(fg_mask, contours, /*min_contour_area=*/500);
-                
-                panel_silhouette_frames_[panel_index] *= 0.7f;
-                for (const auto& c : contours) {
-                    cv::drawContours(panel_silhouette_frames_[panel_index], 
-                                   std::vector<std::vector<cv::Point>>{c}, -1,
-                                   cv::Scalar(255, 255, 255), cv::FILLED);
-                }
-                panel_silhouette_frames_[panel_index].copyTo(out_region);
+        }, stripes);
+    } else {
+        // REPEAT mode: Show the same image on each panel with different effects per panel
+        // Each panel gets a different effect automatically cycled through available effects
+
+        // Every panel sees the same panel-sized image, so resize and segment it once
+        // (ambient-only panels just need its size)
+        cv::Size repeat_size(panel_width, in_bgr.rows);
+        if (scheduled_inputs_ != 0) {
+            cv::resize(in_bgr, repeat_input_, repeat_size);
+        } else {
+            repeat_input_.create(repeat_size, CV_8UC3);
+        }
+        if (segment) {
+            repeat_segmentation_.setCleanupKernelSize(FrameContext::scaledKernelSize(5, area_scale_));
+            repeat_segmentation_.beginFrame(repeat_input_, frame_sequence_);
+        }
+        cv::Rect repeat_roi(0, 0, repeat_size.width, repeat_size.height);
+        for (int i = 0; i < num_panels_; i++) {
+            if (prepareContext(panel_contexts_[i], effects[i], repeat_input_, repeat_segmentation_,
+                               repeat_history_, repeat_roi, i, /*min_contour_area=*/scaledArea(500))) {
+                beginPanelTransition(i, in_bgr.size());
             }
-            break;
-        case 5:
-            // Rainbow trails (renumbered from 6) - use global mode (too complex for per-panel)
-            // Just apply a simple version: camera feed + rainbow motion overlay
-            {
-                cv::Mat fg_mask;
-                panel_bg_subtractors_[panel_index]->apply(in_region, fg_mask);
-                
-                std::vector<std::vector<cv::Point>> contours;
-                findPersonContours(fg_mask, contours, /*min_contour_area=*/500);
-                
-                // Simple rainbow effect: color code the current motion
-                temp_output = in_region.clone();
-                for (size_t i = 0; i < contours.size(); i++) {
-                    // Use contour index for color variation
-                    float hue = fmod(i * 60.0f + (panel_index * 30.0f), 180.0f);
-                    cv::Mat hsv_color(1, 1, CV_8UC3, cv::Scalar(hue, 255, 255));
-                    cv::Mat bgr_color;
-                    cv::cvtColor(hsv_color, bgr_color, cv::COLOR_HSV2BGR);
-                    cv::Scalar color(bgr_color.at<cv::Vec3b>(0, 0)[0],
-                                   bgr_color.at<cv::Vec3b>(0, 0)[1],
-                                   bgr_color.at<cv::Vec3b>(0, 0)[2]);
-                    
-                    cv::drawContours(temp_output, contours, i, color, 3);
+        }
+        runSharedStages(panel_contexts_.data(), num_panels_, repeat_history_, repeat_input_);
+
+        cv::parallel_for_(cv::Range(0, num_panels_), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                // Process the resized input with panel-specific effect
+                ProcessingContext& context = panel_contexts_[i];
+                context.current->process(context.frame, context.result);
+
+                // Copy processed panel to output region (the last panel may be a few columns wider)
+                const cv::Rect& panel_roi = panel_rois[i];
+                cv::Mat out_region = out_bgr(panel_roi);
+                if (context.result.cols == panel_roi.width) {
+                    context.result.copyTo(out_region);
+                } else {
+                    cv::resize(context.result, out_region, panel_roi.size());
                 }
-                temp_output.copyTo(out_region);
-            }
-            break;
-        case 6:
-            // Double exposure (renumbered from 7) - full implementation with per-panel state
-            {
-                cv::Mat temp_output;
-                processDoubleExposureWithState(in_region, temp_output,
-                                               panel_frame_history_[panel_index],
-                                               panel_frame_history_index_[panel_index],
-                                               panel_frame_counter_[panel_index],
-                                               panel_time_offset_[panel_index],
-                                               panel_bg_subtractors_[panel_index]);
-                temp_output.copyTo(out_region);
-            }
-            break;
-        case 7:
-            // Procedural shapes (renumbered from 8) - generate for this panel region
-            {
-                if (procedural_shapes_effect_) {
-                    procedural_shapes_effect_->process(out_region, w, h);
+                // The composited region is a copy, so the fade blends in place
+                if (context.transition.isActive()) {
+                    context.transition.apply(out_region, out_region);
                 }
             }
-            break;
-        case 8:
-            // Wave patterns - generate for this panel region
-            {
-                if (wave_patterns_effect_) {
-                    wave_patterns_effect_->process(out_region, w, h);
-                }
+        }, stripes);
+    }
+}
+
+void AppCore::beginPanelTransition(int panel_index, const cv::Size& frame_size) {
+    // Serial, before the panels render: snapshot the panel's region of the last composite
+    if (canSnapshot(last_output_, frame_size)) {
+        panel_contexts_[panel_index].transition.begin(last_output_(panel_rois_[panel_index]));
+    }
+}
+
+bool AppCore::prepareContext(ProcessingContext& context, int effect, const cv::Mat& input,
+                             SegmentationStage& segmentation, const FrameHistory& history,
+                             const cv::Rect& roi, int panel_index, int min_contour_area) {
+    int id = resolveEffectId(effect);
+    EffectInstance& instance = context.instances[id];
+    bool created = false;
+    if (!instance.effect) {
+        instance.effect = EffectRegistry::instance().create(id);
+        created = true;
+    }
+    if (instance.size != input.size()) {
+        instance.effect->prepare(input.size());
+        instance.size = input.size();
+    }
+    if (created && !restored_state_.empty()) {
+        // Warm start: resume where the previous run's instance left off
+        instance.effect->loadState(restored_state_, context.state_prefix + std::to_string(id) + "/");
+    }
+    bool switched = context.current != nullptr && context.current != instance.effect.get();
+    context.current = instance.effect.get();
+
+    FrameContext& frame_context = context.frame;
+    frame_context.input = input;
+    frame_context.segmentation = &segmentation;
+    frame_context.history = &history;
+    frame_context.roi = roi;
+    frame_context.sequence = frame_sequence_;
+    frame_context.panel_index = panel_index;
+    frame_context.min_contour_area = min_contour_area > 0 ? min_contour_area
+                                                          : scaledArea(context.current->minContourArea());
+    frame_context.area_scale = area_scale_;
+    return switched;
+}
+
+void AppCore::runSharedStages(ProcessingContext* contexts, int count, FrameHistory& history,
+                              const cv::Mat& frame) {
+    bool segment = false;
+    bool push_history = false;
+    for (int i = 0; i < count; i++) {
+        uint32_t inputs = contexts[i].current->inputs();
+        segment |= (inputs & IEffect::INPUT_SEGMENTATION) != 0;
+        push_history |= (inputs & IEffect::INPUT_HISTORY) != 0;
+    }
+
+    // MOG2 -> morphology -> contours, filling the segmentation cache with exactly what
+    // each context's effect will read (SegmentationStage computes serially)
+    auto run_segmentation = [&]() {
+        for (int i = 0; i < count; i++) {
+            uint32_t inputs = contexts[i].current->inputs();
+            const FrameContext& frame_context = contexts[i].frame;
+            if (inputs & IEffect::INPUT_FG_MASK) {
+                frame_context.segmentation->foregroundMask();
             }
-            break;
-        case 9:
-            // Geometric abstraction
-            {
-                cv::Mat fg_mask;
-                panel_bg_subtractors_[panel_index]->apply(in_region, fg_mask);
-                
-                std::vector<std::vector<cv::Point>> contours;
-                findPersonContours(fg_mask, contours, /*min_contour_area=*/500);
-                
-                temp_output = cv::Mat::zeros(h, w, CV_8UC3);
-                
-                for (const auto& c : contours) {
-                    std::vector<cv::Point> approx;
-                    double epsilon = 15.0;
-                    cv::approxPolyDP(c, approx, epsilon, false);
-                    
-                    if (approx.size() >= 3) {
-                        float area = cv::contourArea(c);
-                        float hue = fmod(area * 0.1f, 360.0f);
-                        cv::Scalar color = hsvToBgr(hue, 1.0f, 1.0f);
-                        cv::fillPoly(temp_output, std::vector<std::vector<cv::Point>>{approx}, color);
-                        cv::polylines(temp_output, std::vector<std::vector<cv::Point>>{approx}, true, 
-                                     cv::Scalar(255, 255, 255), 2);
-                    }
-                }
-                temp_output.copyTo(out_region);
+            if (inputs & IEffect::INPUT_CONTOURS) {
+                frame_context.contours(/*cleaned=*/false);
             }
-            break;
-        default:
-            in_region.copyTo(out_region);
-            break;
+            if (inputs & IEffect::INPUT_CLEANED) {
+                frame_context.contours(/*cleaned=*/true);
+            }
+        }
+    };
+    // Keyed by sequence: contexts sharing a history push the frame once
+    auto run_history = [&]() {
+        history.push(frame, frame_sequence_);
+    };
+
+    if (segment && push_history) {
+        // Independent stages (both only read frame), so the history copy/convert runs on
+        // the side thread. Segmentation stays on the calling thread: inside a parallel_for_
+        // task MOG2's own parallel_for_ would run nested, i.e. serially.
+        beginHistoryPush(history, frame);
+        run_segmentation();
+        finishHistoryPush();
+    } else if (segment) {
+        run_segmentation();
+    } else if (push_history) {
+        run_history();
+    }
+}
+
+void AppCore::beginHistoryPush(FrameHistory& history, const cv::Mat& frame) {
+    if (!history_thread_.joinable()) {
+        history_thread_ = std::thread(&AppCore::historyWorkerLoop, this);
+    }
+    {
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        history_job_ = &history;
+        history_job_frame_ = &frame;
+    }
+    history_wake_.notify_one();
+}
+
+void AppCore::finishHistoryPush() {
+    std::unique_lock<std::mutex> lock(history_mutex_);
+    history_done_.wait(lock, [this] { return history_job_ == nullptr; });
+}
+
+void AppCore::historyWorkerLoop() {
+    std::unique_lock<std::mutex> lock(history_mutex_);
+    while (true) {
+        history_wake_.wait(lock, [this] { return history_job_ != nullptr || history_thread_stop_; });
+        if (history_thread_stop_) return;
+        FrameHistory* history = history_job_;
+        const cv::Mat* frame = history_job_frame_;
+        lock.unlock();
+        // Keyed by sequence: contexts sharing a history push the frame once
+        history->push(*frame, frame_sequence_);
+        lock.lock();
+        history_job_ = nullptr;
+        history_job_frame_ = nullptr;
+        history_done_.notify_one();
     }
 }
 
@@ -842,14 +808,6 @@ void AppCore::updateAutoCycling() {
 
     cycle_frame_counter_++;
 
-    // Update transition if in progress
-    if (transition_frames_remaining_ > 0) {
-        transition_frames_remaining_--;
-        // Calculate alpha: 0.0 (start) -> 1.0 (end)
-        transition_alpha_ = 1.0f - ((float)transition_frames_remaining_ / TRANSITION_FRAMES);
-        return;
-    }
-
     // Initialize on first run
     if (frames_until_next_mode_ == 0) {
         frames_until_next_mode_ = getRandomCycleInterval();
@@ -859,29 +817,11 @@ void AppCore::updateAutoCycling() {
     if (cycle_frame_counter_ >= frames_until_next_mode_) {
         // In repeat mode, cycle effects on each panel individually
         if (num_panels_ > 1 && getPanelMode() == PanelMode::REPEAT) {
-            // Cycle effects on each panel
-            for (int panel_index = 0; panel_index < num_panels_; panel_index++) {
-                // Get current effect for this panel
-                int current_effect_num = panel_effects_[panel_index].load();
-                Effect current_effect = static_cast<Effect>(current_effect_num);
-
-                // Get all valid effects for current system mode
-                std::vector<Effect> valid_effects = getValidEffectsForMode(getSystemMode());
-                if (valid_effects.empty()) {
-                    valid_effects = {Effect::DEBUG};
-                }
-
-                // Find current effect in the list
-                auto it = std::find(valid_effects.begin(), valid_effects.end(), current_effect);
-                size_t current_index = (it != valid_effects.end()) ? std::distance(valid_effects.begin(), it) : 0;
-
-                // Cycle to next effect for this panel
-                size_t next_index = (current_index + 1) % valid_effects.size();
-                Effect next_effect = valid_effects[next_index];
-
-                // Update the panel effect
-                panel_effects_[panel_index].store(static_cast<int>(next_effect));
-            }
+            // Every panel moves on to its next effect (selectPanelEffects() reads the
+            // offset), and each panel's transition engine fades the switch
+            std::vector<Effect> valid_effects = getValidEffectsForMode(getSystemMode());
+            int count = std::max<int>(1, static_cast<int>(valid_effects.size()));
+            repeat_cycle_offset_.store((repeat_cycle_offset_.load() + 1) % count);
 
             const char* mode_names[] = {"Ambient", "Active"};
             SystemMode current_mode = getSystemMode();
@@ -904,17 +844,7 @@ void AppCore::updateAutoCycling() {
             size_t next_index = (current_index + 1) % valid_effects.size();
             Effect next_effect = valid_effects[next_index];
 
-            const char* effect_names[] = {
-                "Debug View",
-                "Filled Silhouette",
-                "Outline Only",
-                "Motion Trails",
-                "Rainbow Motion Trails",
-                "Double Exposure",
-                "Procedural Shapes",
-                "Wave Patterns",
-                "Geometric Abstraction"
-            };
+            const EffectRegistry& registry = EffectRegistry::instance();
 
             const char* mode_names[] = {
                 "Ambient",
@@ -922,16 +852,14 @@ void AppCore::updateAutoCycling() {
             };
 
             std::cout << "[AUTO-CYCLE] [" << mode_names[static_cast<int>(current_system_mode)] << "] Switching from Effect "
-                      << static_cast<int>(current_effect) << " (" << effect_names[static_cast<int>(current_effect) - 1] << ")"
+                      << static_cast<int>(current_effect) << " (" << registry.getName(static_cast<int>(current_effect)) << ")"
                       << " to Effect " << static_cast<int>(next_effect)
-                      << " (" << effect_names[static_cast<int>(next_effect) - 1] << ")" << std::endl;
+                      << " (" << registry.getName(static_cast<int>(next_effect)) << ")" << std::endl;
 
             setEffect(next_effect);
         }
 
-        // Start transition
-        transition_frames_remaining_ = TRANSITION_FRAMES;
-        transition_alpha_ = 0.0f;
+        // The switch itself crossfades (see TransitionEngine)
 
         // Reset counter and get new random interval
         cycle_frame_counter_ = 0;
@@ -976,49 +904,6 @@ void AppCore::toggleAutoCycling() {
         // Reset counters when re-enabling
         cycle_frame_counter_ = 0;
         frames_until_next_mode_ = getRandomCycleInterval();
-        transition_frames_remaining_ = 0;
     }
 }
 
-
-
-// Effect 9: Geometric Abstraction (Active System Mode - Interpretation-based)
-void AppCore::processGeometricAbstraction(const cv::Mat& in_bgr, cv::Mat& out_bgr) {
-    if (in_bgr.empty()) {
-        out_bgr = cv::Mat::zeros(height_, width_, CV_8UC3);
-        return;
-    }
-    
-    cv::Mat fg_mask;
-    background_subtractor_->apply(in_bgr, fg_mask);
-    
-    // Clean up noise with morphological operations
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(5, 5));
-    cv::morphologyEx(fg_mask, fg_mask, cv::MORPH_OPEN, kernel);  // Remove small noise
-    cv::morphologyEx(fg_mask, fg_mask, cv::MORPH_CLOSE, kernel); // Fill small holes
-    
-    std::vector<std::vector<cv::Point>> contours;
-    findPersonContours(fg_mask, contours, /*min_contour_area=*/1000);
-    
-    out_bgr = cv::Mat::zeros(in_bgr.rows, in_bgr.cols, CV_8UC3);
-    
-    for (const auto& c : contours) {
-        // Approximate contour with fewer points for geometric look
-        std::vector<cv::Point> approx;
-        double epsilon = 15.0;  // Approximation accuracy
-        cv::approxPolyDP(c, approx, epsilon, false);
-        
-        if (approx.size() >= 3) {
-            // Draw simplified polygon with gradient colors
-            // Use contour area to generate hue (0-360 range for hsvToBgr)
-            float area = cv::contourArea(c);
-            float hue = fmod(area * 0.1f, 360.0f);
-            cv::Scalar color = hsvToBgr(hue, 1.0f, 1.0f);
-            cv::fillPoly(out_bgr, std::vector<std::vector<cv::Point>>{approx}, color);
-            
-            // Draw outline
-            cv::polylines(out_bgr, std::vector<std::vector<cv::Point>>{approx}, true, 
-                         cv::Scalar(255, 255, 255), 2);
-        }
-    }
-}
@@ -0,0 +1,191 @@
+#include "app/background_model.h"
+#include "app/state_checkpoint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <opencv2/imgproc.hpp>
+
+std::unique_ptr<BackgroundModel> BackgroundModel::create(Type type) {
+    switch (type) {
+        case Type::MOG2_FAST:
+            return std::make_unique<Mog2BackgroundModel>(500, 16, false, /*update_interval=*/4);
+        case Type::RUNNING_AVERAGE:
+            return std::make_unique<RunningAverageBackgroundModel>();
+        case Type::FRAME_DIFF:
+            return std::make_unique<FrameDiffBackgroundModel>();
+        case Type::MOG2:
+        default:
+            return std::make_unique<Mog2BackgroundModel>(500, 16, true);
+    }
+}
+
+bool BackgroundModel::parseType(const char* name, Type& type) {
+    if (strcmp(name, "mog2") == 0) {
+        type = Type::MOG2;
+    } else if (strcmp(name, "mog2-fast") == 0) {
+        type = Type::MOG2_FAST;
+    } else if (strcmp(name, "average") == 0) {
+        type = Type::RUNNING_AVERAGE;
+    } else if (strcmp(name, "diff") == 0) {
+        type = Type::FRAME_DIFF;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* BackgroundModel::getTypeName(Type type) {
+    switch (type) {
+        case Type::MOG2_FAST: return "mog2-fast";
+        case Type::RUNNING_AVERAGE: return "average";
+        case Type::FRAME_DIFF: return "diff";
+        case Type::MOG2:
+        default: return "mog2";
+    }
+}
+
+Mog2BackgroundModel::Mog2BackgroundModel(int history, double var_threshold, bool detect_shadows,
+                                         int update_interval)
+    : subtractor_(cv::createBackgroundSubtractorMOG2(history, var_threshold, detect_shadows)),
+      history_(history),
+      update_interval_(std::max(1, update_interval)),
+      slowdown_(1),
+      frames_(0),
+      warm_start_(false) {
+}
+
+void Mog2BackgroundModel::setUpdateSlowdown(int factor) {
+    slowdown_ = std::max(1, factor);
+}
+
+void Mog2BackgroundModel::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    if (frames_ == 0) return;  // Nothing learned yet
+    cv::Mat background;
+    subtractor_->getBackgroundImage(background);
+    if (!background.empty()) {
+        checkpoint.put(prefix + "background", background);
+    }
+}
+
+void Mog2BackgroundModel::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    cv::Mat background;
+    if (checkpoint.get(prefix + "background", background) && background.type() == CV_8UC3) {
+        seed_ = background.clone();
+    }
+}
+
+void Mog2BackgroundModel::apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) {
+    if (!seed_.empty()) {
+        if (seed_.size() == frame_bgr.size()) {
+            // Learning rate 1 re-initialises every Gaussian from the seed image
+            subtractor_->apply(seed_, seed_mask_, 1.0);
+            frames_ = history_;
+            warm_start_ = true;
+        }
+        seed_.release();
+        seed_mask_.release();
+    }
+
+    frames_++;
+    const int interval = update_interval_ * slowdown_;
+    if (interval == 1) {
+        // MOG2's own rate restarts at 1/2 after re-initialisation; keep the steady one
+        subtractor_->apply(frame_bgr, fg_mask, warm_start_ ? 1.0 / history_ : -1.0);
+        return;
+    }
+
+    // MOG2's automatic rate is 1 / min(frames, history); scale it by the interval so
+    // the model adapts as fast as when it is updated every frame
+    double learning_rate = 0.0;
+    if ((frames_ - 1) % interval == 0) {
+        double frames = static_cast<double>(std::min<uint64_t>(frames_, history_));
+        learning_rate = std::min(1.0, interval / frames);
+    }
+    subtractor_->apply(frame_bgr, fg_mask, learning_rate);
+}
+
+void GrayBackgroundModel::toSmallGray(const cv::Mat& frame_bgr) {
+    if (frame_bgr.rows >= MIN_DOWNSAMPLE_ROWS) {
+        cv::cvtColor(frame_bgr, gray_full_, cv::COLOR_BGR2GRAY);
+        cv::resize(gray_full_, gray_, cv::Size(frame_bgr.cols / 2, frame_bgr.rows / 2), 0, 0, cv::INTER_AREA);
+    } else {
+        cv::cvtColor(frame_bgr, gray_, cv::COLOR_BGR2GRAY);
+    }
+}
+
+void GrayBackgroundModel::upscaleMask(const cv::Size& frame_size, cv::Mat& fg_mask) {
+    if (small_mask_.size() == frame_size) {
+        small_mask_.copyTo(fg_mask);
+    } else {
+        cv::resize(small_mask_, fg_mask, frame_size, 0, 0, cv::INTER_NEAREST);
+    }
+}
+
+RunningAverageBackgroundModel::RunningAverageBackgroundModel(int threshold, int background_shift,
+                                                             int foreground_shift)
+    : threshold_(threshold),
+      background_shift_(background_shift),
+      foreground_shift_(foreground_shift) {
+}
+
+void RunningAverageBackgroundModel::saveState(StateCheckpoint& checkpoint,
+                                              const std::string& prefix) const {
+    if (!background_.empty()) {
+        checkpoint.put(prefix + "background", background_);
+    }
+}
+
+void RunningAverageBackgroundModel::loadState(const StateCheckpoint& checkpoint,
+                                              const std::string& prefix) {
+    cv::Mat background;
+    // apply() keeps it when the first frame has the same (downsampled) size
+    if (checkpoint.get(prefix + "background", background) && background.type() == CV_16UC1) {
+        background_ = background.clone();
+    }
+}
+
+void RunningAverageBackgroundModel::apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) {
+    toSmallGray(frame_bgr);
+    small_mask_.create(gray_.size(), CV_8UC1);
+
+    if (background_.size() != gray_.size()) {
+        // First frame (or new size): it is the background
+        gray_.convertTo(background_, CV_16U, 256.0);
+        small_mask_.setTo(0);
+        upscaleMask(frame_bgr.size(), fg_mask);
+        return;
+    }
+
+    const int32_t threshold_q8 = threshold_ << 8;
+    for (int y = 0; y < gray_.rows; y++) {
+        const uint8_t* gray_row = gray_.ptr<uint8_t>(y);
+        uint16_t* bg_row = background_.ptr<uint16_t>(y);
+        uint8_t* mask_row = small_mask_.ptr<uint8_t>(y);
+        for (int x = 0; x < gray_.cols; x++) {
+            int32_t delta = (static_cast<int32_t>(gray_row[x]) << 8) - bg_row[x];
+            bool foreground = std::abs(delta) > threshold_q8;
+            int shift = foreground ? foreground_shift_ : background_shift_;
+            // Arithmetic shift rounds towards -inf; fine for a background estimate
+            bg_row[x] = static_cast<uint16_t>(bg_row[x] + (delta >> shift));
+            mask_row[x] = foreground ? 255 : 0;
+        }
+    }
+    upscaleMask(frame_bgr.size(), fg_mask);
+}
+
+FrameDiffBackgroundModel::FrameDiffBackgroundModel(int threshold)
+    : threshold_(threshold) {
+}
+
+void FrameDiffBackgroundModel::apply(const cv::Mat& frame_bgr, cv::Mat& fg_mask) {
+    toSmallGray(frame_bgr);
+    if (previous_.size() != gray_.size()) {
+        gray_.copyTo(previous_);
+    }
+    cv::absdiff(gray_, previous_, small_mask_);
+    cv::threshold(small_mask_, small_mask_, threshold_, 255, cv::THRESH_BINARY);
+    // Keep this frame for the next difference (swap buffers instead of copying)
+    cv::swap(gray_, previous_);
+    upscaleMask(frame_bgr.size(), fg_mask);
+}
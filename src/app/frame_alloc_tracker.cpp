@@ -0,0 +1,46 @@
+#include "app/frame_alloc_tracker.h"
+
+FrameAllocTracker& FrameAllocTracker::instance() {
+    static FrameAllocTracker tracker;
+    return tracker;
+}
+
+FrameAllocTracker::FrameAllocTracker()
+    : std_allocator_(cv::Mat::getStdAllocator()),
+      installed_(false),
+      allocations_(0) {
+}
+
+void FrameAllocTracker::install() {
+    if (installed_) return;
+    cv::Mat::setDefaultAllocator(this);
+    installed_ = true;
+}
+
+#if CV_VERSION_MAJOR >= 4
+cv::UMatData* FrameAllocTracker::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                          cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const {
+#else
+cv::UMatData* FrameAllocTracker::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                          int flags, cv::UMatUsageFlags usage_flags) const {
+#endif
+    // Wrapping caller-owned memory is free; only count new buffers
+    if (!data) {
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // The standard allocator records itself as the owner, so deallocation goes straight to it
+    return std_allocator_->allocate(dims, sizes, type, data, step, flags, usage_flags);
+}
+
+#if CV_VERSION_MAJOR >= 4
+bool FrameAllocTracker::allocate(cv::UMatData* data, cv::AccessFlag access_flags,
+                                 cv::UMatUsageFlags usage_flags) const {
+#else
+bool FrameAllocTracker::allocate(cv::UMatData* data, int access_flags, cv::UMatUsageFlags usage_flags) const {
+#endif
+    return std_allocator_->allocate(data, access_flags, usage_flags);
+}
+
+void FrameAllocTracker::deallocate(cv::UMatData* data) const {
+    std_allocator_->deallocate(data);
+}
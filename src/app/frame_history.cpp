@@ -0,0 +1,84 @@
+#include "app/frame_history.h"
+
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+FrameHistory::FrameHistory(int capacity, Format format)
+    : slots_(std::max(1, capacity)),
+      format_(format),
+      next_(0),
+      count_(0),
+      last_sequence_(0),
+      has_sequence_(false) {
+}
+
+void FrameHistory::setFormat(Format format) {
+    if (format == format_) return;
+    format_ = format;
+    clear();
+    // Slots are re-created in the new layout on the next pushes
+    for (cv::Mat& slot : slots_) {
+        slot.release();
+    }
+}
+
+void FrameHistory::setCapacity(int capacity) {
+    capacity = std::max(1, capacity);
+    int old_capacity = static_cast<int>(slots_.size());
+    if (capacity == old_capacity) return;
+
+    // Oldest kept frame first, so the newest ends up just before next_
+    int keep = std::min(count_, capacity);
+    std::vector<cv::Mat> slots(capacity);
+    for (int i = 0; i < keep; i++) {
+        int frames_back = keep - i;
+        slots[i] = slots_[(next_ - frames_back + old_capacity) % old_capacity];
+    }
+    slots_.swap(slots);
+    next_ = keep % capacity;
+    count_ = keep;
+}
+
+void FrameHistory::clear() {
+    next_ = 0;
+    count_ = 0;
+    has_sequence_ = false;
+}
+
+void FrameHistory::push(const cv::Mat& frame_bgr, uint64_t sequence) {
+    if (frame_bgr.empty()) return;
+    if (has_sequence_ && sequence == last_sequence_) return;
+
+    if (frame_bgr.size() != frame_size_) {
+        frame_size_ = frame_bgr.size();
+        clear();
+    }
+
+    // Slots keep their buffers, so after the first lap this is a plain copy/convert
+    cv::Mat& slot = slots_[next_];
+    if (format_ == Format::BGR565) {
+        cv::cvtColor(frame_bgr, slot, cv::COLOR_BGR2BGR565);
+    } else {
+        frame_bgr.copyTo(slot);
+    }
+
+    next_ = (next_ + 1) % static_cast<int>(slots_.size());
+    count_ = std::min(count_ + 1, static_cast<int>(slots_.size()));
+    last_sequence_ = sequence;
+    has_sequence_ = true;
+}
+
+bool FrameHistory::read(int frames_back, const cv::Rect& roi, cv::Mat& out_bgr) const {
+    if (frames_back < 1 || frames_back > count_) return false;
+
+    int capacity = static_cast<int>(slots_.size());
+    const cv::Mat& slot = slots_[(next_ - frames_back + capacity) % capacity];
+    cv::Rect region = roi.empty() ? cv::Rect(0, 0, slot.cols, slot.rows) : roi;
+
+    if (format_ == Format::BGR565) {
+        cv::cvtColor(slot(region), out_bgr, cv::COLOR_BGR5652BGR);
+    } else {
+        out_bgr = slot(region);
+    }
+    return true;
+}
@@ -0,0 +1,88 @@
+#include "app/quality_governor.h"
+
+#include <algorithm>
+
+QualityGovernor::QualityGovernor()
+    : target_fps_(0.0),
+      target_temp_c_(0.0f),
+      level_(0),
+      average_ms_(0.0),
+      slow_frames_(0),
+      hot_frames_(0),
+      headroom_frames_(0),
+      up_frames_(MIN_UP_FRAMES),
+      frames_since_up_(-1) {
+}
+
+void QualityGovernor::configure(double target_fps, float target_temp_c) {
+    target_fps_ = std::max(0.0, target_fps);
+    target_temp_c_ = std::max(0.0f, target_temp_c);
+    level_ = 0;
+    slow_frames_ = 0;
+    hot_frames_ = 0;
+    headroom_frames_ = 0;
+    up_frames_ = MIN_UP_FRAMES;
+    frames_since_up_ = -1;
+}
+
+const char* QualityGovernor::describeLevel(int level) {
+    switch (level) {
+        case 0: return "full quality";
+        case 1: return "MOG2 updates halved";
+        case 2: return "contours simplified";
+        case 3: return "history depth halved";
+        case 4: return "processing resolution 75%";
+        case 5: return "processing resolution 50%";
+        default: return "unknown";
+    }
+}
+
+bool QualityGovernor::update(double process_ms, float temperature_c) {
+    if (!isEnabled()) return false;
+
+    // ~1s time constant at 30fps: single slow frames (an effect allocating its
+    // buffers after a switch) do not trigger a step
+    average_ms_ = average_ms_ == 0.0 ? process_ms : average_ms_ + (process_ms - average_ms_) * 0.05;
+
+    // Leave room in the frame budget for display and capture on the same core(s)
+    bool slow = false;
+    bool fast = true;
+    if (target_fps_ > 0.0) {
+        double budget_ms = 1000.0 / target_fps_;
+        slow = average_ms_ > budget_ms * 0.85;
+        fast = average_ms_ < budget_ms * 0.55;
+    }
+    bool hot = false;
+    bool cool = true;
+    if (target_temp_c_ > 0.0f && temperature_c > 0.0f) {
+        hot = temperature_c > target_temp_c_;
+        cool = temperature_c < target_temp_c_ - TEMP_HYSTERESIS_C;
+    }
+
+    if (frames_since_up_ >= 0) frames_since_up_++;
+    slow_frames_ = slow ? slow_frames_ + 1 : 0;
+    hot_frames_ = hot ? hot_frames_ + 1 : 0;
+    headroom_frames_ = (fast && cool) ? headroom_frames_ + 1 : 0;
+
+    if ((slow_frames_ >= DOWN_FRAMES || hot_frames_ >= TEMP_DOWN_FRAMES) && level_ < MAX_LEVEL) {
+        // The last step up did not hold: wait twice as long before trying again
+        if (frames_since_up_ >= 0 && frames_since_up_ < up_frames_) {
+            up_frames_ = std::min(MAX_UP_FRAMES, up_frames_ * 2);
+        }
+        frames_since_up_ = -1;
+        level_++;
+        slow_frames_ = 0;
+        hot_frames_ = 0;
+        headroom_frames_ = 0;
+        return true;
+    }
+    if (headroom_frames_ >= up_frames_ && level_ > 0) {
+        level_--;
+        frames_since_up_ = 0;
+        slow_frames_ = 0;
+        hot_frames_ = 0;
+        headroom_frames_ = 0;
+        return true;
+    }
+    return false;
+}
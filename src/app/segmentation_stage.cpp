@@ -0,0 +1,146 @@
+#include "app/segmentation_stage.h"
+
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+SegmentationStage::SegmentationStage()
+    : background_model_(BackgroundModel::create(BackgroundModel::Type::MOG2)),
+      sequence_(0),
+      fg_valid_(false),
+      cleaned_valid_(false),
+      cleanup_kernel_size_(5),
+      update_slowdown_(1),
+      contour_epsilon_(0.0),
+      refresh_interval_(1),
+      change_threshold_(0.0),
+      frames_since_refresh_(0),
+      reusing_(false),
+      probed_(false),
+      contours_used_(0) {
+    cleanup_kernel_ = cv::getStructuringElement(cv::MORPH_ELLIPSE,
+                                                cv::Size(cleanup_kernel_size_, cleanup_kernel_size_));
+}
+
+void SegmentationStage::beginFrame(const cv::Mat& frame_bgr, uint64_t sequence) {
+    frame_ = frame_bgr;
+    sequence_ = sequence;
+    probed_ = false;
+
+    // Reuse needs a mask from an earlier frame of this size; whatever else was cached
+    // (cleaned mask, contour entries) stays valid, and what was not is derived from it
+    reusing_ = fg_valid_ && fg_mask_.size() == frame_bgr.size() && !needsRefresh();
+    if (reusing_) {
+        frames_since_refresh_++;
+        return;
+    }
+    if (change_threshold_ > 0.0 && refresh_interval_ > 1) {
+        // This frame becomes the reference for the change score
+        if (probed_) {
+            change_probe_.keepLatestAsReference();
+        } else {
+            change_probe_.update(frame_bgr, /*advance=*/true);
+        }
+    }
+    frames_since_refresh_ = 0;
+    fg_valid_ = false;
+    cleaned_valid_ = false;
+    contours_used_ = 0;
+}
+
+bool SegmentationStage::needsRefresh() {
+    if (refresh_interval_ <= 1 || frames_since_refresh_ + 1 >= refresh_interval_) return true;
+    if (change_threshold_ <= 0.0) return false;
+    probed_ = true;
+    return change_probe_.update(frame_, /*advance=*/false) > change_threshold_;
+}
+
+void SegmentationStage::setRefreshPolicy(int interval, double change_threshold) {
+    refresh_interval_ = std::max(1, interval);
+    change_threshold_ = std::max(0.0, change_threshold);
+    frames_since_refresh_ = 0;
+    change_probe_.reset();
+}
+
+void SegmentationStage::setCleanupKernelSize(int size) {
+    if (size == cleanup_kernel_size_) return;
+    cleanup_kernel_size_ = size;
+    cleanup_kernel_ = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(size, size));
+}
+
+void SegmentationStage::setBackgroundModel(std::unique_ptr<BackgroundModel> model) {
+    background_model_ = std::move(model);
+    background_model_->setUpdateSlowdown(update_slowdown_);
+    fg_valid_ = false;
+    cleaned_valid_ = false;
+    contours_used_ = 0;
+}
+
+void SegmentationStage::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    background_model_->saveState(checkpoint, prefix);
+}
+
+void SegmentationStage::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    background_model_->loadState(checkpoint, prefix);
+}
+
+void SegmentationStage::setModelUpdateSlowdown(int factor) {
+    update_slowdown_ = factor;
+    background_model_->setUpdateSlowdown(factor);
+}
+
+void SegmentationStage::setContourEpsilon(double epsilon) {
+    // Cached contours keep the old setting until the next refresh
+    contour_epsilon_ = epsilon;
+}
+
+const cv::Mat& SegmentationStage::foregroundMask() {
+    if (!fg_valid_) {
+        background_model_->apply(frame_, fg_mask_);
+        fg_valid_ = true;
+    }
+    return fg_mask_;
+}
+
+const cv::Mat& SegmentationStage::cleanedMask() {
+    if (!cleaned_valid_) {
+        cv::morphologyEx(foregroundMask(), cleaned_mask_, cv::MORPH_OPEN, cleanup_kernel_);   // Remove small noise
+        cv::morphologyEx(cleaned_mask_, cleaned_mask_, cv::MORPH_CLOSE, cleanup_kernel_);     // Fill small holes
+        cleaned_valid_ = true;
+    }
+    return cleaned_mask_;
+}
+
+const std::vector<std::vector<cv::Point>>& SegmentationStage::contours(int min_area, bool cleaned,
+                                                                        const cv::Rect& roi) {
+    cv::Rect region = roi.empty() ? getFrameRect() : (roi & getFrameRect());
+
+    for (size_t i = 0; i < contours_used_; i++) {
+        const ContourEntry& entry = contour_cache_[i];
+        if (entry.min_area == min_area && entry.cleaned == cleaned && entry.roi == region) {
+            return entry.contours;
+        }
+    }
+
+    if (contours_used_ == contour_cache_.size()) {
+        contour_cache_.emplace_back();
+    }
+    ContourEntry& entry = contour_cache_[contours_used_++];
+    entry.min_area = min_area;
+    entry.cleaned = cleaned;
+    entry.roi = region;
+    entry.contours.clear();
+
+    const cv::Mat& mask = cleaned ? cleanedMask() : foregroundMask();
+    cv::findContours(mask(region), raw_contours_, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+
+    entry.contours.reserve(raw_contours_.size());
+    for (auto& c : raw_contours_) {
+        if (cv::contourArea(c) <= min_area) continue;
+        if (contour_epsilon_ > 0.0) {
+            cv::approxPolyDP(c, approx_scratch_, contour_epsilon_, /*closed=*/true);
+            c.swap(approx_scratch_);
+        }
+        entry.contours.push_back(std::move(c));
+    }
+    return entry.contours;
+}
@@ -0,0 +1,213 @@
+#include "app/state_checkpoint.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = {'R', 'P', 'I', 'M', 'S', 'T', 'A', '1'};
+
+struct CheckpointHeader {
+    char magic[8];
+    uint64_t entry_count;
+    uint64_t file_bytes;
+};
+
+// Followed by the key and then the data, each padded to 8 bytes
+struct EntryHeader {
+    uint32_t key_bytes;
+    int32_t type;  // OpenCV type (CV_8UC3, CV_16UC1, CV_64FC1, ...)
+    int32_t rows;
+    int32_t cols;
+    uint64_t data_bytes;
+};
+
+size_t align8(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+// Largest side of a stored matrix (frames and trail buffers are far smaller)
+constexpr int32_t MAX_ENTRY_SIDE = 1 << 14;
+
+// A type and shape cv::Mat accepts, and data_bytes that matches them exactly
+bool validEntryShape(const EntryHeader& entry) {
+    if (entry.rows <= 0 || entry.cols <= 0 || entry.rows > MAX_ENTRY_SIDE || entry.cols > MAX_ENTRY_SIDE) {
+        return false;
+    }
+    int depth = CV_MAT_DEPTH(entry.type);
+    int channels = CV_MAT_CN(entry.type);
+    if (entry.type < 0 || depth > CV_16F || channels < 1 || channels > 4 ||
+        entry.type != CV_MAKETYPE(depth, channels)) {
+        return false;
+    }
+    uint64_t bytes = static_cast<uint64_t>(entry.rows) * static_cast<uint64_t>(entry.cols) *
+                     static_cast<uint64_t>(CV_ELEM_SIZE(entry.type));
+    return bytes == entry.data_bytes;
+}
+
+}  // namespace
+
+void StateCheckpoint::put(const std::string& key, const cv::Mat& value) {
+    // Empty entries are never written, so load() can insist on a real shape
+    if (value.empty() || value.dims > 2) return;
+    // clone() makes it continuous, which save() relies on
+    entries_[key] = value.clone();
+}
+
+void StateCheckpoint::putValue(const std::string& key, double value) {
+    entries_[key] = cv::Mat(1, 1, CV_64FC1, cv::Scalar(value));
+}
+
+bool StateCheckpoint::get(const std::string& key, cv::Mat& value) const {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return false;
+    value = it->second;
+    return true;
+}
+
+bool StateCheckpoint::getValue(const std::string& key, double& value) const {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.type() != CV_64FC1 || it->second.total() != 1) return false;
+    value = it->second.at<double>(0, 0);
+    return true;
+}
+
+bool StateCheckpoint::restore(const std::string& key, cv::Mat& target) const {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second.size() != target.size() || it->second.type() != target.type()) {
+        return false;
+    }
+    it->second.copyTo(target);
+    return true;
+}
+
+bool StateCheckpoint::save(const std::string& path) const {
+    size_t total = sizeof(CheckpointHeader);
+    for (const auto& entry : entries_) {
+        total += sizeof(EntryHeader) + align8(entry.first.size()) +
+                 align8(entry.second.total() * entry.second.elemSize());
+    }
+
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "State: failed to create " << tmp_path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (ftruncate(fd, static_cast<off_t>(total)) != 0) {
+        std::cerr << "State: failed to size " << tmp_path << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* address = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file open
+    if (address == MAP_FAILED) {
+        std::cerr << "State: failed to map " << tmp_path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    uint8_t* out = static_cast<uint8_t*>(address);
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.entry_count = entries_.size();
+    header.file_bytes = total;
+    memcpy(out, &header, sizeof(header));
+    size_t offset = sizeof(header);
+
+    for (const auto& entry : entries_) {
+        const cv::Mat& value = entry.second;
+        EntryHeader entry_header;
+        entry_header.key_bytes = static_cast<uint32_t>(entry.first.size());
+        entry_header.type = value.type();
+        entry_header.rows = value.rows;
+        entry_header.cols = value.cols;
+        entry_header.data_bytes = value.total() * value.elemSize();
+        memcpy(out + offset, &entry_header, sizeof(entry_header));
+        offset += sizeof(entry_header);
+        memcpy(out + offset, entry.first.data(), entry.first.size());
+        offset += align8(entry.first.size());
+        if (entry_header.data_bytes > 0) {
+            memcpy(out + offset, value.data, entry_header.data_bytes);
+        }
+        offset += align8(entry_header.data_bytes);
+    }
+
+    bool ok = msync(address, total, MS_SYNC) == 0;
+    munmap(address, total);
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "State: failed to write " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool StateCheckpoint::load(const std::string& path) {
+    entries_.clear();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;  // No checkpoint yet: cold start
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(CheckpointHeader)) {
+        ::close(fd);
+        std::cerr << "State: " << path << " is not a state checkpoint" << std::endl;
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "State: failed to map " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    const uint8_t* in = static_cast<const uint8_t*>(address);
+    CheckpointHeader header;
+    memcpy(&header, in, sizeof(header));
+    bool valid = memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.file_bytes == size;
+    size_t offset = sizeof(header);
+    for (uint64_t i = 0; valid && i < header.entry_count; i++) {
+        EntryHeader entry;
+        if (offset + sizeof(entry) > size) {
+            valid = false;
+            break;
+        }
+        memcpy(&entry, in + offset, sizeof(entry));
+        offset += sizeof(entry);
+        // Bound both lengths by the file before adding them, so the sums cannot wrap
+        if (!validEntryShape(entry) || entry.key_bytes > size || entry.data_bytes > size) {
+            valid = false;
+            break;
+        }
+        size_t key_end = offset + align8(entry.key_bytes);
+        size_t data_end = key_end + align8(entry.data_bytes);
+        if (data_end > size) {
+            valid = false;
+            break;
+        }
+        std::string key(reinterpret_cast<const char*>(in + offset), entry.key_bytes);
+        cv::Mat value(entry.rows, entry.cols, entry.type);
+        if (entry.data_bytes > 0) {
+            memcpy(value.data, in + key_end, entry.data_bytes);
+        }
+        entries_[key] = value;
+        offset = data_end;
+    }
+    munmap(address, size);
+
+    if (!valid) {
+        entries_.clear();
+        std::cerr << "State: " << path << " is not a state checkpoint" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#include "app/transition_engine.h"
+
+#include <algorithm>
+#include <opencv2/core/hal/intrin.hpp>
+
+// out = (from * (256 - w) + to * w + 128) >> 8 with w in [0, 256]; the sum stays below
+// 2^16, so it fits the 16-bit lanes
+static void lerpRow(const uint8_t* from, const uint8_t* to, uint8_t* out, int length, int weight) {
+    const uint16_t w = static_cast<uint16_t>(weight);
+    const uint16_t inverse = static_cast<uint16_t>(256 - weight);
+    int x = 0;
+#if CV_SIMD128
+    const cv::v_uint16x8 v_w = cv::v_setall_u16(w);
+    const cv::v_uint16x8 v_inverse = cv::v_setall_u16(inverse);
+    const cv::v_uint16x8 v_half = cv::v_setall_u16(128);
+    for (; x <= length - 16; x += 16) {
+        cv::v_uint16x8 f0, f1, t0, t1;
+        cv::v_expand(cv::v_load(from + x), f0, f1);
+        cv::v_expand(cv::v_load(to + x), t0, t1);
+        cv::v_uint16x8 r0 = (f0 * v_inverse + t0 * v_w + v_half) >> 8;
+        cv::v_uint16x8 r1 = (f1 * v_inverse + t1 * v_w + v_half) >> 8;
+        cv::v_store(out + x, cv::v_pack(r0, r1));
+    }
+#endif
+    for (; x < length; x++) {
+        out[x] = static_cast<uint8_t>((from[x] * inverse + to[x] * w + 128) >> 8);
+    }
+}
+
+TransitionEngine::TransitionEngine(int duration_frames)
+    : duration_(std::max(0, duration_frames)),
+      remaining_(0) {
+}
+
+void TransitionEngine::setDuration(int frames) {
+    duration_ = std::max(0, frames);
+    remaining_ = std::min(remaining_, duration_);
+}
+
+void TransitionEngine::begin(const cv::Mat& outgoing) {
+    if (duration_ == 0 || outgoing.empty() || outgoing.type() != CV_8UC3) {
+        remaining_ = 0;
+        return;
+    }
+    // Reuses the snapshot buffer after the first transition at this size
+    outgoing.copyTo(snapshot_);
+    remaining_ = duration_;
+}
+
+void TransitionEngine::apply(const cv::Mat& incoming, cv::Mat& out) {
+    if (remaining_ <= 0) return;
+    if (incoming.size() != snapshot_.size() || incoming.type() != snapshot_.type()) {
+        remaining_ = 0;
+        if (out.data != incoming.data) out = incoming;
+        return;
+    }
+
+    // Incoming weight ramps (0, 1]: the last frame of the transition is all incoming
+    int weight = ((duration_ - remaining_ + 1) * 256) / duration_;
+    remaining_--;
+
+    out.create(incoming.size(), CV_8UC3);
+    int rows = incoming.rows;
+    int length = incoming.cols * 3;
+    if (incoming.isContinuous() && snapshot_.isContinuous() && out.isContinuous()) {
+        length *= rows;
+        rows = 1;
+    }
+    for (int y = 0; y < rows; y++) {
+        lerpRow(snapshot_.ptr<uint8_t>(y), incoming.ptr<uint8_t>(y), out.ptr<uint8_t>(y), length, weight);
+    }
+}
@@ -1,17 +1,27 @@
 #include "components/camera_capture.h"
 #include "components/matrix_display.h"
 #include "components/debug_overlay.h"
+#include "components/frame_recording.h"
 #include "components/debug_data_collector.h"
+#include "components/metrics_server.h"
+#include "components/network_output_sink.h"
 #include "app/app_core.h"
 #include <led-matrix.h>
 #include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
 #include <iostream>
 #include <csignal>
+#include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
 #include <pwd.h>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <fcntl.h>
 #include <sys/select.h>
 #include <termios.h>
@@ -50,6 +60,79 @@ public:
 
     AppCore& getCore() { return core_; }
 
+    void setScaleMode(FrameScaler::Mode mode) {
+        matrix_.setScaleMode(mode);
+    }
+
+    void setOutputCurve(double gamma, bool dither) {
+        matrix_.setOutputCurve(gamma, dither);
+    }
+
+    // Adaptive quality against the collector's CPU temperature (sampled once per second)
+    void setQualityGovernor(double target_fps, float target_temp_c) {
+        core_.setQualityGovernor(target_fps, target_temp_c,
+                                 [this]() { return debug_data_collector_.getTemperature(); });
+    }
+
+    // Run effects + matrix output on a dedicated thread fed by the capture queue
+    void setPipelined(bool enabled, int queue_depth, FrameDropPolicy policy) {
+        camera_.setPipelined(enabled, queue_depth, policy);
+    }
+
+    // Idle rendering: while only ambient effects are on screen, render them from a timer at
+    // render_fps and drop the camera to probe_fps, where frames only feed AppCore's activity
+    // score (automatic mode switching brings back Active mode when people appear).
+    // render_fps <= 0 disables idle rendering (every camera frame is processed).
+    void setIdleRendering(double render_fps, double probe_fps) {
+        idle_render_fps_ = render_fps;
+        idle_probe_fps_ = probe_fps;
+    }
+
+    // Per-stage timing (capture latency, processFrame per effect, display, vsync wait),
+    // logged as p50/p95/p99 every report_seconds
+    void setStageTiming(bool enabled, int report_seconds = 5) {
+        stage_timing_ = enabled;
+        timing_report_seconds_ = std::max(1, report_seconds);
+        updateTimingCollection();
+    }
+
+    // Serve fps, stage latency histograms, effect/mode, temperature and throttling as
+    // Prometheus text on port (0 = off). Implies stage timing collection (without the log).
+    void setMetricsPort(int port) {
+        metrics_server_.reset();
+        if (port > 0) {
+            metrics_server_ = std::make_unique<MetricsServer>(debug_data_collector_, port);
+        }
+        updateTimingCollection();
+    }
+
+    // Also send every processed frame, split into one tile per endpoint, to matrix_receiver
+    // nodes (tile_width x tile_height each; 0 = this matrix's size)
+    bool setTileOutput(const std::vector<std::string>& endpoints, int tile_width, int tile_height,
+                       FrameScaler::Mode mode) {
+        tile_sink_ = std::make_unique<NetworkOutputSink>(
+            endpoints, tile_width > 0 ? tile_width : matrix_.getWidth(),
+            tile_height > 0 ? tile_height : matrix_.getHeight());
+        tile_sink_->setScaleMode(mode);
+        return tile_sink_->isReady();
+    }
+
+    // Record every camera frame (raw, with sensor timestamps) for later --replay
+    bool setRecording(const std::string& path) {
+        return recorder_.open(path);
+    }
+
+    // Feed frames from a recording instead of the camera; the app exits when it ends
+    // (unless loop). Lets a run be reproduced frame for frame on the real matrix.
+    bool setReplay(const std::string& path, ReplayFrameSource::Speed speed, bool loop) {
+        replay_.reset(new ReplayFrameSource(path, speed, loop));
+        if (!replay_->isOpen()) {
+            replay_.reset();
+            return false;
+        }
+        return true;
+    }
+
     void run() {
         if (geteuid() == 0) {
             const char* sudo_user = std::getenv("SUDO_USER");
@@ -62,12 +145,31 @@ public:
         }
 
         // Set up frame processing pipeline: camera -> process -> matrix
-        camera_.setFrameCallback([this](uint8_t *data, int width, int height) {
-            processFrame(data, width, height);
+        camera_.setFrameCallback([this](uint8_t *data, int width, int height, int stride) {
+            processFrame(data, width, height, stride);
         });
 
-        // Start camera capture
-        camera_.start();
+        // Before the camera starts, so the frame path sees a settled metrics_server_
+        if (metrics_server_ && !metrics_server_->start()) {
+            metrics_server_.reset();
+            updateTimingCollection();
+        }
+
+        // Start camera capture (or the replay thread standing in for it)
+        if (replay_) {
+            replay_thread_ = std::thread(&CameraToMatrix::replayLoop, this);
+        } else {
+            if (recorder_.isOpen()) {
+                camera_.setRecorder(&recorder_);
+            }
+            camera_.start();
+        }
+
+        if (idle_render_fps_ > 0.0) {
+            idle_thread_ = std::thread(&CameraToMatrix::idleRenderLoop, this);
+            std::cout << "Idle rendering enabled: ambient effects at " << idle_render_fps_
+                      << " fps, camera probe at " << idle_probe_fps_ << " fps" << std::endl;
+        }
 
         // Set up keyboard input (non-blocking)
         setupKeyboardInput();
@@ -108,25 +210,122 @@ public:
         std::cout << "Press 1-9, m, a, §, d" << (num_panels > 1 ? ", q" : "") << "; Ctrl+C to stop" << std::endl;
 
         // Keep running until interrupted
+        auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(timing_report_seconds_);
         while (running) {
             checkKeyboardInput();
+            if (metrics_server_) {
+                debug_data_collector_.setDroppedFrames(camera_.getDroppedFrames());
+            }
+            if (stage_timing_ && std::chrono::steady_clock::now() >= next_report) {
+                debug_data_collector_.setDroppedFrames(camera_.getDroppedFrames());
+                std::cout << debug_data_collector_.takeReport() << std::flush;
+                next_report += std::chrono::seconds(timing_report_seconds_);
+            }
             usleep(10000); // 10ms sleep
         }
 
         restoreKeyboardInput();
 
-        camera_.stop();
+        if (metrics_server_) {
+            metrics_server_->stop();
+        }
+        if (idle_thread_.joinable()) {
+            idle_thread_.join();
+        }
+        if (replay_thread_.joinable()) {
+            replay_thread_.join();
+        } else {
+            camera_.stop();
+        }
+        recorder_.close();
+
+        if (camera_.isPipelined()) {
+            std::cout << "Frames dropped by capture queue: " << camera_.getDroppedFrames() << std::endl;
+        }
     }
 
 private:
     // Process frame - routes to appropriate display mode
-    void processFrame(uint8_t *data, int width, int height) {
+    void processFrame(uint8_t *data, int width, int height, int stride) {
+        // libcamera stream is configured as RGB888, but in practice is BGR byte-order in this pipeline.
+        // Treat input as BGR consistently with OpenCV.
+        // Note: If sensor mode was specified, libcamera's ISP handles scaling (hardware-accelerated)
+        // Wrap the buffer with its real row pitch so padded ISP output sizes need no copy.
+        cv::Mat in_bgr(height, width, CV_8UC3, data, static_cast<size_t>(stride));
+        if (collect_timing_) {
+            uint64_t latency = camera_.getLastCaptureLatencyNs();
+            if (latency > 0) {
+                debug_data_collector_.recordStage(DebugDataCollector::Stage::CAPTURE, latency);
+            }
+        }
+
+        // Idle: the timer renders the ambient effects, camera frames only probe for motion
+        if (idle_render_fps_ > 0.0 && !core_.needsCameraInput()) {
+            probeMotion(in_bgr);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(core_mutex_);
+        cv::Mat out_bgr;
+        {
+            DebugDataCollector::ScopedTimer timer(timingCollector(), DebugDataCollector::Stage::PROCESS,
+                                                  effectTimingBin());
+            core_.processFrame(in_bgr, out_bgr);
+        }
+        showFrame(out_bgr);
+    }
+
+    // Stands in for the camera callback while replaying a recording
+    void replayLoop() {
+        FrameView frame;
+        while (running && replay_->read(frame)) {
+            if (recorder_.isOpen()) {
+                recorder_.record(frame);
+            }
+            if (frame.order == PixelOrder::RGB) {
+                // FFmpeg (rpicam_to_matrix) recordings; the app works in BGR
+                cv::Mat rgb(frame.height, frame.width, CV_8UC3, const_cast<uint8_t*>(frame.data),
+                            static_cast<size_t>(frame.stride));
+                cv::cvtColor(rgb, replay_bgr_, cv::COLOR_RGB2BGR);
+                processFrame(replay_bgr_.data, replay_bgr_.cols, replay_bgr_.rows,
+                             static_cast<int>(replay_bgr_.step));
+            } else {
+                processFrame(const_cast<uint8_t*>(frame.data), frame.width, frame.height, frame.stride);
+            }
+        }
+        std::cout << "Replay finished" << std::endl;
+        running = false;
+    }
+
+    DebugDataCollector* timingCollector() {
+        return collect_timing_ ? &debug_data_collector_ : nullptr;
+    }
+
+    void updateTimingCollection() {
+        collect_timing_ = stage_timing_ || metrics_server_ != nullptr;
+        matrix_.setTimingCollector(timingCollector());
+    }
+
+    // Effect number for the per-effect timing histogram (0 = several effects across panels)
+    int effectTimingBin() const {
+        bool multi_panel = core_.isMultiPanelEnabled() ||
+                           (core_.getNumPanels() > 1 && core_.getPanelMode() == PanelMode::REPEAT);
+        return multi_panel ? 0 : static_cast<int>(core_.getEffect());
+    }
+
+    // Send a processed frame to the matrix (with the debug overlay when enabled).
+    // Caller holds core_mutex_.
+    void showFrame(const cv::Mat& out_bgr) {
         bool debug = debug_enabled_.load();
         
-        // Only update debug data collection when debug mode is enabled
-        if (debug) {
+        // Only update debug data collection when debug mode or the metrics endpoint needs it
+        if (debug || metrics_server_) {
             debug_data_collector_.recordFrame();
         }
+        if (metrics_server_) {
+            debug_data_collector_.setCurrentState(static_cast<int>(core_.getEffect()),
+                                                  static_cast<int>(core_.getSystemMode()));
+        }
         
         // Create overlay callback if debug is enabled
         std::function<void(FrameCanvas*)> overlay_callback = nullptr;
@@ -138,14 +337,63 @@ private:
             };
         }
         
-        // libcamera stream is configured as RGB888, but in practice is BGR byte-order in this pipeline.
-        // Treat input as BGR consistently with OpenCV.
-        // Note: If sensor mode was specified, libcamera's ISP handles scaling (hardware-accelerated)
-        cv::Mat in_bgr(height, width, CV_8UC3, data);
-        cv::Mat out_bgr;
-        core_.processFrame(in_bgr, out_bgr);
         if (!out_bgr.empty()) {
-            matrix_.displayFrame(out_bgr.data, out_bgr.cols, out_bgr.rows, overlay_callback);
+            // Remote tiles first: our own display then waits for vsync
+            if (tile_sink_) {
+                tile_sink_->writeFrame(out_bgr.data, out_bgr.cols, out_bgr.rows,
+                                       static_cast<int>(out_bgr.step), PixelOrder::BGR);
+            }
+            // Output may be a view of the camera buffer (pass-through), so keep its step
+            matrix_.displayFrame(out_bgr.data, out_bgr.cols, out_bgr.rows,
+                                 static_cast<int>(out_bgr.step), overlay_callback);
+        }
+    }
+
+    // Runs on the camera thread for every (low-rate) frame while idle
+    void probeMotion(const cv::Mat& in_bgr) {
+        std::lock_guard<std::mutex> lock(core_mutex_);
+        core_.observeActivity(in_bgr);
+    }
+
+    // Renders ambient-only frames at idle_render_fps_ and throttles the camera while idle
+    void idleRenderLoop() {
+        using Clock = std::chrono::steady_clock;
+        const auto interval = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / idle_render_fps_));
+        auto next_frame = Clock::now();
+        bool idle = false;
+        cv::Mat out_bgr;
+
+        while (running) {
+            bool needs_input = core_.needsCameraInput();
+            if (needs_input == idle) {
+                idle = !needs_input;
+                camera_.setFrameRateLimit(idle ? idle_probe_fps_ : 0.0);
+                if (idle) {
+                    std::cout << "[IDLE] Ambient effects only - rendering from timer, camera at "
+                              << idle_probe_fps_ << " fps" << std::endl;
+                } else {
+                    std::cout << "[IDLE] Effects need camera input - camera back to full rate" << std::endl;
+                }
+            }
+
+            if (idle) {
+                std::lock_guard<std::mutex> lock(core_mutex_);
+                {
+                    DebugDataCollector::ScopedTimer timer(timingCollector(), DebugDataCollector::Stage::PROCESS,
+                                                          effectTimingBin());
+                    core_.renderFrame(out_bgr);
+                }
+                showFrame(out_bgr);
+            }
+
+            next_frame += interval;
+            auto now = Clock::now();
+            if (next_frame < now) {
+                // Fell behind (slow frame): don't try to catch up with a burst
+                next_frame = now;
+            }
+            std::this_thread::sleep_until(next_frame);
         }
     }
 
@@ -343,6 +591,24 @@ private:
     struct termios original_termios_;  // For restoring terminal settings
     
     AppCore core_;
+    std::mutex core_mutex_;  // Camera callback and idle render thread both drive core_ + matrix_
+
+    // Idle rendering (see setIdleRendering)
+    double idle_render_fps_ = 0.0;
+    double idle_probe_fps_ = 2.0;
+    std::thread idle_thread_;
+
+    // Recording / replay (see setRecording, setReplay)
+    FrameRecorder recorder_;
+    std::unique_ptr<ReplayFrameSource> replay_;
+    std::thread replay_thread_;
+    cv::Mat replay_bgr_;
+
+    bool stage_timing_ = false;
+    int timing_report_seconds_ = 5;
+    bool collect_timing_ = false;  // Stage timing or metrics export
+    std::unique_ptr<MetricsServer> metrics_server_;
+    std::unique_ptr<NetworkOutputSink> tile_sink_;  // --send-tiles
     
     // Multi-panel state: independent of display modes
     std::atomic<bool> multi_panel_enabled_{false};
@@ -359,6 +625,23 @@ void printUsage(const char* program) {
               << "                                 Larger = wider field of view (less zoom)\n"
               << "                                 e.g., --sensor-width 2304 --sensor-height 1296\n"
               << "  --sensor-height HEIGHT         Sensor capture height for FOV control (default: auto)\n"
+              << "  --pipeline                     Process frames on a worker thread fed by a capture queue\n"
+              << "                                 (capture no longer waits for effects/matrix output)\n"
+              << "  --queue-depth N                Frames buffered with --drop-policy newest (default: 2)\n"
+              << "  --drop-policy POLICY           oldest: always process the newest frame (default)\n"
+              << "                                 newest: process in order, drop arrivals while full\n"
+              << "  --auto-mode                    Switch Ambient/Active automatically from scene activity\n"
+              << "  --motion-threshold F           Fraction of the activity probe that must change to go\n"
+              << "                                 Active (default: 0.02)\n"
+              << "  --idle-threshold F             Activity below this counts as idle (default: 0.005)\n"
+              << "  --idle-timeout SECONDS         Idle time before switching to Ambient (default: 10)\n"
+              << "  --ambient-fps N                Render ambient-only effects from a timer at N fps and throttle\n"
+              << "                                 the camera to a motion probe (default: 0 = off, implies --auto-mode)\n"
+              << "  --probe-fps N                  Camera rate while idle with --ambient-fps (default: 2)\n"
+              << "  --record FILE                  Record raw camera frames to FILE for later --replay\n"
+              << "  --replay FILE                  Feed frames from a recording instead of the camera\n"
+              << "  --replay-speed SPEED           native: recorded timing (default), max: as fast as possible\n"
+              << "  --replay-loop                  Restart the recording when it ends\n"
               << "\n"
               << "Matrix configuration:\n"
               << "  --led-rows ROWS                Matrix rows per panel (default: 64)\n"
@@ -377,6 +660,27 @@ void printUsage(const char* program) {
               << "  --led-pwm-lsb-nanoseconds N    PWM LSB nanoseconds (default: 130, range: 50-3000)\n"
               << "                                 Lower values = higher refresh rate, more ghosting\n"
               << "  --led-limit-refresh N          Limit refresh rate to N Hz (default: 0 = no limit)\n"
+              << "  --output-gamma G               Apply gamma G, brightness and PWM levels in our output LUT\n"
+              << "                                 instead of the library (e.g. 2.2; default: off)\n"
+              << "  --output-dither                Temporal dithering between PWM levels (with --output-gamma)\n"
+              << "                                 Keeps gradients smooth at low --led-pwm-bits\n"
+              << "  --scale-filter FILTER          Frame-to-matrix filter: nearest, area (default: nearest)\n"
+              << "  --process-scale N              Run effects at N x matrix resolution (default: 0 = camera resolution)\n"
+              << "                                 1 = matrix size, no rescale on output\n"
+              << "  --check-allocs                 Log cv::Mat allocations per frame when the count changes\n"
+              << "  --compact-history              Store double exposure history as BGR565 (2/3 the memory)\n"
+              << "  --bg-model MODEL               Background subtraction: mog2, mog2-fast, average, diff (default: mog2)\n"
+              << "  --segment-every N              Run segmentation every Nth frame, reuse the silhouette in between (default: 1)\n"
+              << "  --segment-change F             With --segment-every: segment early once F of the scene changed (e.g. 0.02)\n"
+              << "  --state-file PATH              Restore the learned background and effect state from PATH, save it every 30s\n"
+              << "  --transition-frames N          Crossfade effect switches over N frames (default: 30, 0 = cut)\n"
+              << "  --target-fps F                 Lower quality step by step to keep processing at F fps (default: off)\n"
+              << "  --target-temp C                Lower quality while the CPU is above C degrees (default: off)\n"
+              << "  --stage-timing [SECONDS]       Log capture/process/display/vsync p50/p95/p99 every SECONDS (default: 5)\n"
+              << "  --metrics-port PORT            Serve Prometheus metrics on http://HOST:PORT/metrics (default: off)\n"
+              << "  --send-tiles HOST:PORT,...     Also send the output split into one tile per receiver (left to right)\n"
+              << "                                 to matrix_receiver nodes over UDP\n"
+              << "  --tile-size WxH                Size of each sent tile (default: this matrix's size)\n"
               << "\n"
               << "  --help                         Show this help message\n"
               << std::endl;
@@ -403,6 +707,38 @@ int main(int argc, char *argv[]) {
     int pwm_dither_bits = 0;
     int pwm_lsb_nanoseconds = 130;
     int limit_refresh_rate_hz = 0;
+    bool pipelined = false;
+    int queue_depth = 2;
+    FrameDropPolicy drop_policy = FrameDropPolicy::DROP_OLDEST;
+    FrameScaler::Mode scale_mode = FrameScaler::Mode::NEAREST;
+    double output_gamma = 0.0;  // 0 = library luminance correction
+    bool output_dither = false;
+    int process_scale = 0;  // 0 = camera resolution
+    bool check_allocs = false;
+    bool compact_history = false;
+    BackgroundModel::Type bg_model = BackgroundModel::Type::MOG2;
+    int segment_every = 1;
+    double segment_change = 0.0;
+    const char* state_file = nullptr;
+    int transition_frames = 30;
+    double target_fps = 0.0;  // 0 = no quality governor
+    float target_temp = 0.0f;
+    bool stage_timing = false;
+    int timing_report_seconds = 5;
+    int metrics_port = 0;
+    std::vector<std::string> tile_endpoints;
+    int tile_width = 0;  // 0 = matrix size
+    int tile_height = 0;
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    ReplayFrameSource::Speed replay_speed = ReplayFrameSource::Speed::NATIVE;
+    bool replay_loop = false;
+    double ambient_fps = 0.0;  // 0 = idle rendering off
+    double probe_fps = 2.0;
+    bool auto_mode = false;
+    double motion_threshold = 0.02;
+    double idle_threshold = 0.005;
+    double idle_timeout = 10.0;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -417,6 +753,21 @@ int main(int argc, char *argv[]) {
             sensor_width = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--sensor-height") == 0 && i + 1 < argc) {
             sensor_height = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipelined = true;
+        } else if (strcmp(argv[i], "--queue-depth") == 0 && i + 1 < argc) {
+            queue_depth = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--drop-policy") == 0 && i + 1 < argc) {
+            const char* policy = argv[++i];
+            if (strcmp(policy, "oldest") == 0) {
+                drop_policy = FrameDropPolicy::DROP_OLDEST;
+            } else if (strcmp(policy, "newest") == 0) {
+                drop_policy = FrameDropPolicy::DROP_NEWEST;
+            } else {
+                std::cerr << "Unknown drop policy: " << policy << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
         } else if (strcmp(argv[i], "--led-rows") == 0 && i + 1 < argc) {
             rows = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-cols") == 0 && i + 1 < argc) {
@@ -439,6 +790,92 @@ int main(int argc, char *argv[]) {
             pwm_lsb_nanoseconds = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-limit-refresh") == 0 && i + 1 < argc) {
             limit_refresh_rate_hz = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output-gamma") == 0 && i + 1 < argc) {
+            output_gamma = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--output-dither") == 0) {
+            output_dither = true;
+        } else if (strcmp(argv[i], "--scale-filter") == 0 && i + 1 < argc) {
+            const char* filter = argv[++i];
+            if (strcmp(filter, "nearest") == 0) {
+                scale_mode = FrameScaler::Mode::NEAREST;
+            } else if (strcmp(filter, "area") == 0) {
+                scale_mode = FrameScaler::Mode::AREA;
+            } else {
+                std::cerr << "Unknown scale filter: " << filter << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--process-scale") == 0 && i + 1 < argc) {
+            process_scale = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--check-allocs") == 0) {
+            check_allocs = true;
+        } else if (strcmp(argv[i], "--compact-history") == 0) {
+            compact_history = true;
+        } else if (strcmp(argv[i], "--bg-model") == 0 && i + 1 < argc) {
+            const char* model = argv[++i];
+            if (!BackgroundModel::parseType(model, bg_model)) {
+                std::cerr << "Unknown background model: " << model << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--segment-every") == 0 && i + 1 < argc) {
+            segment_every = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segment-change") == 0 && i + 1 < argc) {
+            segment_change = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--state-file") == 0 && i + 1 < argc) {
+            state_file = argv[++i];
+        } else if (strcmp(argv[i], "--transition-frames") == 0 && i + 1 < argc) {
+            transition_frames = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc) {
+            target_fps = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--target-temp") == 0 && i + 1 < argc) {
+            target_temp = static_cast<float>(std::atof(argv[++i]));
+        } else if (strcmp(argv[i], "--stage-timing") == 0) {
+            stage_timing = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                timing_report_seconds = std::atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            const char* speed = argv[++i];
+            if (strcmp(speed, "native") == 0) {
+                replay_speed = ReplayFrameSource::Speed::NATIVE;
+            } else if (strcmp(speed, "max") == 0) {
+                replay_speed = ReplayFrameSource::Speed::MAX;
+            } else {
+                std::cerr << "Unknown replay speed: " << speed << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--replay-loop") == 0) {
+            replay_loop = true;
+        } else if (strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) {
+            metrics_port = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--send-tiles") == 0 && i + 1 < argc) {
+            if (!NetworkOutputSink::parseEndpoints(argv[++i], tile_endpoints)) {
+                std::cerr << "--send-tiles expects HOST:PORT[,HOST:PORT...]" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &tile_width, &tile_height) != 2 || tile_width <= 0 || tile_height <= 0) {
+                std::cerr << "--tile-size expects WIDTHxHEIGHT" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--ambient-fps") == 0 && i + 1 < argc) {
+            ambient_fps = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--probe-fps") == 0 && i + 1 < argc) {
+            probe_fps = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--auto-mode") == 0) {
+            auto_mode = true;
+        } else if (strcmp(argv[i], "--motion-threshold") == 0 && i + 1 < argc) {
+            motion_threshold = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-threshold") == 0 && i + 1 < argc) {
+            idle_threshold = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            idle_timeout = std::atof(argv[++i]);
         } else {
             std::cerr << "Unknown option: " << argv[i] << std::endl;
             printUsage(argv[0]);
@@ -467,12 +904,66 @@ int main(int argc, char *argv[]) {
         std::cout << ", refresh-limit=" << limit_refresh_rate_hz << "Hz";
     }
     std::cout << std::endl;
+    if (pipelined) {
+        std::cout << "Capture: pipelined, drop-policy="
+                  << (drop_policy == FrameDropPolicy::DROP_OLDEST ? "oldest" : "newest");
+        if (drop_policy == FrameDropPolicy::DROP_NEWEST) {
+            std::cout << ", queue-depth=" << queue_depth;
+        }
+        std::cout << std::endl;
+    }
+    if (process_scale > 0) {
+        std::cout << "Processing resolution: " << cols * chain_length * process_scale << "x"
+                  << rows * parallel * process_scale << std::endl;
+    }
     std::cout << "=" << std::string(60, '=') << std::endl;
 
     CameraToMatrix app(width, height, rows, cols, chain_length, parallel, 
                        hardware_mapping, brightness, gpio_slowdown,
                        pwm_bits, pwm_dither_bits, pwm_lsb_nanoseconds, 
                        limit_refresh_rate_hz, sensor_width, sensor_height);
+    app.setPipelined(pipelined, queue_depth, drop_policy);
+    app.setScaleMode(scale_mode);
+    if (output_gamma > 0.0) {
+        app.setOutputCurve(output_gamma, output_dither);
+    }
+    if (process_scale > 0) {
+        app.getCore().setProcessingSize(cols * chain_length * process_scale,
+                                        rows * parallel * process_scale);
+    }
+    app.getCore().setAllocationCheck(check_allocs);
+    if (compact_history) {
+        app.getCore().setHistoryFormat(FrameHistory::Format::BGR565);
+    }
+    app.getCore().setBackgroundModel(bg_model);
+    app.getCore().setSegmentationRate(segment_every, segment_change);
+    if (state_file) {
+        app.getCore().setStateFile(state_file);
+    }
+    app.getCore().setTransitionDuration(transition_frames);
+    if (target_fps > 0.0 || target_temp > 0.0f) {
+        app.setQualityGovernor(target_fps, target_temp);
+    }
+    app.setIdleRendering(ambient_fps, probe_fps);
+    app.setStageTiming(stage_timing, timing_report_seconds);
+    app.setMetricsPort(metrics_port);
+    if (!tile_endpoints.empty() && !app.setTileOutput(tile_endpoints, tile_width, tile_height, scale_mode)) {
+        return 1;
+    }
+    if (record_path && !app.setRecording(record_path)) {
+        return 1;
+    }
+    if (replay_path && !app.setReplay(replay_path, replay_speed, replay_loop)) {
+        return 1;
+    }
+    // Idle probe frames are only useful if activity can switch the mode back
+    if (auto_mode || ambient_fps > 0.0) {
+        app.getCore().setActivityThresholds(motion_threshold, idle_threshold);
+        app.getCore().setIdleTimeout(idle_timeout);
+        app.getCore().setAutoModeSwitching(true);
+        std::cout << "Automatic mode switching: active >= " << motion_threshold
+                  << ", idle < " << idle_threshold << " for " << idle_timeout << "s" << std::endl;
+    }
     
     app.run();
 
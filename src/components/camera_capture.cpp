@@ -1,8 +1,11 @@
 #include "components/camera_capture.h"
+#include "components/frame_recording.h"
 #include <iostream>
+#include <algorithm>
 #include <array>
 #include <cstdint>
 #include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
 
 // External running flag (defined in main)
@@ -11,8 +14,12 @@ extern volatile bool running;
 CameraCapture::CameraCapture(int width, int height, int sensor_width, int sensor_height) 
     : width_(width), height_(height), 
       sensor_width_(sensor_width), sensor_height_(sensor_height),
-      actual_width_(0), actual_height_(0),
-      allocator_(nullptr), frame_callback_connected_(false) {
+      actual_width_(0), actual_height_(0), stride_(0),
+      allocator_(nullptr), frame_callback_connected_(false),
+      pipelined_(false), queue_depth_(2), drop_policy_(FrameDropPolicy::DROP_OLDEST),
+      worker_running_(false), dropped_frames_(0),
+      frame_duration_us_(DEFAULT_FRAME_DURATION_US), frame_duration_pending_(false),
+      last_capture_latency_ns_(0) {
     setup();
 }
 
@@ -62,7 +69,8 @@ void CameraCapture::start() {
         std::cout << "Will request sensor mode ~" << sensor_width_ << "x" << sensor_height_ 
                   << " via ScalerCrop for FOV control" << std::endl;
     }
-    std::cout << "Requesting ~120fps via FrameDurationLimits (8333us)" << std::endl;
+    std::cout << "Requesting ~" << static_cast<int>(getFrameRateLimit() + 0.5)
+              << "fps via FrameDurationLimits (" << frame_duration_us_.load() << "us)" << std::endl;
     
     config->validate();
 
@@ -74,7 +82,9 @@ void CameraCapture::start() {
     // Store actual stream dimensions after configure (may differ after validate/configure)
     actual_width_ = config->at(0).size.width;
     actual_height_ = config->at(0).size.height;
-    std::cout << "Actual configured stream: " << actual_width_ << "x" << actual_height_ << std::endl;
+    stride_ = config->at(0).stride;
+    std::cout << "Actual configured stream: " << actual_width_ << "x" << actual_height_
+              << " (stride " << stride_ << " bytes)" << std::endl;
 
     // Allocate buffers
     allocator_ = new FrameBufferAllocator(camera_);
@@ -86,6 +96,12 @@ void CameraCapture::start() {
         }
     }
 
+    // Map every buffer once up front so completed frames reach the callback without any VM work
+    if (!mapBuffers(config->at(0).stream())) {
+        std::cerr << "Failed to map frame buffers" << std::endl;
+        return;
+    }
+
     // Start camera
     if (camera_->start()) {
         std::cerr << "Failed to start camera" << std::endl;
@@ -112,6 +128,21 @@ void CameraCapture::start() {
         }
     }
 
+    // Start the processing thread before any request can complete
+    if (pipelined_) {
+        // DROP_OLDEST keeps every buffer queueable so the producer never has to refuse a frame;
+        // the worker does the dropping. DROP_NEWEST bounds the backlog at queue_depth_.
+        size_t capacity = static_cast<size_t>(queue_depth_);
+        if (drop_policy_ == FrameDropPolicy::DROP_OLDEST) {
+            capacity = allocator_->buffers(config->at(0).stream()).size();
+        }
+        frame_queue_ = std::make_unique<FrameQueue<Request*>>(capacity);
+        startWorker();
+        std::cout << "Pipelined capture enabled (queue=" << capacity << ", policy="
+                  << (drop_policy_ == FrameDropPolicy::DROP_OLDEST ? "drop-oldest" : "drop-newest")
+                  << ")" << std::endl;
+    }
+
     // Create and queue requests
     for (const StreamConfiguration &cfg : *config) {
         const std::vector<std::unique_ptr<FrameBuffer>> &buffers = allocator_->buffers(cfg.stream());
@@ -132,7 +163,8 @@ void CameraCapture::start() {
             // Request high FPS by constraining frame duration.
             // FrameDurationLimits is in microseconds. 120 fps -> 8333 us.
             // Note: If exposure exceeds this, the camera may still not reach 120 fps in low light.
-            const std::array<int64_t, 2> frame_duration_limits = {8333, 8333};
+            const int64_t frame_duration = frame_duration_us_.load();
+            const std::array<int64_t, 2> frame_duration_limits = {frame_duration, frame_duration};
             request->controls().set(controls::FrameDurationLimits, frame_duration_limits);
             
             // Set ScalerCrop to control sensor mode / FOV
@@ -146,12 +178,14 @@ void CameraCapture::start() {
 }
 
 void CameraCapture::stop() {
+    // Join the worker first so no request is re-queued while the camera is stopping
+    stopWorker();
     if (camera_) {
         camera_->stop();
     }
 }
 
-void CameraCapture::setFrameCallback(std::function<void(uint8_t*, int, int)> callback) {
+void CameraCapture::setFrameCallback(std::function<void(uint8_t*, int, int, int)> callback) {
     frame_callback_ = callback;
     // Connect callback signal if camera is available
     if (camera_ && !frame_callback_connected_) {
@@ -160,6 +194,23 @@ void CameraCapture::setFrameCallback(std::function<void(uint8_t*, int, int)> cal
     }
 }
 
+void CameraCapture::setFrameRateLimit(double fps) {
+    int64_t duration = (fps > 0.0) ? static_cast<int64_t>(1000000.0 / fps) : DEFAULT_FRAME_DURATION_US;
+    if (duration == frame_duration_us_.load()) return;
+    frame_duration_us_ = duration;
+    frame_duration_pending_ = true;
+}
+
+double CameraCapture::getFrameRateLimit() const {
+    return 1000000.0 / static_cast<double>(frame_duration_us_.load());
+}
+
+void CameraCapture::setPipelined(bool enabled, int queue_depth, FrameDropPolicy policy) {
+    pipelined_ = enabled;
+    queue_depth_ = std::max(1, queue_depth);
+    drop_policy_ = policy;
+}
+
 void CameraCapture::setup() {
     camera_manager_ = std::make_unique<CameraManager>();
     camera_manager_->start();
@@ -175,39 +226,156 @@ void CameraCapture::setup() {
 }
 
 void CameraCapture::processRequest(Request *request) {
+    // Requests are cancelled while the camera stops; they must not be re-queued
+    if (request->status() == Request::RequestCancelled) return;
     if (!running || !frame_callback_) return;
-    
-    // Process frame
+
+    if (pipelined_) {
+        if (frame_queue_->push(request)) {
+            {
+                std::lock_guard<std::mutex> lock(worker_mutex_);
+            }
+            worker_wake_.notify_one();
+        } else {
+            // Queue full (DROP_NEWEST): hand the buffer straight back to the sensor
+            dropped_frames_++;
+            requeueRequest(request);
+        }
+        return;
+    }
+
+    deliverFrame(request);
+    requeueRequest(request);
+}
+
+bool CameraCapture::mapBuffers(Stream *stream) {
+    const std::vector<std::unique_ptr<FrameBuffer>> &buffers = allocator_->buffers(stream);
+    for (const std::unique_ptr<FrameBuffer> &buffer : buffers) {
+        // Map from the start of the dmabuf so plane.offset needs no page alignment
+        const FrameBuffer::Plane &plane = buffer->planes()[0];
+        size_t length = plane.offset + plane.length;
+        void *address = mmap(nullptr, length, PROT_READ, MAP_SHARED, plane.fd.get(), 0);
+        if (address == MAP_FAILED) {
+            return false;
+        }
+
+        if (plane.length < static_cast<size_t>(stride_) * actual_height_) {
+            std::cerr << "Warning: plane is smaller than stride x height (" << plane.length
+                      << " < " << (static_cast<size_t>(stride_) * actual_height_) << ")" << std::endl;
+        }
+
+        buffer->setCookie(buffer_data_.size());
+        buffer_data_.push_back(static_cast<uint8_t*>(address) + plane.offset);
+        mappings_.push_back({address, length});
+    }
+    return true;
+}
+
+void CameraCapture::unmapBuffers() {
+    for (const BufferMapping &mapping : mappings_) {
+        munmap(mapping.address, mapping.length);
+    }
+    mappings_.clear();
+    buffer_data_.clear();
+}
+
+void CameraCapture::deliverFrame(Request *request) {
+    // SensorTimestamp is on CLOCK_BOOTTIME
+    const auto sensor_timestamp = request->metadata().get(controls::SensorTimestamp);
+    if (sensor_timestamp) {
+        struct timespec now;
+        clock_gettime(CLOCK_BOOTTIME, &now);
+        int64_t now_ns = static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+        int64_t latency = now_ns - *sensor_timestamp;
+        last_capture_latency_ns_ = latency > 0 ? static_cast<uint64_t>(latency) : 0;
+    } else {
+        last_capture_latency_ns_ = 0;
+    }
+
     const Request::BufferMap &buffers = request->buffers();
     for (auto it = buffers.begin(); it != buffers.end(); ++it) {
         FrameBuffer *buffer = it->second;
         const FrameMetadata &metadata = buffer->metadata();
 
-        if (metadata.status == FrameMetadata::FrameSuccess) {
-            // Get frame data
-            const FrameBuffer::Plane &plane = buffer->planes()[0];
-            void *data = mmap(nullptr, plane.length, PROT_READ, MAP_SHARED, plane.fd.get(), 0);
-            
-            if (data != MAP_FAILED) {
-                // Call the frame callback with actual camera dimensions
-                frame_callback_(static_cast<uint8_t*>(data), actual_width_, actual_height_);
-                munmap(data, plane.length);
+        if (metadata.status == FrameMetadata::FrameSuccess && buffer->cookie() < buffer_data_.size()) {
+            // Zero-copy: hand out the persistent mapping of this buffer
+            uint8_t *data = buffer_data_[buffer->cookie()];
+            if (recorder_) {
+                recorder_->record(data, actual_width_, actual_height_, stride_, PixelOrder::BGR,
+                                  sensor_timestamp ? static_cast<uint64_t>(*sensor_timestamp) : 0);
             }
+            frame_callback_(data, actual_width_, actual_height_, stride_);
         }
     }
+}
 
+void CameraCapture::requeueRequest(Request *request) {
     // Re-queue request
     request->reuse(Request::ReuseBuffers);
 
+    // Controls persist in the pipeline once applied, so a changed limit only needs to
+    // ride on one request
+    if (frame_duration_pending_.exchange(false)) {
+        const int64_t frame_duration = frame_duration_us_.load();
+        const std::array<int64_t, 2> frame_duration_limits = {frame_duration, frame_duration};
+        request->controls().set(controls::FrameDurationLimits, frame_duration_limits);
+    }
+
     camera_->queueRequest(request);
 }
 
+void CameraCapture::startWorker() {
+    worker_running_ = true;
+    worker_thread_ = std::thread(&CameraCapture::workerLoop, this);
+}
+
+void CameraCapture::stopWorker() {
+    if (!worker_thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        worker_running_ = false;
+    }
+    worker_wake_.notify_one();
+    worker_thread_.join();
+}
+
+void CameraCapture::workerLoop() {
+    while (worker_running_) {
+        Request *request = nullptr;
+        if (!frame_queue_->pop(request)) {
+            std::unique_lock<std::mutex> lock(worker_mutex_);
+            worker_wake_.wait(lock, [this] {
+                return !worker_running_ || !frame_queue_->empty();
+            });
+            continue;
+        }
+
+        if (drop_policy_ == FrameDropPolicy::DROP_OLDEST) {
+            // Latest wins: recycle everything that queued up behind a slow frame
+            Request *newer = nullptr;
+            while (frame_queue_->pop(newer)) {
+                dropped_frames_++;
+                requeueRequest(request);
+                request = newer;
+            }
+        }
+
+        if (running) {
+            deliverFrame(request);
+        }
+        requeueRequest(request);
+    }
+}
+
 void CameraCapture::cleanup() {
+    stopWorker();
     if (camera_) {
         camera_->stop();
         camera_->release();
         camera_.reset();
     }
+    // Buffers must stay mapped until the camera has stopped using them
+    unmapBuffers();
     if (allocator_) {
         delete allocator_;
         allocator_ = nullptr;
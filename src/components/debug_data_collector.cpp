@@ -1,14 +1,102 @@
 #include "components/debug_data_collector.h"
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
+#include <sstream>
+
+LatencyHistogram::LatencyHistogram()
+    : sum_ns_(0) {
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+        reported_[i] = 0;
+    }
+}
+
+int LatencyHistogram::bucketFor(uint64_t micros) {
+    if (micros < 8) return static_cast<int>(micros);
+    // 8 sub-buckets per power of two: exponent picks the group, the next three bits the slot
+    int exponent = 63 - __builtin_clzll(micros);
+    int sub = static_cast<int>((micros >> (exponent - 3)) & 7);
+    return std::min(NUM_BUCKETS - 1, 8 * (exponent - 2) + sub);
+}
+
+double LatencyHistogram::bucketUpperMicros(int bucket) {
+    if (bucket < 8) return bucket + 1.0;
+    int exponent = bucket / 8 + 2;
+    int sub = bucket % 8;
+    return static_cast<double>((8 + sub + 1) * (uint64_t(1) << (exponent - 3)));
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets_[bucketFor(nanoseconds / 1000)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::snapshot(Snapshot& out) const {
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        out.counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    out.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+}
+
+LatencyHistogram::Summary LatencyHistogram::takeSummary() {
+    uint64_t counts[NUM_BUCKETS];
+    Summary summary;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        uint64_t total = buckets_[i].load(std::memory_order_relaxed);
+        counts[i] = total - reported_[i];
+        reported_[i] = total;
+        summary.count += counts[i];
+    }
+    if (summary.count == 0) return summary;
+
+    // Nearest-rank percentiles, reported as the bucket's upper bound
+    const uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+    const uint64_t p95_rank = (summary.count * 95 + 99) / 100;
+    const uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+    uint64_t cumulative = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        if (counts[i] == 0) continue;
+        uint64_t before = cumulative;
+        cumulative += counts[i];
+        double upper_ms = bucketUpperMicros(i) / 1000.0;
+        if (before < p50_rank && cumulative >= p50_rank) summary.p50_ms = upper_ms;
+        if (before < p95_rank && cumulative >= p95_rank) summary.p95_ms = upper_ms;
+        if (before < p99_rank && cumulative >= p99_rank) summary.p99_ms = upper_ms;
+        summary.max_ms = upper_ms;
+    }
+    return summary;
+}
 
 DebugDataCollector::DebugDataCollector()
     : frame_count_(0),
       last_fps_time_(std::chrono::steady_clock::now()),
-      current_fps_(0.0) {
+      current_fps_(0.0),
+      frames_total_(0),
+      current_effect_(0),
+      system_mode_(0),
+      dropped_total_(0),
+      dropped_reported_(0),
+      temperature_(0.0f),
+      throttled_(-1),
+      sampler_running_(true) {
+    temperature_ = readTemperature();
+    throttled_ = readThrottled();
+    sampler_thread_ = std::thread(&DebugDataCollector::samplerLoop, this);
+}
+
+DebugDataCollector::~DebugDataCollector() {
+    {
+        std::lock_guard<std::mutex> lock(sampler_mutex_);
+        sampler_running_ = false;
+    }
+    sampler_wake_.notify_one();
+    sampler_thread_.join();
 }
 
 void DebugDataCollector::recordFrame() {
     frame_count_++;
+    frames_total_.fetch_add(1, std::memory_order_relaxed);
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_fps_time_).count();
     
@@ -24,7 +112,62 @@ double DebugDataCollector::getFPS() const {
 }
 
 float DebugDataCollector::getTemperature() const {
-    return readTemperature();
+    return temperature_.load();
+}
+
+void DebugDataCollector::recordStage(Stage stage, uint64_t nanoseconds) {
+    stages_[static_cast<int>(stage)].record(nanoseconds);
+}
+
+void DebugDataCollector::recordEffect(int effect, uint64_t nanoseconds) {
+    if (effect < 0 || effect >= NUM_EFFECT_BINS) effect = 0;
+    effects_[effect].record(nanoseconds);
+}
+
+const char* DebugDataCollector::stageName(Stage stage) {
+    static const char* stage_names[] = {"capture", "process", "display", "vsync"};
+    return stage_names[static_cast<int>(stage)];
+}
+
+std::string DebugDataCollector::takeReport() {
+    uint64_t dropped_total = dropped_total_.load();
+    uint64_t dropped = dropped_total - dropped_reported_;
+    dropped_reported_ = dropped_total;
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1)
+           << "[TIMING] fps " << getFPS() << " | dropped " << dropped
+           << " | temp " << getTemperature() << "C\n";
+
+    auto appendLine = [&report](const std::string& name, const LatencyHistogram::Summary& s) {
+        report << "  " << std::left << std::setw(10) << name << std::right
+               << " n=" << s.count << std::setprecision(2)
+               << " p50=" << s.p50_ms << "ms p95=" << s.p95_ms
+               << "ms p99=" << s.p99_ms << "ms max=" << s.max_ms << "ms\n"
+               << std::setprecision(1);
+    };
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        LatencyHistogram::Summary summary = stages_[i].takeSummary();
+        if (summary.count > 0) appendLine(stageName(static_cast<Stage>(i)), summary);
+    }
+    for (int i = 0; i < NUM_EFFECT_BINS; i++) {
+        LatencyHistogram::Summary summary = effects_[i].takeSummary();
+        if (summary.count == 0) continue;
+        appendLine(i == 0 ? std::string("panels") : "effect " + std::to_string(i), summary);
+    }
+    return report.str();
+}
+
+void DebugDataCollector::samplerLoop() {
+    std::unique_lock<std::mutex> lock(sampler_mutex_);
+    while (sampler_running_) {
+        sampler_wake_.wait_for(lock, std::chrono::seconds(1), [this] { return !sampler_running_; });
+        if (!sampler_running_) break;
+        lock.unlock();
+        temperature_ = readTemperature();
+        throttled_ = readThrottled();
+        lock.lock();
+    }
 }
 
 float DebugDataCollector::readTemperature() const {
@@ -37,3 +180,37 @@ float DebugDataCollector::readTemperature() const {
     }
     return 0.0f;  // Return 0 if unable to read
 }
+
+int DebugDataCollector::readThrottled() const {
+    // Raspberry Pi firmware driver; hex bitmask (bit 0 under-voltage, bit 2 throttled,
+    // bit 3 soft temperature limit, bits 16-19 the same conditions since boot)
+    std::ifstream throttled_file("/sys/devices/platform/soc/soc:firmware/get_throttled");
+    if (throttled_file.is_open()) {
+        int value;
+        if (throttled_file >> std::hex >> value) {
+            return value;
+        }
+    }
+    return -1;
+}
+
+DebugDataCollector::ScopedTimer::ScopedTimer(DebugDataCollector* collector, Stage stage)
+    : ScopedTimer(collector, stage, -1) {
+}
+
+DebugDataCollector::ScopedTimer::ScopedTimer(DebugDataCollector* collector, Stage stage, int effect)
+    : collector_(collector),
+      stage_(stage),
+      effect_(effect),
+      start_(collector ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {
+}
+
+DebugDataCollector::ScopedTimer::~ScopedTimer() {
+    if (!collector_) return;
+    uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+    collector_->recordStage(stage_, elapsed);
+    if (effect_ >= 0) {
+        collector_->recordEffect(effect_, elapsed);
+    }
+}
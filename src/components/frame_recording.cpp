@@ -0,0 +1,272 @@
+#include "components/frame_recording.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+const char RECORDING_MAGIC[8] = {'R', 'P', 'I', 'M', 'R', 'E', 'C', '1'};
+constexpr size_t HEADER_BYTES = 64;
+constexpr size_t RECORD_ALIGN = 64;            // Pixel data starts on a cache line
+constexpr size_t MIN_GROWTH = 64 * 1024 * 1024;  // Remap rarely: grow by >= 64MB
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t pixel_order;   // 0 = BGR, 1 = RGB
+    uint64_t frame_bytes;   // stride * height
+    uint64_t record_bytes;  // Timestamp + padding + frame, rounded up to RECORD_ALIGN
+    uint64_t frame_count;
+    uint8_t reserved[HEADER_BYTES - 48];
+};
+static_assert(sizeof(RecordingHeader) == HEADER_BYTES, "recording header must stay 64 bytes");
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint64_t steadyNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+FrameRecorder::FrameRecorder()
+    : fd_(-1),
+      order_(PixelOrder::BGR),
+      mapping_(nullptr),
+      mapping_size_(0),
+      width_(0),
+      height_(0),
+      stride_(0),
+      frame_bytes_(0),
+      record_bytes_(0),
+      frame_count_(0),
+      size_mismatch_logged_(false) {
+}
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+bool FrameRecorder::open(const std::string& path) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Recording: failed to create " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    path_ = path;
+    width_ = height_ = stride_ = 0;
+    frame_bytes_ = record_bytes_ = 0;
+    frame_count_ = 0;
+    size_mismatch_logged_ = false;
+    std::cout << "Recording frames to " << path << std::endl;
+    return true;
+}
+
+bool FrameRecorder::reserve(size_t bytes) {
+    if (bytes <= mapping_size_) return true;
+
+    size_t new_size = std::max(bytes, mapping_size_ + std::max(mapping_size_, MIN_GROWTH));
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(new_size)) != 0) {
+        std::cerr << "Recording: failed to grow " << path_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    void* address = mmap(nullptr, new_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (address == MAP_FAILED) {
+        std::cerr << "Recording: failed to map " << path_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    mapping_ = static_cast<uint8_t*>(address);
+    mapping_size_ = new_size;
+    return true;
+}
+
+void FrameRecorder::writeHeader() {
+    RecordingHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+    header.width = static_cast<uint32_t>(width_);
+    header.height = static_cast<uint32_t>(height_);
+    header.stride = static_cast<uint32_t>(stride_);
+    header.pixel_order = order_ == PixelOrder::RGB ? 1 : 0;
+    header.frame_bytes = frame_bytes_;
+    header.record_bytes = record_bytes_;
+    header.frame_count = frame_count_;
+    memcpy(mapping_, &header, sizeof(header));
+}
+
+void FrameRecorder::record(const uint8_t* data, int width, int height, int stride, PixelOrder order,
+                           uint64_t timestamp_ns) {
+    if (fd_ < 0 || !data) return;
+
+    if (frame_count_ == 0 && width_ == 0) {
+        order_ = order;
+        width_ = width;
+        height_ = height;
+        stride_ = stride;
+        frame_bytes_ = static_cast<size_t>(stride) * height;
+        record_bytes_ = alignUp(RECORD_ALIGN + frame_bytes_, RECORD_ALIGN);
+    } else if (width != width_ || height != height_ || stride != stride_) {
+        if (!size_mismatch_logged_) {
+            std::cerr << "Recording: skipping " << width << "x" << height << " frames (recording is "
+                      << width_ << "x" << height_ << ")" << std::endl;
+            size_mismatch_logged_ = true;
+        }
+        return;
+    }
+
+    size_t offset = HEADER_BYTES + frame_count_ * record_bytes_;
+    if (!reserve(offset + record_bytes_)) {
+        close();
+        return;
+    }
+
+    uint8_t* record = mapping_ + offset;
+    uint64_t timestamp = timestamp_ns ? timestamp_ns : steadyNowNs();
+    memcpy(record, &timestamp, sizeof(timestamp));
+    // The last row may end at width * 3 in the source buffer, so don't read its padding
+    size_t bytes = static_cast<size_t>(stride) * (height - 1) + static_cast<size_t>(width) * 3;
+    memcpy(record + RECORD_ALIGN, data, bytes);
+
+    frame_count_++;
+    // Keep the header current so a recording cut short by a crash still replays
+    writeHeader();
+}
+
+void FrameRecorder::close() {
+    if (fd_ < 0) return;
+
+    if (mapping_) {
+        writeHeader();
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        mapping_size_ = 0;
+    }
+    size_t used = frame_count_ > 0 ? HEADER_BYTES + frame_count_ * record_bytes_ : 0;
+    if (ftruncate(fd_, static_cast<off_t>(used)) != 0) {
+        std::cerr << "Recording: failed to trim " << path_ << ": " << strerror(errno) << std::endl;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    std::cout << "Recorded " << frame_count_ << " frames to " << path_ << std::endl;
+}
+
+ReplayFrameSource::ReplayFrameSource(const std::string& path, Speed speed, bool loop)
+    : speed_(speed),
+      loop_(loop),
+      mapping_(nullptr),
+      mapping_size_(0),
+      width_(0),
+      height_(0),
+      stride_(0),
+      order_(PixelOrder::BGR),
+      header_bytes_(HEADER_BYTES),
+      record_bytes_(0),
+      frame_count_(0),
+      next_frame_(0),
+      pass_first_timestamp_(0) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Replay: failed to open " << path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_BYTES) {
+        std::cerr << "Replay: " << path << " is not a frame recording" << std::endl;
+        ::close(fd);
+        return;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file alive
+    if (address == MAP_FAILED) {
+        std::cerr << "Replay: failed to map " << path << ": " << strerror(errno) << std::endl;
+        return;
+    }
+
+    RecordingHeader header;
+    memcpy(&header, address, sizeof(header));
+    // Every size in 64 bits, and frame_bytes tied to the geometry read() hands out, so a
+    // corrupt header cannot produce views past the end of the mapping
+    uint64_t min_stride = static_cast<uint64_t>(header.width) * 3;
+    uint64_t geometry_bytes = static_cast<uint64_t>(header.stride) * header.height;
+    bool valid = memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.width > 0 && header.height > 0 &&
+                 header.height <= static_cast<uint32_t>(INT_MAX) &&
+                 header.stride <= static_cast<uint32_t>(INT_MAX) && header.stride >= min_stride &&
+                 header.frame_bytes == geometry_bytes &&
+                 header.record_bytes >= RECORD_ALIGN + geometry_bytes;
+    if (!valid) {
+        std::cerr << "Replay: " << path << " is not a frame recording" << std::endl;
+        munmap(address, size);
+        return;
+    }
+
+    madvise(address, size, MADV_SEQUENTIAL);
+    mapping_ = static_cast<const uint8_t*>(address);
+    mapping_size_ = size;
+    width_ = static_cast<int>(header.width);
+    height_ = static_cast<int>(header.height);
+    stride_ = static_cast<int>(header.stride);
+    order_ = header.pixel_order == 1 ? PixelOrder::RGB : PixelOrder::BGR;
+    record_bytes_ = header.record_bytes;
+    // Trust the file size over the header if the recorder never got to close()
+    frame_count_ = std::min<uint64_t>(header.frame_count, (size - HEADER_BYTES) / record_bytes_);
+
+    std::cout << "Replaying " << frame_count_ << " frames (" << width_ << "x" << height_
+              << ") from " << path << (speed_ == Speed::MAX ? " at maximum speed" : "") << std::endl;
+}
+
+ReplayFrameSource::~ReplayFrameSource() {
+    if (mapping_) {
+        munmap(const_cast<uint8_t*>(mapping_), mapping_size_);
+    }
+}
+
+bool ReplayFrameSource::read(FrameView& frame) {
+    if (!mapping_ || frame_count_ == 0) return false;
+    if (next_frame_ >= frame_count_) {
+        if (!loop_) return false;
+        next_frame_ = 0;
+    }
+
+    const uint8_t* record = mapping_ + header_bytes_ + next_frame_ * record_bytes_;
+    uint64_t timestamp;
+    memcpy(&timestamp, record, sizeof(timestamp));
+
+    if (speed_ == Speed::NATIVE) {
+        if (next_frame_ == 0) {
+            pass_start_ = std::chrono::steady_clock::now();
+            pass_first_timestamp_ = timestamp;
+        } else if (timestamp > pass_first_timestamp_) {
+            std::this_thread::sleep_until(pass_start_ + std::chrono::nanoseconds(timestamp - pass_first_timestamp_));
+        }
+    }
+
+    frame.data = record + RECORD_ALIGN;
+    frame.width = width_;
+    frame.height = height_;
+    frame.stride = stride_;
+    frame.order = order_;
+    frame.timestamp_ns = timestamp;
+    next_frame_++;
+    return true;
+}
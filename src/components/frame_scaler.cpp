@@ -0,0 +1,150 @@
+#include "components/frame_scaler.h"
+
+#include <algorithm>
+#include <cstring>
+
+FrameScaler::FrameScaler(Mode mode)
+    : mode_(mode),
+      src_width_(0), src_height_(0),
+      dst_width_(0), dst_height_(0) {
+}
+
+void FrameScaler::setMode(Mode mode) {
+    mode_ = mode;
+}
+
+void FrameScaler::setOutputCurve(const OutputCurve::Settings& settings) {
+    curve_.configure(settings);
+}
+
+void FrameScaler::configure(int src_width, int src_height, int dst_width, int dst_height) {
+    if (src_width == src_width_ && src_height == src_height_ &&
+        dst_width == dst_width_ && dst_height == dst_height_) {
+        return;
+    }
+    src_width_ = src_width;
+    src_height_ = src_height;
+    dst_width_ = dst_width;
+    dst_height_ = dst_height;
+
+    // Same mapping as the old (x * width) / matrix_width sampling, computed once
+    col_begin_.resize(dst_width_);
+    col_end_.resize(dst_width_);
+    for (int x = 0; x < dst_width_; x++) {
+        int begin = (x * src_width_) / dst_width_;
+        int end = ((x + 1) * src_width_) / dst_width_;
+        col_begin_[x] = begin * 3;
+        col_end_[x] = std::max(begin + 1, end) * 3;
+    }
+
+    row_begin_.resize(dst_height_);
+    row_end_.resize(dst_height_);
+    for (int y = 0; y < dst_height_; y++) {
+        int begin = (y * src_height_) / dst_height_;
+        int end = ((y + 1) * src_height_) / dst_height_;
+        row_begin_[y] = begin;
+        row_end_[y] = std::max(begin + 1, end);
+    }
+
+    row_sums_.assign(dst_width_ * 3, 0);
+}
+
+void FrameScaler::scale(const uint8_t *src, int src_width, int src_height, int src_stride,
+                        PixelOrder order, uint8_t *dst_rgb, int dst_width, int dst_height) {
+    if (!src || !dst_rgb || src_width <= 0 || src_height <= 0 ||
+        dst_width <= 0 || dst_height <= 0) {
+        return;
+    }
+    if (src_stride <= 0) src_stride = src_width * 3;
+
+    configure(src_width, src_height, dst_width, dst_height);
+    curve_.beginFrame();
+
+    if (src_width == dst_width && src_height == dst_height) {
+        // Already at matrix resolution (e.g. effects rendered at matrix size)
+        copyRows(src, src_stride, order, dst_rgb);
+    } else if (mode_ == Mode::AREA) {
+        scaleArea(src, src_stride, order, dst_rgb);
+    } else {
+        scaleNearest(src, src_stride, order, dst_rgb);
+    }
+}
+
+void FrameScaler::copyRows(const uint8_t *src, int src_stride, PixelOrder order, uint8_t *dst_rgb) {
+    const size_t row_bytes = static_cast<size_t>(dst_width_) * 3;
+    for (int y = 0; y < dst_height_; y++) {
+        const uint8_t *in = src + static_cast<size_t>(y) * src_stride;
+        uint8_t *out = dst_rgb + y * row_bytes;
+        if (order == PixelOrder::RGB) {
+            std::memcpy(out, in, row_bytes);
+        } else {
+            for (int x = 0; x < dst_width_; x++, in += 3, out += 3) {
+                out[0] = in[2];
+                out[1] = in[1];
+                out[2] = in[0];
+            }
+        }
+        curve_.applyRow(dst_rgb + y * row_bytes, dst_width_, y);
+    }
+}
+
+void FrameScaler::scaleNearest(const uint8_t *src, int src_stride, PixelOrder order, uint8_t *dst_rgb) {
+    // Channel positions of R and B in the source pixel
+    const int r = (order == PixelOrder::RGB) ? 0 : 2;
+    const int b = 2 - r;
+    const int *cols = col_begin_.data();
+
+    uint8_t *out = dst_rgb;
+    for (int y = 0; y < dst_height_; y++) {
+        uint8_t *out_row = out;
+        const uint8_t *row = src + static_cast<size_t>(row_begin_[y]) * src_stride;
+        for (int x = 0; x < dst_width_; x++, out += 3) {
+            const uint8_t *px = row + cols[x];
+            out[0] = px[r];
+            out[1] = px[1];
+            out[2] = px[b];
+        }
+        curve_.applyRow(out_row, dst_width_, y);
+    }
+}
+
+void FrameScaler::scaleArea(const uint8_t *src, int src_stride, PixelOrder order, uint8_t *dst_rgb) {
+    const int r = (order == PixelOrder::RGB) ? 0 : 2;
+    const int b = 2 - r;
+
+    uint8_t *out = dst_rgb;
+    for (int y = 0; y < dst_height_; y++) {
+        std::fill(row_sums_.begin(), row_sums_.end(), 0u);
+
+        // Accumulate every source row covered by this output row
+        for (int sy = row_begin_[y]; sy < row_end_[y]; sy++) {
+            const uint8_t *row = src + static_cast<size_t>(sy) * src_stride;
+            uint32_t *sum = row_sums_.data();
+            for (int x = 0; x < dst_width_; x++, sum += 3) {
+                const uint8_t *px = row + col_begin_[x];
+                const uint8_t *px_end = row + col_end_[x];
+                uint32_t s0 = 0, s1 = 0, s2 = 0;
+                for (; px < px_end; px += 3) {
+                    s0 += px[0];
+                    s1 += px[1];
+                    s2 += px[2];
+                }
+                sum[0] += s0;
+                sum[1] += s1;
+                sum[2] += s2;
+            }
+        }
+
+        const uint32_t rows = row_end_[y] - row_begin_[y];
+        const uint32_t *sum = row_sums_.data();
+        uint8_t *out_row = out;
+        for (int x = 0; x < dst_width_; x++, sum += 3, out += 3) {
+            const uint32_t count = rows * ((col_end_[x] - col_begin_[x]) / 3);
+            const uint32_t half = count / 2;  // Round to nearest
+            out[0] = static_cast<uint8_t>((sum[r] + half) / count);
+            out[1] = static_cast<uint8_t>((sum[1] + half) / count);
+            out[2] = static_cast<uint8_t>((sum[b] + half) / count);
+        }
+        curve_.applyRow(out_row, dst_width_, y);
+    }
+}
@@ -1,5 +1,11 @@
 #include "components/matrix_display.h"
+
+#include <algorithm>
+#include <iostream>
 #include <led-matrix.h>
+#ifdef RGB_MATRIX_HAS_SET_PIXELS
+#include <graphics.h>
+#endif
 
 using rgb_matrix::RGBMatrix;
 using rgb_matrix::RuntimeOptions;
@@ -17,7 +23,8 @@ MatrixDisplay::MatrixDisplay(int rows, int cols, int chain_length, int parallel,
       pwm_bits_(pwm_bits), pwm_dither_bits_(pwm_dither_bits),
       pwm_lsb_nanoseconds_(pwm_lsb_nanoseconds),
       limit_refresh_rate_hz_(limit_refresh_rate_hz),
-      matrix_(nullptr), canvas_(nullptr) {
+      matrix_(nullptr), canvas_(nullptr),
+      input_order_(PixelOrder::BGR) {
     setup();
 }
 
@@ -37,33 +44,76 @@ int MatrixDisplay::getHeight() const {
     return canvas_ ? canvas_->height() : 0;
 }
 
-void MatrixDisplay::displayFrame(uint8_t *data, int width, int height, 
+void MatrixDisplay::setScaleMode(FrameScaler::Mode mode) {
+    scaler_.setMode(mode);
+}
+
+void MatrixDisplay::setInputOrder(PixelOrder order) {
+    input_order_ = order;
+}
+
+void MatrixDisplay::setOutputCurve(double gamma, bool dither) {
+    OutputCurve::Settings settings;
+    settings.gamma = gamma;
+    settings.brightness = brightness_;
+    settings.pwm_bits = pwm_bits_;
+    settings.dither = dither;
+    scaler_.setOutputCurve(settings);
+
+    // Our table is the whole transfer function: the library must show values linearly
+    bool enabled = gamma > 0.0;
+    if (matrix_) {
+        matrix_->set_luminance_correct(!enabled);
+        matrix_->SetBrightness(static_cast<uint8_t>(enabled ? 100 : brightness_));
+    }
+    if (enabled) {
+        std::cout << "Output curve: gamma " << gamma << ", brightness " << brightness_ << "%, "
+                  << std::min(8, pwm_bits_) << "-bit levels" << (dither ? ", dithered" : "") << std::endl;
+    }
+}
+
+void MatrixDisplay::displayFrame(uint8_t *data, int width, int height, int stride,
                                   std::function<void(FrameCanvas*)> overlay_callback) {
     if (!canvas_) return;
 
+    {
+        DebugDataCollector::ScopedTimer timer(timing_, DebugDataCollector::Stage::DISPLAY);
+        int matrix_width = canvas_->width();
+        int matrix_height = canvas_->height();
+        rgb_buffer_.resize(static_cast<size_t>(matrix_width) * matrix_height * 3);
+
+        // Resample into packed RGB using the precomputed source tables, then write it in bulk
+        scaler_.scale(data, width, height, stride, input_order_,
+                      rgb_buffer_.data(), matrix_width, matrix_height);
+        writeCanvas();
+        
+        // Call overlay callback if provided (before swapping canvas)
+        if (overlay_callback) {
+            overlay_callback(canvas_);
+        }
+    }
+
+    DebugDataCollector::ScopedTimer timer(timing_, DebugDataCollector::Stage::VSYNC);
+    canvas_ = matrix_->SwapOnVSync(canvas_);
+}
+
+void MatrixDisplay::writeCanvas() {
     int matrix_width = canvas_->width();
     int matrix_height = canvas_->height();
 
+#ifdef RGB_MATRIX_HAS_SET_PIXELS
+    // rgb_matrix::Color is three packed bytes, so the buffer can be handed over as-is
+    static_assert(sizeof(rgb_matrix::Color) == 3, "rgb_matrix::Color must be packed RGB");
+    canvas_->SetPixels(0, 0, matrix_width, matrix_height,
+                       reinterpret_cast<rgb_matrix::Color*>(rgb_buffer_.data()));
+#else
+    const uint8_t *px = rgb_buffer_.data();
     for (int y = 0; y < matrix_height; y++) {
-        for (int x = 0; x < matrix_width; x++) {
-            int src_x = (x * width) / matrix_width;
-            int src_y = (y * height) / matrix_height;
-            
-            int src_idx = (src_y * width + src_x) * 3;
-            // Input is BGR (OpenCV default and our app convention)
-            uint8_t b = data[src_idx];
-            uint8_t g = data[src_idx + 1];
-            uint8_t r = data[src_idx + 2];
-            canvas_->SetPixel(x, y, r, g, b);
+        for (int x = 0; x < matrix_width; x++, px += 3) {
+            canvas_->SetPixel(x, y, px[0], px[1], px[2]);
         }
     }
-    
-    // Call overlay callback if provided (before swapping canvas)
-    if (overlay_callback) {
-        overlay_callback(canvas_);
-    }
-
-    canvas_ = matrix_->SwapOnVSync(canvas_);
+#endif
 }
 
 void MatrixDisplay::setup() {
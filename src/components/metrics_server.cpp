@@ -0,0 +1,178 @@
+#include "components/metrics_server.h"
+#include "components/debug_data_collector.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// Write one histogram series in Prometheus form. Exported boundaries are the exact upper
+// bounds of every 4th fine bucket (12 * 2^k and 16 * 2^k us, ~36us to ~2s), so the coarse
+// le buckets stay correct without re-binning.
+void writeHistogram(std::ostringstream& out, const char* name, const std::string& labels,
+                    const LatencyHistogram& histogram) {
+    LatencyHistogram::Snapshot snapshot;
+    histogram.snapshot(snapshot);
+
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LatencyHistogram::NUM_BUCKETS; i++) {
+        cumulative += snapshot.counts[i];
+        double upper_us = LatencyHistogram::bucketUpperMicros(i);
+        if (i >= 24 && (i % 8 == 3 || i % 8 == 7) && upper_us <= 2097152.0) {
+            out << name << "_bucket{" << labels << ",le=\"" << upper_us / 1e6 << "\"} " << cumulative << "\n";
+        }
+    }
+    out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << cumulative << "\n";
+    out << name << "_sum{" << labels << "} " << snapshot.sum_ns / 1e9 << "\n";
+    out << name << "_count{" << labels << "} " << cumulative << "\n";
+}
+
+}  // namespace
+
+MetricsServer::MetricsServer(const DebugDataCollector& collector, int port)
+    : collector_(collector),
+      port_(port),
+      listen_fd_(-1),
+      running_(false) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    if (running_) return true;
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "Metrics: failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port_));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, 4) < 0) {
+        std::cerr << "Metrics: failed to listen on port " << port_ << ": " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::serveLoop, this);
+    std::cout << "Metrics endpoint: http://0.0.0.0:" << port_ << "/metrics" << std::endl;
+    return true;
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+void MetricsServer::serveLoop() {
+    pollfd listener{listen_fd_, POLLIN, 0};
+    while (running_) {
+        // Wake periodically to notice stop()
+        if (poll(&listener, 1, 250) <= 0 || !(listener.revents & POLLIN)) continue;
+
+        int client_fd = accept(listen_fd_, nullptr, nullptr);
+        if (client_fd < 0) continue;
+        handleClient(client_fd);
+        close(client_fd);
+    }
+}
+
+void MetricsServer::handleClient(int client_fd) {
+    // A stalled scraper must not wedge the server thread
+    timeval timeout{1, 0};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[1024];
+    ssize_t received = recv(client_fd, request, sizeof(request) - 1, 0);
+    if (received <= 0) return;
+    request[received] = '\0';
+
+    std::string response;
+    if (strncmp(request, "GET /metrics", 12) == 0 || strncmp(request, "GET / ", 6) == 0) {
+        std::string body = renderMetrics();
+        response = "HTTP/1.0 200 OK\r\n"
+                   "Content-Type: text/plain; version=0.0.4\r\n"
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                   "Connection: close\r\n\r\n" + body;
+    } else {
+        response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    }
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(client_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+std::string MetricsServer::renderMetrics() const {
+    std::ostringstream out;
+    out.precision(9);  // Bucket bounds are exact binary fractions of a second
+
+    out << "# HELP rpi_matrix_fps Frames shown per second (1s average)\n"
+        << "# TYPE rpi_matrix_fps gauge\n"
+        << "rpi_matrix_fps " << collector_.getFPS() << "\n"
+        << "# HELP rpi_matrix_frames_total Frames shown since start\n"
+        << "# TYPE rpi_matrix_frames_total counter\n"
+        << "rpi_matrix_frames_total " << collector_.getFrameCount() << "\n"
+        << "# HELP rpi_matrix_dropped_frames_total Frames dropped by the capture queue\n"
+        << "# TYPE rpi_matrix_dropped_frames_total counter\n"
+        << "rpi_matrix_dropped_frames_total " << collector_.getDroppedFrames() << "\n"
+        << "# HELP rpi_matrix_effect Effect on screen (1-9)\n"
+        << "# TYPE rpi_matrix_effect gauge\n"
+        << "rpi_matrix_effect " << collector_.getCurrentEffect() << "\n"
+        << "# HELP rpi_matrix_system_mode System mode (0 = ambient, 1 = active)\n"
+        << "# TYPE rpi_matrix_system_mode gauge\n"
+        << "rpi_matrix_system_mode " << collector_.getSystemMode() << "\n"
+        << "# HELP rpi_matrix_temperature_celsius CPU temperature\n"
+        << "# TYPE rpi_matrix_temperature_celsius gauge\n"
+        << "rpi_matrix_temperature_celsius " << collector_.getTemperature() << "\n"
+        << "# HELP rpi_matrix_throttled Firmware get_throttled bitmask (-1 = unavailable)\n"
+        << "# TYPE rpi_matrix_throttled gauge\n"
+        << "rpi_matrix_throttled " << collector_.getThrottled() << "\n";
+
+    out << "# HELP rpi_matrix_stage_latency_seconds Per-frame latency of each pipeline stage\n"
+        << "# TYPE rpi_matrix_stage_latency_seconds histogram\n";
+    for (int i = 0; i < static_cast<int>(DebugDataCollector::Stage::COUNT); i++) {
+        DebugDataCollector::Stage stage = static_cast<DebugDataCollector::Stage>(i);
+        writeHistogram(out, "rpi_matrix_stage_latency_seconds",
+                       std::string("stage=\"") + DebugDataCollector::stageName(stage) + "\"",
+                       collector_.getStageHistogram(stage));
+    }
+
+    out << "# HELP rpi_matrix_effect_latency_seconds processFrame time per effect (0 = multi-panel)\n"
+        << "# TYPE rpi_matrix_effect_latency_seconds histogram\n";
+    for (int bin = 0; bin < DebugDataCollector::NUM_EFFECT_BINS; bin++) {
+        writeHistogram(out, "rpi_matrix_effect_latency_seconds",
+                       "effect=\"" + std::to_string(bin) + "\"",
+                       collector_.getEffectHistogram(bin));
+    }
+
+    return out.str();
+}
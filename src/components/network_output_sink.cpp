@@ -0,0 +1,184 @@
+#include "components/network_output_sink.h"
+#include "components/tile_protocol.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+NetworkOutputSink::NetworkOutputSink(const std::vector<std::string>& endpoints, int tile_width,
+                                     int tile_height)
+    : fd_(-1),
+      tile_width_(std::max(1, std::min(tile_width, TILE_MAX_SIDE))),
+      tile_height_(std::max(1, std::min(tile_height, TILE_MAX_SIDE))),
+      keyframe_interval_(30),
+      session_(std::random_device()()),
+      sequence_(0),
+      dropped_datagrams_(0) {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        std::cerr << "Tiles: failed to create socket: " << strerror(errno) << std::endl;
+        return;
+    }
+    // Never stall the frame path on a full socket buffer
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+    int buffer_bytes = 1 << 20;
+    setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &buffer_bytes, sizeof(buffer_bytes));
+
+    tiles_.resize(endpoints.size());
+    for (size_t i = 0; i < endpoints.size(); i++) {
+        tiles_[i].endpoint = endpoints[i];
+        if (!resolve(endpoints[i], tiles_[i].address)) {
+            tiles_.clear();
+            return;
+        }
+        tiles_[i].pixels.resize(static_cast<size_t>(tile_width_) * tile_height_);
+    }
+    rgb_.resize(static_cast<size_t>(tile_width_) * tile_height_ * 3);
+    datagram_.resize(TILE_MAX_DATAGRAM + static_cast<size_t>(tile_width_) * 2);
+
+    std::cout << "Sending " << tiles_.size() << " tile(s) of " << tile_width_ << "x" << tile_height_
+              << " to";
+    for (const Tile& tile : tiles_) {
+        std::cout << " " << tile.endpoint;
+    }
+    std::cout << std::endl;
+}
+
+NetworkOutputSink::~NetworkOutputSink() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (dropped_datagrams_ > 0) {
+        std::cout << "Tiles: " << dropped_datagrams_ << " datagram(s) dropped (socket busy)" << std::endl;
+    }
+}
+
+bool NetworkOutputSink::resolve(const std::string& endpoint, sockaddr_in& address) {
+    size_t colon = endpoint.rfind(':');
+    std::string host = endpoint.substr(0, colon);
+    std::string port = endpoint.substr(colon + 1);
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (error != 0 || !result) {
+        std::cerr << "Tiles: cannot resolve " << endpoint << ": " << gai_strerror(error) << std::endl;
+        return false;
+    }
+    memcpy(&address, result->ai_addr, sizeof(address));
+    freeaddrinfo(result);
+    return true;
+}
+
+bool NetworkOutputSink::parseEndpoints(const char* list, std::vector<std::string>& endpoints) {
+    endpoints.clear();
+    std::string remaining(list);
+    while (!remaining.empty()) {
+        size_t comma = remaining.find(',');
+        std::string endpoint = remaining.substr(0, comma);
+        size_t colon = endpoint.rfind(':');
+        if (colon == std::string::npos || colon == 0 || colon + 1 == endpoint.size()) {
+            return false;
+        }
+        endpoints.push_back(endpoint);
+        if (comma == std::string::npos) break;
+        remaining = remaining.substr(comma + 1);
+    }
+    return !endpoints.empty();
+}
+
+void NetworkOutputSink::tileSpan(int frame_width, int count, int index, int& x, int& width) {
+    // As AppCore::processMultiPanel(): equal widths, the last tile takes the remainder
+    int tile_width = frame_width / count;
+    x = index * tile_width;
+    width = (index == count - 1) ? frame_width - x : tile_width;
+}
+
+void NetworkOutputSink::setScaleMode(FrameScaler::Mode mode) {
+    for (Tile& tile : tiles_) {
+        tile.scaler.setMode(mode);
+    }
+}
+
+void NetworkOutputSink::setKeyframeInterval(int interval) {
+    keyframe_interval_ = std::max(1, interval);
+}
+
+void NetworkOutputSink::writeFrame(const uint8_t* data, int width, int height, int stride,
+                                   PixelOrder order) {
+    if (!isReady() || !data) return;
+    int count = static_cast<int>(tiles_.size());
+    if (width < count) return;
+    if (stride == 0) stride = width * 3;
+
+    bool keyframe = sequence_ % keyframe_interval_ == 0;
+    for (int i = 0; i < count; i++) {
+        Tile& tile = tiles_[i];
+        int x, span;
+        tileSpan(width, count, i, x, span);
+        tile.scaler.scale(data + static_cast<size_t>(x) * 3, span, height, stride, order,
+                          rgb_.data(), tile_width_, tile_height_);
+
+        // Packed RGB -> RGB565 (5/6/5 bits, the receiver expands it again)
+        const uint8_t* px = rgb_.data();
+        for (uint16_t& out : tile.pixels) {
+            out = static_cast<uint16_t>(((px[0] & 0xF8) << 8) | ((px[1] & 0xFC) << 3) | (px[2] >> 3));
+            px += 3;
+        }
+        sendTile(tile, i, keyframe || tile.sent_pixels.empty());
+    }
+    sequence_++;
+}
+
+void NetworkOutputSink::sendTile(Tile& tile, int index, bool keyframe) {
+    TilePacketHeader header;
+    header.magic = TILE_MAGIC;
+    header.session = session_;
+    header.sequence = sequence_;
+    header.tile_index = static_cast<uint16_t>(index);
+    header.type = static_cast<uint16_t>(TilePacketType::ROWS);
+    header.width = static_cast<uint16_t>(tile_width_);
+    header.height = static_cast<uint16_t>(tile_height_);
+
+    const int rows_per_packet = tileRowsPerPacket(tile_width_);
+    for (int row = 0; row < tile_height_; row += rows_per_packet) {
+        int rows = std::min(rows_per_packet, tile_height_ - row);
+        size_t offset = static_cast<size_t>(row) * tile_width_;
+        size_t pixel_bytes = static_cast<size_t>(rows) * tile_width_ * sizeof(uint16_t);
+        // Delta: the receiver still shows the rows it got last time
+        if (!keyframe && memcmp(tile.pixels.data() + offset, tile.sent_pixels.data() + offset, pixel_bytes) == 0) {
+            continue;
+        }
+        header.row_start = static_cast<uint16_t>(row);
+        header.row_count = static_cast<uint16_t>(rows);
+        memcpy(datagram_.data(), &header, sizeof(header));
+        memcpy(datagram_.data() + sizeof(header), tile.pixels.data() + offset, pixel_bytes);
+        sendDatagram(tile, datagram_.data(), sizeof(header) + pixel_bytes);
+    }
+    tile.sent_pixels = tile.pixels;
+
+    header.type = static_cast<uint16_t>(TilePacketType::END);
+    header.row_start = 0;
+    header.row_count = 0;
+    sendDatagram(tile, reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+}
+
+void NetworkOutputSink::sendDatagram(Tile& tile, const uint8_t* data, size_t bytes) {
+    ssize_t sent = sendto(fd_, data, bytes, 0, reinterpret_cast<const sockaddr*>(&tile.address),
+                          sizeof(tile.address));
+    if (sent < 0) {
+        // EAGAIN: socket buffer full. ECONNREFUSED: receiver not running (yet).
+        dropped_datagrams_++;
+    }
+}
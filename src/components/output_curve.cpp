@@ -0,0 +1,77 @@
+#include "components/output_curve.h"
+
+#include <algorithm>
+#include <cmath>
+
+// 4x4 Bayer matrix: thresholds ranked 0..15, neighbours far apart in rank
+static const uint8_t BAYER_4X4[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+OutputCurve::OutputCurve()
+    : enabled_(false),
+      dither_(false),
+      phase_(0) {
+}
+
+void OutputCurve::configure(const Settings& settings, bool preview) {
+    enabled_ = settings.gamma > 0.0;
+    dither_ = enabled_ && settings.dither;
+    if (!enabled_) {
+        tables_.clear();
+        return;
+    }
+
+    const int bits = std::max(1, std::min(8, settings.pwm_bits));
+    const int max_level = (1 << bits) - 1;
+    const double scale = std::max(0, std::min(100, settings.brightness)) / 100.0;
+    const int tables = dither_ ? DITHER_PHASES : 1;
+    tables_.resize(static_cast<size_t>(tables) * 256);
+
+    for (int t = 0; t < tables; t++) {
+        // Without dithering every pixel rounds to the nearest level
+        const double threshold = dither_ ? (t + 0.5) / DITHER_PHASES : 0.5;
+        uint8_t* table = tables_.data() + t * 256;
+        for (int v = 0; v < 256; v++) {
+            double duty = std::pow(v / 255.0, settings.gamma) * scale;
+            int level = std::min(max_level, static_cast<int>(std::floor(duty * max_level + threshold)));
+            double shown = static_cast<double>(level) / max_level;
+            // The matrix (luminance correction off) shows byte/255 as duty cycle, and keeps
+            // the top pwm_bits of it, so levels land exactly on PWM steps
+            double encoded = preview ? std::pow(shown, 1.0 / settings.gamma) : shown;
+            table[v] = static_cast<uint8_t>(std::lround(encoded * 255.0));
+        }
+    }
+}
+
+void OutputCurve::beginFrame() {
+    // 7 is coprime with 16: every pixel visits all 16 thresholds every 16 frames
+    phase_ = (phase_ + 7) & (DITHER_PHASES - 1);
+}
+
+void OutputCurve::applyRow(uint8_t* row, int width, int y) const {
+    if (!enabled_) return;
+
+    if (!dither_) {
+        const uint8_t* table = tables_.data();
+        for (int i = 0; i < width * 3; i++) {
+            row[i] = table[row[i]];
+        }
+        return;
+    }
+
+    // The pattern repeats every 4 columns: resolve this row's 4 tables once
+    const uint8_t* tables[4];
+    for (int x = 0; x < 4; x++) {
+        tables[x] = tables_.data() + ((BAYER_4X4[y & 3][x] + phase_) & (DITHER_PHASES - 1)) * 256;
+    }
+    for (int x = 0; x < width; x++, row += 3) {
+        const uint8_t* table = tables[x & 3];
+        row[0] = table[row[0]];
+        row[1] = table[row[1]];
+        row[2] = table[row[2]];
+    }
+}
@@ -22,12 +22,22 @@ SoftwareMatrixDisplay::SoftwareMatrixDisplay(int rows, int cols, int chain_lengt
 int SoftwareMatrixDisplay::getWidth() const { return matrix_w_; }
 int SoftwareMatrixDisplay::getHeight() const { return matrix_h_; }
 
+void SoftwareMatrixDisplay::setOutputCurve(const OutputCurve::Settings& settings) {
+    curve_.configure(settings, /*preview=*/true);
+}
+
 int SoftwareMatrixDisplay::displayFrame(const cv::Mat& bgr, int delay_ms, 
                                          std::function<void(cv::Mat&)> overlay_callback) {
     if (bgr.empty()) return cv::waitKey(delay_ms);
 
     // Downscale to matrix resolution (what hardware would show)
     cv::resize(bgr, matrix_bgr_, cv::Size(matrix_w_, matrix_h_), 0, 0, cv::INTER_AREA);
+    if (curve_.isEnabled()) {
+        curve_.beginFrame();
+        for (int y = 0; y < matrix_h_; y++) {
+            curve_.applyRow(matrix_bgr_.ptr<uint8_t>(y), matrix_w_, y);
+        }
+    }
 
     // Draw overlay on matrix-resolution image (before upscaling for sharp text)
     if (overlay_callback) {
@@ -0,0 +1,138 @@
+#include "components/stdin_frame_source.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+uint64_t steadyNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+StdinFrameSource::StdinFrameSource(int width, int height, Mode mode, PixelOrder order)
+    : width_(width),
+      height_(height),
+      frame_size_(static_cast<size_t>(width) * height * 3),
+      mode_(mode),
+      order_(order),
+      timestamps_{0, 0, 0},
+      write_slot_(0),
+      read_slot_(1),
+      shared_slot_(2),
+      running_(true),
+      end_of_stream_(false),
+      frames_read_(0),
+      frames_skipped_(0) {
+    for (std::vector<uint8_t>& slot : slots_) {
+        slot.resize(frame_size_);
+    }
+    if (mode_ == Mode::LATEST) {
+        reader_thread_ = std::thread(&StdinFrameSource::readerLoop, this);
+    }
+}
+
+StdinFrameSource::~StdinFrameSource() {
+    running_ = false;
+    if (reader_thread_.joinable()) {
+        reader_thread_.join();
+    }
+}
+
+bool StdinFrameSource::readFrame(uint8_t* buffer) {
+    size_t filled = 0;
+    while (filled < frame_size_) {
+        // Wake up periodically so stop() (or the destructor) ends a read on an idle pipe;
+        // poll() is never restarted after a signal, unlike read()
+        pollfd input{STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&input, 1, 100);
+        if (!running_) return false;
+        if (ready == 0) continue;
+        if (ready < 0 && errno != EINTR) return false;
+        if (ready < 0) continue;
+
+        ssize_t n = ::read(STDIN_FILENO, buffer + filled, frame_size_ - filled);
+        if (n > 0) {
+            filled += static_cast<size_t>(n);
+        } else if (n == 0) {
+            if (filled > 0) {
+                std::cerr << "End of input inside a frame (" << filled << " of "
+                          << frame_size_ << " bytes)" << std::endl;
+            } else {
+                std::cerr << "End of input (EOF)" << std::endl;
+            }
+            return false;
+        } else if (errno != EINTR && errno != EAGAIN) {
+            std::cerr << "Read error on stdin: " << strerror(errno) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void StdinFrameSource::readerLoop() {
+    while (running_) {
+        if (!readFrame(slots_[write_slot_].data())) break;
+        timestamps_[write_slot_] = steadyNowNs();
+        frames_read_++;
+
+        int previous = shared_slot_.exchange(write_slot_ | NEW_FRAME, std::memory_order_acq_rel);
+        if (previous & NEW_FRAME) {
+            frames_skipped_++;  // The consumer never saw that one
+        }
+        write_slot_ = previous & ~NEW_FRAME;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        frame_ready_.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        end_of_stream_ = true;
+    }
+    frame_ready_.notify_one();
+}
+
+void StdinFrameSource::fillView(int slot, FrameView& frame) {
+    frame.data = slots_[slot].data();
+    frame.width = width_;
+    frame.height = height_;
+    frame.stride = width_ * 3;
+    frame.order = order_;
+    frame.timestamp_ns = timestamps_[slot];
+}
+
+bool StdinFrameSource::read(FrameView& frame) {
+    if (mode_ == Mode::SEQUENTIAL) {
+        if (!readFrame(slots_[read_slot_].data())) return false;
+        timestamps_[read_slot_] = steadyNowNs();
+        frames_read_++;
+        fillView(read_slot_, frame);
+        return true;
+    }
+
+    {
+        // Timed, so a stop() from a signal handler (which cannot notify) is seen on a stalled pipe
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        while (!frame_ready_.wait_for(lock, std::chrono::milliseconds(100), [this] {
+            return (shared_slot_.load(std::memory_order_acquire) & NEW_FRAME) || end_of_stream_;
+        })) {
+            if (!running_) return false;
+        }
+    }
+    // A frame published just before EOF is still shown
+    if (!(shared_slot_.load(std::memory_order_acquire) & NEW_FRAME)) return false;
+
+    int previous = shared_slot_.exchange(read_slot_, std::memory_order_acq_rel);
+    read_slot_ = previous & ~NEW_FRAME;
+    fillView(read_slot_, frame);
+    return true;
+}
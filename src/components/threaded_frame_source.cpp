@@ -0,0 +1,101 @@
+#include "components/threaded_frame_source.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+uint64_t steadyNowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+ThreadedFrameSource::ThreadedFrameSource(std::unique_ptr<FrameSource> source, Mode mode)
+    : source_(std::move(source)),
+      mode_(mode),
+      ready_ns_{0, 0, 0},
+      write_slot_(0),
+      read_slot_(1),
+      shared_slot_(2),
+      running_(true),
+      end_of_stream_(false),
+      frames_read_(0),
+      frames_skipped_(0) {
+    capture_thread_ = std::thread(&ThreadedFrameSource::captureLoop, this);
+}
+
+ThreadedFrameSource::~ThreadedFrameSource() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        running_ = false;
+    }
+    slot_taken_.notify_one();
+    // A capture thread blocked inside the inner read() finishes that frame first
+    if (capture_thread_.joinable()) {
+        capture_thread_.join();
+    }
+}
+
+void ThreadedFrameSource::captureLoop() {
+    FrameView view;
+    while (running_ && source_->read(view)) {
+        // Copy out: the inner source reuses its buffer on the next read()
+        size_t row_bytes = static_cast<size_t>(view.width) * 3;
+        std::vector<uint8_t>& slot = slots_[write_slot_];
+        slot.resize(row_bytes * view.height);
+        for (int y = 0; y < view.height; y++) {
+            memcpy(slot.data() + y * row_bytes, view.data + static_cast<size_t>(y) * view.stride, row_bytes);
+        }
+        views_[write_slot_] = view;
+        views_[write_slot_].data = slot.data();
+        views_[write_slot_].stride = static_cast<int>(row_bytes);
+        ready_ns_[write_slot_] = steadyNowNs();
+        frames_read_++;
+
+        if (mode_ == Mode::EVERY_FRAME) {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            slot_taken_.wait(lock, [this] {
+                return !running_ || !(shared_slot_.load(std::memory_order_acquire) & NEW_FRAME);
+            });
+            if (!running_) break;
+        }
+
+        int previous = shared_slot_.exchange(write_slot_ | NEW_FRAME, std::memory_order_acq_rel);
+        if (previous & NEW_FRAME) {
+            frames_skipped_++;  // The consumer never saw that one
+        }
+        write_slot_ = previous & ~NEW_FRAME;
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        frame_ready_.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        end_of_stream_ = true;
+    }
+    frame_ready_.notify_one();
+}
+
+bool ThreadedFrameSource::read(FrameView& frame) {
+    {
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        frame_ready_.wait(lock, [this] {
+            return (shared_slot_.load(std::memory_order_acquire) & NEW_FRAME) || end_of_stream_;
+        });
+    }
+    // A frame published just before the end is still returned
+    if (!(shared_slot_.load(std::memory_order_acquire) & NEW_FRAME)) return false;
+
+    int previous = shared_slot_.exchange(read_slot_, std::memory_order_acq_rel);
+    read_slot_ = previous & ~NEW_FRAME;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    slot_taken_.notify_one();
+    frame = views_[read_slot_];
+    return true;
+}
@@ -0,0 +1,130 @@
+#include "components/tile_receiver.h"
+#include "components/tile_protocol.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+TileReceiver::TileReceiver(int port, int tile_index)
+    : fd_(-1),
+      tile_index_(tile_index),
+      width_(0),
+      height_(0),
+      have_sequence_(false),
+      session_(0),
+      have_shown_(false),
+      sequence_(0),
+      last_shown_(0),
+      frames_(0),
+      lost_frames_(0),
+      datagram_(65536) {
+    fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd_ < 0) {
+        std::cerr << "Receiver: failed to create socket: " << strerror(errno) << std::endl;
+        return;
+    }
+    // Room for a few frames while the display waits for vsync
+    int buffer_bytes = 1 << 20;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &buffer_bytes, sizeof(buffer_bytes));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        std::cerr << "Receiver: failed to bind UDP port " << port << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return;
+    }
+    std::cout << "Receiving tile " << tile_index_ << " on UDP port " << port << std::endl;
+}
+
+TileReceiver::~TileReceiver() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool TileReceiver::receive(int timeout_ms) {
+    if (fd_ < 0) return false;
+
+    pollfd poll_fd;
+    poll_fd.fd = fd_;
+    poll_fd.events = POLLIN;
+    while (poll(&poll_fd, 1, timeout_ms) > 0) {
+        ssize_t bytes = recv(fd_, datagram_.data(), datagram_.size(), 0);
+        if (bytes < static_cast<ssize_t>(sizeof(TilePacketHeader))) continue;
+
+        TilePacketHeader header;
+        memcpy(&header, datagram_.data(), sizeof(header));
+        // The size bound keeps a stray datagram from allocating gigabytes below
+        if (header.magic != TILE_MAGIC || header.tile_index != tile_index_ ||
+            header.width == 0 || header.height == 0 ||
+            header.width > TILE_MAX_SIDE || header.height > TILE_MAX_SIDE) {
+            continue;
+        }
+
+        if (have_sequence_ && header.session != session_) {
+            // The sender restarted and numbers frames from 0 again
+            std::cout << "Receiver: new sender session, resynchronising" << std::endl;
+            have_sequence_ = false;
+            have_shown_ = false;
+        }
+        if (!have_sequence_ || tileSequenceAfter(header.sequence, sequence_)) {
+            // A newer frame: whatever is missing of the current one is shown from the
+            // previous frame's rows
+            have_sequence_ = true;
+            session_ = header.session;
+            sequence_ = header.sequence;
+        } else if (header.sequence != sequence_) {
+            continue;  // Reordered datagram of a frame that is already over
+        }
+
+        if (header.width != width_ || header.height != height_) {
+            width_ = header.width;
+            height_ = header.height;
+            rgb_.assign(static_cast<size_t>(width_) * height_ * 3, 0);
+        }
+
+        if (header.type == static_cast<uint16_t>(TilePacketType::END)) {
+            if (have_shown_ && tileSequenceAfter(header.sequence, last_shown_ + 1)) {
+                lost_frames_ += static_cast<uint32_t>(header.sequence - last_shown_ - 1);
+            }
+            last_shown_ = header.sequence;
+            have_shown_ = true;
+            frames_++;
+            return true;
+        }
+
+        size_t expected = sizeof(header) + static_cast<size_t>(header.row_count) * width_ * sizeof(uint16_t);
+        if (header.type == static_cast<uint16_t>(TilePacketType::ROWS) &&
+            static_cast<size_t>(bytes) == expected && header.row_start + header.row_count <= height_) {
+            handleRows(datagram_.data() + sizeof(header), header.row_start, header.row_count);
+        }
+    }
+    return false;
+}
+
+void TileReceiver::handleRows(const uint8_t* payload, int row_start, int row_count) {
+    uint8_t* out = rgb_.data() + static_cast<size_t>(row_start) * width_ * 3;
+    size_t count = static_cast<size_t>(row_count) * width_;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t value;
+        memcpy(&value, payload + i * 2, sizeof(value));
+        // Replicate the top bits into the low ones so 0x1F/0x3F map to 255
+        uint8_t r = static_cast<uint8_t>((value >> 11) & 0x1F);
+        uint8_t g = static_cast<uint8_t>((value >> 5) & 0x3F);
+        uint8_t b = static_cast<uint8_t>(value & 0x1F);
+        out[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        out[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        out[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        out += 3;
+    }
+}
@@ -0,0 +1,28 @@
+#include "components/video_capture_source.h"
+
+#include <chrono>
+
+bool VideoCaptureSource::openDevice(int device_index, int width, int height) {
+    if (!capture_.open(device_index)) return false;
+    // Best-effort requests; actual may differ.
+    capture_.set(cv::CAP_PROP_FRAME_WIDTH, width);
+    capture_.set(cv::CAP_PROP_FRAME_HEIGHT, height);
+    return true;
+}
+
+bool VideoCaptureSource::openFile(const char* path) {
+    return capture_.open(path);
+}
+
+bool VideoCaptureSource::read(FrameView& frame) {
+    if (!capture_.read(frame_) || frame_.empty()) return false;
+
+    frame.data = frame_.data;
+    frame.width = frame_.cols;
+    frame.height = frame_.rows;
+    frame.stride = static_cast<int>(frame_.step);
+    frame.order = PixelOrder::BGR;
+    frame.timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    return true;
+}
@@ -1,14 +1,35 @@
 #include "app/app_core.h"
 #include "components/debug_data_collector.h"
+#include "components/frame_recording.h"
+#include "components/network_output_sink.h"
 #include "components/software_matrix_display.h"
+#include "components/threaded_frame_source.h"
+#include "components/video_capture_source.h"
 
-#include <opencv2/videoio.hpp>
 #include <opencv2/imgproc.hpp>
 #include <iostream>
+#include <csignal>
+#include <cstdlib>
+#include <cstdio>
 #include <cstring>
+#include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Also read by the processing thread in --throughput mode
+static std::atomic<bool> running(true);
+
+static void signalHandler(int signum) {
+    std::cout << "\nInterrupt signal (" << signum << ") received. Exiting...\n";
+    running = false;
+}
 
 static void printUsage(const char* program) {
     std::cout << "Usage: " << program << " [options]\n"
@@ -18,12 +39,42 @@ static void printUsage(const char* program) {
               << "  --video PATH               Use a video file instead of a camera device\n"
               << "  --width WIDTH              Capture width request (default: 640)\n"
               << "  --height HEIGHT            Capture height request (default: 480)\n"
+              << "  --record FILE              Record raw input frames to FILE for later --replay\n"
+              << "  --replay FILE              Use a frame recording (from any runner) as input\n"
+              << "  --replay-speed SPEED       native: recorded timing (default), max: as fast as possible\n"
+              << "  --replay-loop              Restart the recording when it ends\n"
               << "\n"
               << "Matrix configuration:\n"
               << "  --led-rows ROWS            Matrix rows per panel (default: 64)\n"
               << "  --led-cols COLS            Matrix columns per panel (default: 64)\n"
               << "  --led-chain CHAIN          Number of chained matrices (default: 1)\n"
               << "  --led-parallel PARALLEL    Number of parallel chains (default: 1)\n"
+              << "  --output-gamma G           Preview the matrix output LUT with gamma G (default: off)\n"
+              << "  --output-dither            Preview temporal dithering between PWM levels\n"
+              << "  --led-pwm-bits N           PWM bits of the previewed panel (default: 11)\n"
+              << "  --led-brightness N         Previewed LED brightness 0-100 (default: 100)\n"
+              << "  --process-scale N          Run effects at N x matrix resolution (default: 0 = capture resolution)\n"
+              << "  --check-allocs             Log cv::Mat allocations per frame when the count changes\n"
+              << "  --compact-history          Store double exposure history as BGR565 (2/3 the memory)\n"
+              << "  --bg-model MODEL           Background subtraction: mog2, mog2-fast, average, diff (default: mog2)\n"
+              << "  --segment-every N          Run segmentation every Nth frame, reuse the silhouette in between (default: 1)\n"
+              << "  --segment-change F         With --segment-every: segment early once F of the scene changed (e.g. 0.02)\n"
+              << "  --state-file PATH          Restore the learned background and effect state from PATH, save it every 30s\n"
+              << "  --transition-frames N      Crossfade effect switches over N frames (default: 30, 0 = cut)\n"
+              << "  --target-fps F             Lower quality step by step to keep processing at F fps (default: off)\n"
+              << "  --target-temp C            Lower quality while the CPU is above C degrees (default: off)\n"
+              << "  --stage-timing [SECONDS]   Log process/display p50/p95/p99 every SECONDS (default: 5)\n"
+              << "  --send-tiles HOST:PORT,... Also send the output split into one tile per receiver (left to right)\n"
+              << "                             to matrix_receiver nodes over UDP\n"
+              << "  --tile-size WxH            Size of each sent tile (default: the previewed matrix size)\n"
+              << "  --throughput               Capture and process on their own threads; the preview never stalls processing\n"
+              << "                             (implies --stage-timing, prints a summary at exit)\n"
+              << "  --preview-fps N            Preview rate in --throughput mode (default: 15)\n"
+              << "  --headless                 No preview window (implies --throughput; quit with Ctrl+C)\n"
+              << "  --auto-mode                Switch Ambient/Active automatically from scene activity\n"
+              << "  --motion-threshold F       Fraction of the activity probe that must change to go Active (default: 0.02)\n"
+              << "  --idle-threshold F         Activity below this counts as idle (default: 0.005)\n"
+              << "  --idle-timeout SECONDS     Idle time before switching to Ambient (default: 10)\n"
               << "\n"
               << "  --help                     Show this help message\n"
               << "\n"
@@ -77,6 +128,102 @@ static void drawDebugOverlay(cv::Mat& frame, double fps, float temperature_celsi
                 cv::Scalar(0, 255, 255), thickness);  // Yellow text
 }
 
+// Apply one preview window key press; returns false on ESC
+static bool handleKey(int key, AppCore& core, std::atomic<bool>& debug_enabled) {
+    if (key == 27) return false;  // ESC to quit
+
+    if (key >= '1' && key <= '9') {
+        int effect_num = key - '0';
+        Effect effect = static_cast<Effect>(effect_num);
+
+        // Set effect and automatically switch to appropriate mode
+        SystemMode current_mode = core.getSystemMode();
+        SystemMode appropriate_mode = core.getAppropriateModeForEffect(effect);
+
+        core.setEffect(effect);
+
+        const char* effect_names[] = {
+            "Debug View",
+            "Filled Silhouette",
+            "Outline Only",
+            "Motion Trails",
+            "Rainbow Motion Trails",
+            "Double Exposure",
+            "Procedural Shapes",
+            "Wave Patterns",
+            "Geometric Abstraction"
+        };
+
+        const char* mode_names[] = {"Ambient", "Active"};
+
+        std::cout << "Switched to effect " << effect_num << ": " << effect_names[effect_num - 1];
+
+        // Only show mode change if it actually changed
+        if (appropriate_mode != current_mode) {
+            core.setSystemMode(appropriate_mode);
+            std::cout << " (switched to " << mode_names[static_cast<int>(appropriate_mode)] << " mode)";
+        }
+        std::cout << std::endl;
+    } else if (key == 'm' || key == 'M') {
+        // Toggle system mode
+        SystemMode current_mode = core.getSystemMode();
+        SystemMode new_mode = (current_mode == SystemMode::AMBIENT) ? SystemMode::ACTIVE : SystemMode::AMBIENT;
+        core.setSystemMode(new_mode);
+
+        const char* mode_names[] = {"Ambient", "Active"};
+        const char* mode_descriptions[] = {
+            "Procedural Shapes, Wave Patterns",
+            "Interactive effects (silhouettes, trails, etc.)"
+        };
+
+        std::cout << "System mode: " << mode_names[static_cast<int>(new_mode)] << std::endl;
+        std::cout << "  (" << mode_descriptions[static_cast<int>(new_mode)] << ")" << std::endl;
+
+        // Set to a valid default effect for the new mode
+        Effect default_effect = core.getDefaultEffectForMode(new_mode);
+        core.setEffect(default_effect);
+
+        const char* effect_names[] = {
+            "Debug View",
+            "Filled Silhouette",
+            "Outline Only",
+            "Motion Trails",
+            "Rainbow Motion Trails",
+            "Double Exposure",
+            "Procedural Shapes",
+            "Wave Patterns",
+            "Geometric Abstraction"
+        };
+        std::cout << "  Default effect: " << static_cast<int>(default_effect)
+                  << " (" << effect_names[static_cast<int>(default_effect) - 1] << ")" << std::endl;
+    } else if (key == 'd' || key == 'D') {
+        bool new_state = !debug_enabled.load();
+        debug_enabled = new_state;
+        std::cout << "Debug info " << (new_state ? "enabled" : "disabled") << std::endl;
+    } else if (key == 'q' || key == 'Q') {
+        // Toggle panel mode (extend <-> repeat)
+        PanelMode current = core.getPanelMode();
+        PanelMode new_mode = (current == PanelMode::EXTEND) ? PanelMode::REPEAT : PanelMode::EXTEND;
+        core.setPanelMode(new_mode);
+        const char* mode_name = (new_mode == PanelMode::EXTEND) ? "EXTEND" : "REPEAT";
+        std::cout << "Panel layout mode: " << mode_name << std::endl;
+        if (new_mode == PanelMode::EXTEND) {
+            std::cout << "  (Image spans across all panels)" << std::endl;
+        } else {
+            std::cout << "  (Same image on each panel with different effects)" << std::endl;
+        }
+    } else if (key == 'a' || key == 'A') {
+        // Toggle auto-cycling
+        core.toggleAutoCycling();
+        bool enabled = core.isAutoCycling();
+        std::cout << "Auto-cycling " << (enabled ? "enabled" : "disabled") << std::endl;
+        if (enabled) {
+            std::cout << "  (Effects will automatically cycle every 3-7 seconds)" << std::endl;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char *argv[]) {
     int device_index = 0;
     const char* video_path = nullptr;
@@ -86,6 +233,36 @@ int main(int argc, char *argv[]) {
     int cols = 64;
     int chain_length = 1;
     int parallel = 1;
+    double output_gamma = 0.0;  // 0 = preview without the output LUT
+    bool output_dither = false;
+    int pwm_bits = 11;
+    int brightness = 100;
+    int process_scale = 0;  // 0 = capture resolution
+    bool check_allocs = false;
+    bool compact_history = false;
+    BackgroundModel::Type bg_model = BackgroundModel::Type::MOG2;
+    int segment_every = 1;
+    double segment_change = 0.0;
+    const char* state_file = nullptr;
+    int transition_frames = 30;
+    double target_fps = 0.0;  // 0 = no quality governor
+    float target_temp = 0.0f;
+    bool stage_timing = false;
+    int timing_report_seconds = 5;
+    std::vector<std::string> tile_endpoints;
+    int tile_width = 0;  // 0 = matrix size
+    int tile_height = 0;
+    bool throughput = false;
+    int preview_fps = 15;
+    bool headless = false;
+    bool auto_mode = false;
+    double motion_threshold = 0.02;
+    double idle_threshold = 0.005;
+    double idle_timeout = 10.0;
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    ReplayFrameSource::Speed replay_speed = ReplayFrameSource::Speed::NATIVE;
+    bool replay_loop = false;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
@@ -99,6 +276,23 @@ int main(int argc, char *argv[]) {
             width = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
             height = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            const char* speed = argv[++i];
+            if (strcmp(speed, "native") == 0) {
+                replay_speed = ReplayFrameSource::Speed::NATIVE;
+            } else if (strcmp(speed, "max") == 0) {
+                replay_speed = ReplayFrameSource::Speed::MAX;
+            } else {
+                std::cerr << "Unknown replay speed: " << speed << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--replay-loop") == 0) {
+            replay_loop = true;
         } else if (strcmp(argv[i], "--led-rows") == 0 && i + 1 < argc) {
             rows = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-cols") == 0 && i + 1 < argc) {
@@ -107,35 +301,162 @@ int main(int argc, char *argv[]) {
             chain_length = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-parallel") == 0 && i + 1 < argc) {
             parallel = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output-gamma") == 0 && i + 1 < argc) {
+            output_gamma = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--output-dither") == 0) {
+            output_dither = true;
+        } else if (strcmp(argv[i], "--led-pwm-bits") == 0 && i + 1 < argc) {
+            pwm_bits = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-brightness") == 0 && i + 1 < argc) {
+            brightness = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--process-scale") == 0 && i + 1 < argc) {
+            process_scale = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--check-allocs") == 0) {
+            check_allocs = true;
+        } else if (strcmp(argv[i], "--compact-history") == 0) {
+            compact_history = true;
+        } else if (strcmp(argv[i], "--bg-model") == 0 && i + 1 < argc) {
+            const char* model = argv[++i];
+            if (!BackgroundModel::parseType(model, bg_model)) {
+                std::cerr << "Unknown background model: " << model << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--segment-every") == 0 && i + 1 < argc) {
+            segment_every = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segment-change") == 0 && i + 1 < argc) {
+            segment_change = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--state-file") == 0 && i + 1 < argc) {
+            state_file = argv[++i];
+        } else if (strcmp(argv[i], "--transition-frames") == 0 && i + 1 < argc) {
+            transition_frames = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc) {
+            target_fps = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--target-temp") == 0 && i + 1 < argc) {
+            target_temp = static_cast<float>(std::atof(argv[++i]));
+        } else if (strcmp(argv[i], "--stage-timing") == 0) {
+            stage_timing = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                timing_report_seconds = std::max(1, std::atoi(argv[++i]));
+            }
+        } else if (strcmp(argv[i], "--send-tiles") == 0 && i + 1 < argc) {
+            if (!NetworkOutputSink::parseEndpoints(argv[++i], tile_endpoints)) {
+                std::cerr << "--send-tiles expects HOST:PORT[,HOST:PORT...]" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &tile_width, &tile_height) != 2 || tile_width <= 0 || tile_height <= 0) {
+                std::cerr << "--tile-size expects WIDTHxHEIGHT" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--throughput") == 0) {
+            throughput = true;
+        } else if (strcmp(argv[i], "--preview-fps") == 0 && i + 1 < argc) {
+            preview_fps = std::max(1, std::atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--auto-mode") == 0) {
+            auto_mode = true;
+        } else if (strcmp(argv[i], "--motion-threshold") == 0 && i + 1 < argc) {
+            motion_threshold = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-threshold") == 0 && i + 1 < argc) {
+            idle_threshold = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--idle-timeout") == 0 && i + 1 < argc) {
+            idle_timeout = std::atof(argv[++i]);
         } else {
             std::cerr << "Unknown option: " << argv[i] << std::endl;
             printUsage(argv[0]);
             return 1;
         }
     }
+    if (headless) {
+        throughput = true;
+    }
+    if (throughput) {
+        stage_timing = true;
+    }
 
-    cv::VideoCapture cap;
-    if (video_path) {
-        cap.open(video_path);
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    std::unique_ptr<FrameSource> source;
+    if (replay_path) {
+        std::unique_ptr<ReplayFrameSource> replay(new ReplayFrameSource(replay_path, replay_speed, replay_loop));
+        if (!replay->isOpen()) return 1;
+        width = replay->getWidth();
+        height = replay->getHeight();
+        source = std::move(replay);
     } else {
-        cap.open(device_index);
+        std::unique_ptr<VideoCaptureSource> capture(new VideoCaptureSource());
+        bool opened = video_path ? capture->openFile(video_path) : capture->openDevice(device_index, width, height);
+        if (!opened) {
+            std::cerr << "Failed to open video source." << std::endl;
+            return 1;
+        }
+        source = std::move(capture);
+    }
+    ThreadedFrameSource* threaded_source = nullptr;
+    if (throughput) {
+        // A camera keeps only the newest frame; files and recordings process every frame
+        ThreadedFrameSource::Mode mode = (replay_path || video_path) ? ThreadedFrameSource::Mode::EVERY_FRAME
+                                                                    : ThreadedFrameSource::Mode::LATEST;
+        std::unique_ptr<ThreadedFrameSource> threaded(new ThreadedFrameSource(std::move(source), mode));
+        threaded_source = threaded.get();
+        source = std::move(threaded);
     }
 
-    if (!cap.isOpened()) {
-        std::cerr << "Failed to open video source." << std::endl;
+    FrameRecorder recorder;
+    if (record_path && !recorder.open(record_path)) {
         return 1;
     }
 
-    // Best-effort requests; actual may differ.
-    cap.set(cv::CAP_PROP_FRAME_WIDTH, width);
-    cap.set(cv::CAP_PROP_FRAME_HEIGHT, height);
-
     AppCore core(width, height, chain_length);
+    if (process_scale > 0) {
+        core.setProcessingSize(cols * chain_length * process_scale, rows * parallel * process_scale);
+    }
+    core.setAllocationCheck(check_allocs);
+    if (compact_history) {
+        core.setHistoryFormat(FrameHistory::Format::BGR565);
+    }
+    core.setBackgroundModel(bg_model);
+    core.setSegmentationRate(segment_every, segment_change);
+    if (state_file) {
+        core.setStateFile(state_file);
+    }
+    core.setTransitionDuration(transition_frames);
+    if (auto_mode) {
+        core.setActivityThresholds(motion_threshold, idle_threshold);
+        core.setIdleTimeout(idle_timeout);
+        core.setAutoModeSwitching(true);
+    }
     DebugDataCollector debug;
-    SoftwareMatrixDisplay display(rows, cols, chain_length, parallel);
+    if (target_fps > 0.0 || target_temp > 0.0f) {
+        core.setQualityGovernor(target_fps, target_temp, [&debug]() { return debug.getTemperature(); });
+    }
+    std::unique_ptr<SoftwareMatrixDisplay> display;
+    if (!headless) {
+        display = std::make_unique<SoftwareMatrixDisplay>(rows, cols, chain_length, parallel);
+        OutputCurve::Settings output_curve;
+        output_curve.gamma = output_gamma;
+        output_curve.brightness = brightness;
+        output_curve.pwm_bits = pwm_bits;
+        output_curve.dither = output_dither;
+        display->setOutputCurve(output_curve);
+    }
+    std::unique_ptr<NetworkOutputSink> tile_sink;
+    if (!tile_endpoints.empty()) {
+        tile_sink = std::make_unique<NetworkOutputSink>(tile_endpoints,
+                                                        tile_width > 0 ? tile_width : cols * chain_length,
+                                                        tile_height > 0 ? tile_height : rows * parallel);
+        if (!tile_sink->isReady()) return 1;
+    }
     std::atomic<bool> debug_enabled(true);
 
-    std::cout << "Desktop runner started. Displaying software matrix preview." << std::endl;
+    if (headless) {
+        std::cout << "Desktop runner started headless (no preview, Ctrl+C to quit)." << std::endl;
+    } else {
+        std::cout << "Desktop runner started. Displaying software matrix preview." << std::endl;
+    }
     std::cout << "System Modes:" << std::endl;
     std::cout << "  m - Toggle system mode (Ambient <-> Active)" << std::endl;
     std::cout << "     Ambient: Background effects (Procedural Shapes, Wave Patterns)" << std::endl;
@@ -159,120 +480,170 @@ int main(int argc, char *argv[]) {
     std::cout << "  d - Toggle debug info (FPS and temperature)" << std::endl;
     std::cout << "  ESC - Quit" << std::endl;
 
+    FrameView view;
     cv::Mat frame;
+    cv::Mat converted;
     cv::Mat out;
+    DebugDataCollector* timing = stage_timing ? &debug : nullptr;
+    auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(timing_report_seconds);
+    uint64_t processed_frames = 0;
+    uint64_t previews_shown = 0;
+
+    // Reads, records and converts the next frame into frame; false when the input ended
+    auto readNextFrame = [&]() -> bool {
+        if (!source->read(view)) return false;
+        if (threaded_source && timing) {
+            // Time the frame waited between the capture thread and processing
+            uint64_t ready_ns = threaded_source->getReadyTimeNs();
+            uint64_t now_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+            timing->recordStage(DebugDataCollector::Stage::CAPTURE, now_ns > ready_ns ? now_ns - ready_ns : 0);
+            debug.setDroppedFrames(threaded_source->getSkippedFrames());
+        }
+        if (recorder.isOpen()) {
+            recorder.record(view);
+        }
+        frame = cv::Mat(view.height, view.width, CV_8UC3, const_cast<uint8_t*>(view.data),
+                        static_cast<size_t>(view.stride));
+        if (view.order == PixelOrder::RGB) {
+            // rpicam_to_matrix recordings are FFmpeg rgb24
+            cv::cvtColor(frame, converted, cv::COLOR_RGB2BGR);
+            frame = converted;
+        }
 
-    while (true) {
-        if (!cap.read(frame) || frame.empty()) break;
-
-        // Update debug data if enabled
-        if (debug_enabled.load()) {
+        // Update debug data if enabled (always in throughput mode, for the fps report)
+        if (debug_enabled.load() || throughput) {
             debug.recordFrame();
         }
-
-        core.processFrame(frame, out);
-
-        // Create overlay callback if debug is enabled
-        std::function<void(cv::Mat&)> overlay_callback = nullptr;
-        if (debug_enabled.load()) {
-            overlay_callback = [&debug](cv::Mat& matrix_frame) {
-                drawDebugOverlay(matrix_frame, debug.getFPS(), debug.getTemperature());
-            };
+        return true;
+    };
+
+    // processFrame vs key handling on the preview thread (--throughput); only processing
+    // holds it, never the capture wait or the tile send, so key presses don't stall
+    std::mutex core_mutex;
+
+    // Processes frame into out and sends it to the tile receivers
+    auto processCurrentFrame = [&]() {
+        {
+            std::unique_lock<std::mutex> lock(core_mutex, std::defer_lock);
+            if (throughput) lock.lock();
+            DebugDataCollector::ScopedTimer timer(timing, DebugDataCollector::Stage::PROCESS,
+                                                  static_cast<int>(core.getEffect()));
+            core.processFrame(frame, out);
         }
 
-        int key = display.displayFrame(out, /*delay_ms=*/1, overlay_callback);
-        if (key == 27) break;  // ESC to quit
-
-        if (key >= '1' && key <= '9') {
-            int effect_num = key - '0';
-            Effect effect = static_cast<Effect>(effect_num);
-
-            // Set effect and automatically switch to appropriate mode
-            SystemMode current_mode = core.getSystemMode();
-            SystemMode appropriate_mode = core.getAppropriateModeForEffect(effect);
-
-            core.setEffect(effect);
-
-            const char* effect_names[] = {
-                "Debug View",
-                "Filled Silhouette",
-                "Outline Only",
-                "Motion Trails",
-                "Rainbow Motion Trails",
-                "Double Exposure",
-                "Procedural Shapes",
-                "Wave Patterns",
-                "Geometric Abstraction"
-            };
-
-            const char* mode_names[] = {"Ambient", "Active"};
-
-            std::cout << "Switched to effect " << effect_num << ": " << effect_names[effect_num - 1];
+        if (tile_sink && !out.empty()) {
+            tile_sink->writeFrame(out.data, out.cols, out.rows, static_cast<int>(out.step), PixelOrder::BGR);
+        }
+        processed_frames++;
+    };
 
-            // Only show mode change if it actually changed
-            if (appropriate_mode != current_mode) {
-                core.setSystemMode(appropriate_mode);
-                std::cout << " (switched to " << mode_names[static_cast<int>(appropriate_mode)] << " mode)";
+    auto reportTiming = [&]() {
+        if (stage_timing && std::chrono::steady_clock::now() >= next_report) {
+            std::cout << debug.takeReport() << std::flush;
+            next_report += std::chrono::seconds(timing_report_seconds);
+        }
+    };
+
+    // Create overlay callback if debug is enabled
+    auto overlayCallback = [&]() -> std::function<void(cv::Mat&)> {
+        if (!debug_enabled.load()) return nullptr;
+        return [&debug](cv::Mat& matrix_frame) {
+            drawDebugOverlay(matrix_frame, debug.getFPS(), debug.getTemperature());
+        };
+    };
+
+    auto started = std::chrono::steady_clock::now();
+
+    if (!throughput) {
+        while (running) {
+            if (!readNextFrame()) break;
+            processCurrentFrame();
+
+            int key;
+            {
+                // Includes the 1ms waitKey poll
+                DebugDataCollector::ScopedTimer timer(timing, DebugDataCollector::Stage::DISPLAY);
+                key = display->displayFrame(out, /*delay_ms=*/1, overlayCallback());
             }
-            std::cout << std::endl;
-        } else if (key == 'm' || key == 'M') {
-            // Toggle system mode
-            SystemMode current_mode = core.getSystemMode();
-            SystemMode new_mode = (current_mode == SystemMode::AMBIENT) ? SystemMode::ACTIVE : SystemMode::AMBIENT;
-            core.setSystemMode(new_mode);
-
-            const char* mode_names[] = {"Ambient", "Active"};
-            const char* mode_descriptions[] = {
-                "Procedural Shapes, Wave Patterns",
-                "Interactive effects (silhouettes, trails, etc.)"
-            };
-
-            std::cout << "System mode: " << mode_names[static_cast<int>(new_mode)] << std::endl;
-            std::cout << "  (" << mode_descriptions[static_cast<int>(new_mode)] << ")" << std::endl;
-
-            // Set to a valid default effect for the new mode
-            Effect default_effect = core.getDefaultEffectForMode(new_mode);
-            core.setEffect(default_effect);
-
-            const char* effect_names[] = {
-                "Debug View",
-                "Filled Silhouette",
-                "Outline Only",
-                "Motion Trails",
-                "Rainbow Motion Trails",
-                "Double Exposure",
-                "Procedural Shapes",
-                "Wave Patterns",
-                "Geometric Abstraction"
-            };
-            std::cout << "  Default effect: " << static_cast<int>(default_effect)
-                      << " (" << effect_names[static_cast<int>(default_effect) - 1] << ")" << std::endl;
-        } else if (key == 'd' || key == 'D') {
-            bool new_state = !debug_enabled.load();
-            debug_enabled = new_state;
-            std::cout << "Debug info " << (new_state ? "enabled" : "disabled") << std::endl;
-        } else if (key == 'q' || key == 'Q') {
-            // Toggle panel mode (extend <-> repeat)
-            PanelMode current = core.getPanelMode();
-            PanelMode new_mode = (current == PanelMode::EXTEND) ? PanelMode::REPEAT : PanelMode::EXTEND;
-            core.setPanelMode(new_mode);
-            const char* mode_name = (new_mode == PanelMode::EXTEND) ? "EXTEND" : "REPEAT";
-            std::cout << "Panel layout mode: " << mode_name << std::endl;
-            if (new_mode == PanelMode::EXTEND) {
-                std::cout << "  (Image spans across all panels)" << std::endl;
-            } else {
-                std::cout << "  (Same image on each panel with different effects)" << std::endl;
+            reportTiming();
+            if (!handleKey(key, core, debug_enabled)) break;
+        }
+    } else {
+        // Processing never waits on the window: it hands a copy of out to the preview
+        // only once the previous one was shown, so the preview rate caps itself.
+        // HighGUI has to stay on the main thread (macOS), so processing gets its own
+        // thread and the main thread renders the preview and handles keys.
+        std::mutex preview_mutex;  // preview, preview_new
+        cv::Mat preview;
+        bool preview_new = false;
+        std::atomic<bool> processing_done(false);
+
+        auto processLoop = [&]() {
+            while (running) {
+                if (!readNextFrame()) break;
+                processCurrentFrame();
+                if (display) {
+                    std::lock_guard<std::mutex> lock(preview_mutex);
+                    if (!preview_new) {
+                        out.copyTo(preview);
+                        preview_new = true;
+                    }
+                }
+                reportTiming();
             }
-        } else if (key == 'a' || key == 'A') {
-            // Toggle auto-cycling
-            core.toggleAutoCycling();
-            bool enabled = core.isAutoCycling();
-            std::cout << "Auto-cycling " << (enabled ? "enabled" : "disabled") << std::endl;
-            if (enabled) {
-                std::cout << "  (Effects will automatically cycle every 3-7 seconds)" << std::endl;
+            processing_done = true;
+        };
+
+        if (!display) {
+            processLoop();
+        } else {
+            std::thread processing_thread(processLoop);
+            auto preview_interval = std::chrono::microseconds(1000000 / preview_fps);
+            cv::Mat shown;
+            while (running && !processing_done) {
+                auto next_preview = std::chrono::steady_clock::now() + preview_interval;
+                bool fresh = false;
+                {
+                    std::lock_guard<std::mutex> lock(preview_mutex);
+                    if (preview_new) {
+                        std::swap(preview, shown);  // preview keeps a buffer for the next copy
+                        preview_new = false;
+                        fresh = true;
+                    }
+                }
+                int key = -1;
+                if (fresh) {
+                    DebugDataCollector::ScopedTimer timer(timing, DebugDataCollector::Stage::DISPLAY);
+                    key = display->displayFrame(shown, /*delay_ms=*/1, overlayCallback());
+                    previews_shown++;
+                }
+                // Keep pumping window events until the next preview is due
+                int wait_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_preview - std::chrono::steady_clock::now()).count());
+                if (key == -1 && wait_ms > 0) {
+                    key = display->displayFrame(cv::Mat(), wait_ms);
+                }
+                if (key != -1) {
+                    std::lock_guard<std::mutex> lock(core_mutex);
+                    if (!handleKey(key, core, debug_enabled)) running = false;
+                }
             }
+            running = false;
+            processing_thread.join();
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+        std::cout << debug.takeReport();
+        std::cout << "[THROUGHPUT] " << processed_frames << " frames in " << std::fixed << std::setprecision(1)
+                  << seconds << "s (" << (seconds > 0.0 ? processed_frames / seconds : 0.0) << " fps), "
+                  << threaded_source->getSkippedFrames() << " skipped at capture";
+        if (display) {
+            std::cout << ", " << previews_shown << " previews";
         }
+        std::cout << std::endl;
     }
 
+    recorder.close();
     return 0;
 }
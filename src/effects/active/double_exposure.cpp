@@ -0,0 +1,66 @@
+#include "effects/active/double_exposure.h"
+#include "app/state_checkpoint.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <opencv2/imgproc.hpp>
+
+DoubleExposureEffect::DoubleExposureEffect()
+    : frame_counter_(0),
+      time_offset_(30) {
+    kernel_ = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(3, 3));
+}
+
+void DoubleExposureEffect::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    checkpoint.putValue(prefix + "frame_counter", frame_counter_);
+    checkpoint.putValue(prefix + "time_offset", time_offset_);
+}
+
+void DoubleExposureEffect::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    double value;
+    if (checkpoint.getValue(prefix + "frame_counter", value)) {
+        frame_counter_ = std::max(0, std::min(59, static_cast<int>(value)));
+    }
+    if (checkpoint.getValue(prefix + "time_offset", value)) {
+        time_offset_ = std::max(MIN_TIME_OFFSET, std::min(MAX_TIME_OFFSET, static_cast<int>(value)));
+    }
+}
+
+void DoubleExposureEffect::process(const FrameContext& context, cv::Mat& out) {
+    const cv::Mat& in_bgr = context.input;
+
+    // Change time offset randomly every 60 frames (~2 seconds at 30fps)
+    frame_counter_++;
+    if (frame_counter_ >= 60) {
+        // Generate random offset between MIN_TIME_OFFSET and MAX_TIME_OFFSET
+        time_offset_ = MIN_TIME_OFFSET + (rand() % (MAX_TIME_OFFSET - MIN_TIME_OFFSET + 1));
+        frame_counter_ = 0;
+    }
+
+    // Past frame with current random offset (a view, or decoded into past_), capped at
+    // the history depth (the quality governor may shrink it); false until it is that deep
+    int offset = context.history ? std::min(time_offset_, context.history->getCapacity()) : 0;
+    if (context.history && context.history->read(offset, context.roi, past_)) {
+        // Detect motion using the shared foreground mask, minimal cleanup
+        cv::morphologyEx(context.foregroundMask(), mask_, cv::MORPH_CLOSE, kernel_);
+
+        // Blur for smooth edges
+        int blur_size = context.scaledKernelSize(15);
+        cv::GaussianBlur(mask_, mask_, cv::Size(blur_size, blur_size), 0);
+
+        // Create stronger double exposure blend (25% current, 75% past for more opaque ghosting)
+        cv::addWeighted(in_bgr, 0.25, past_, 0.75, 0, blended_);
+
+        // Fast blending without float conversion:
+        // Use OpenCV's built-in blending with mask weights
+        in_bgr.copyTo(output_);
+
+        // Apply stronger double exposure where mask is above threshold
+        // This avoids all float conversions and uses optimized copyTo
+        blended_.copyTo(output_, mask_);
+    } else {
+        // Not enough history yet, just pass through
+        in_bgr.copyTo(output_);
+    }
+    out = output_;
+}
@@ -0,0 +1,66 @@
+#include "effects/active/geometric_abstraction.h"
+
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+// Filled polygon with a white outline
+static void drawOutlinedPolygon(cv::Mat& img, const std::vector<cv::Point>& polygon, const cv::Scalar& color) {
+    const cv::Point* points = polygon.data();
+    int num_points = static_cast<int>(polygon.size());
+    cv::fillPoly(img, &points, &num_points, 1, color);
+    cv::polylines(img, &points, &num_points, 1, true, cv::Scalar(255, 255, 255), 2);
+}
+
+void GeometricAbstractionEffect::prepare(const cv::Size& size) {
+    output_.create(size, CV_8UC3);
+}
+
+// Effect 9: Geometric Abstraction (Active System Mode - Interpretation-based)
+void GeometricAbstractionEffect::process(const FrameContext& context, cv::Mat& out) {
+    // Morphology-cleaned mask removes noise and fills small holes
+    const auto& contours = context.contours(/*cleaned=*/true);
+
+    output_.create(context.input.size(), CV_8UC3);
+    output_.setTo(0);
+    out = output_;
+
+    for (const auto& c : contours) {
+        // Approximate contour with fewer points for geometric look
+        double epsilon = context.scaledLength(15.0);  // Approximation accuracy
+        cv::approxPolyDP(c, approx_, epsilon, false);
+
+        if (approx_.size() >= 3) {
+            // Draw simplified polygon with gradient colors
+            // Use contour area to generate hue (0-360 range for hsvToBgr)
+            // Map back to input-resolution area so colors don't depend on processing size
+            float area = static_cast<float>(cv::contourArea(c) / context.area_scale);
+            float hue = fmod(area * 0.1f, 360.0f);
+            cv::Scalar color = hsvToBgr(hue, 1.0f, 1.0f);
+            // Draw polygon with outline
+            drawOutlinedPolygon(output_, approx_, color);
+        }
+    }
+}
+
+cv::Scalar GeometricAbstractionEffect::hsvToBgr(float h, float s, float v) {
+    float c = v * s;
+    float x = c * (1.0f - std::abs(fmod(h / 60.0f, 2.0f) - 1.0f));
+    float m = v - c;
+
+    float r, g, b;
+    if (h < 60) {
+        r = c; g = x; b = 0;
+    } else if (h < 120) {
+        r = x; g = c; b = 0;
+    } else if (h < 180) {
+        r = 0; g = c; b = x;
+    } else if (h < 240) {
+        r = 0; g = x; b = c;
+    } else if (h < 300) {
+        r = x; g = 0; b = c;
+    } else {
+        r = c; g = 0; b = x;
+    }
+
+    return cv::Scalar((b + m) * 255, (g + m) * 255, (r + m) * 255);
+}
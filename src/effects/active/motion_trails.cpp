@@ -0,0 +1,28 @@
+#include "effects/active/motion_trails.h"
+#include "app/state_checkpoint.h"
+
+#include <opencv2/imgproc.hpp>
+
+MotionTrailsEffect::MotionTrailsEffect(float trail_alpha)
+    : trail_alpha_(trail_alpha) {
+}
+
+void MotionTrailsEffect::prepare(const cv::Size& size) {
+    trails_ = cv::Mat::zeros(size, CV_8UC3);
+}
+
+void MotionTrailsEffect::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    checkpoint.put(prefix + "trails", trails_);
+}
+
+void MotionTrailsEffect::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    checkpoint.restore(prefix + "trails", trails_);
+}
+
+void MotionTrailsEffect::process(const FrameContext& context, cv::Mat& out) {
+    const auto& contours = context.contours(/*cleaned=*/false);
+
+    trails_ *= trail_alpha_;
+    drawAllContours(trails_, contours, cv::Scalar(255, 255, 255), cv::FILLED);
+    out = trails_;
+}
@@ -0,0 +1,5 @@
+#include "effects/active/pass_through.h"
+
+void PassThroughEffect::process(const FrameContext& context, cv::Mat& out) {
+    out = context.input;  // shallow copy ok; display should not mutate
+}
@@ -0,0 +1,146 @@
+#include "effects/active/rainbow_trails.h"
+#include "app/state_checkpoint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/imgproc.hpp>
+
+RainbowTrailsEffect::RainbowTrailsEffect()
+    : hue_offset_(0.0f) {
+    initTables();
+}
+
+void RainbowTrailsEffect::initTables() {
+    // Hue palette at full saturation/value. With S=255, HSV->BGR is linear in V,
+    // so a trail pixel's color is just palette[hue] * V / 255.
+    cv::Mat hsv(1, RAINBOW_HUES, CV_8UC3);
+    for (int h = 0; h < RAINBOW_HUES; h++) {
+        hsv.at<cv::Vec3b>(0, h) = cv::Vec3b(static_cast<uint8_t>(h), 255, 255);
+    }
+    cv::Mat bgr;
+    cv::cvtColor(hsv, bgr, cv::COLOR_HSV2BGR);
+    for (int h = 0; h < RAINBOW_HUES; h++) {
+        const cv::Vec3b& c = bgr.at<cv::Vec3b>(0, h);
+        palette_[h * 3 + 0] = c[0];
+        palette_[h * 3 + 1] = c[1];
+        palette_[h * 3 + 2] = c[2];
+    }
+
+    // Per-intensity blend weights (Q8, 256 = 1.0):
+    //   value  = (intensity / 255)^0.7 * 255   (gamma < 1 = brighter)
+    //   alpha  = min(1, 1.2 * intensity / 255) (boosted opacity)
+    //   out    = palette * value/255 * alpha + camera * (1 - alpha)
+    for (int i = 0; i < 256; i++) {
+        float value = std::pow(i / 255.0f, 0.7f) * 255.0f;
+        float alpha = std::min(1.0f, i * 1.2f / 255.0f);
+        trail_weight_[i] = static_cast<uint16_t>(std::lround(value / 255.0f * alpha * 256.0f));
+        cam_weight_[i] = static_cast<uint16_t>(256 - std::lround(alpha * 256.0f));
+    }
+}
+
+void RainbowTrailsEffect::prepare(const cv::Size& size) {
+    trail_age_ = cv::Mat::zeros(size, CV_16UC1);
+    fg_mask_.create(size, CV_8UC1);
+    output_.create(size, CV_8UC3);
+    intensity_row_.resize(size.width);
+}
+
+void RainbowTrailsEffect::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    checkpoint.put(prefix + "trail_age", trail_age_);
+    checkpoint.putValue(prefix + "hue_offset", hue_offset_);
+}
+
+void RainbowTrailsEffect::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    checkpoint.restore(prefix + "trail_age", trail_age_);
+    double hue_offset;
+    if (checkpoint.getValue(prefix + "hue_offset", hue_offset)) {
+        hue_offset_ = static_cast<float>(hue_offset);
+    }
+}
+
+// Decay the Q8.8 trail age by 0.93, stamp the current silhouette at full age and
+// return the rounded 8-bit intensity for one row
+static void decayTrailRow(uint16_t* age, const uint8_t* fg_mask, uint8_t* intensity, int width) {
+    const uint16_t decay_q16 = 60948;  // 0.93 * 65536
+    const uint16_t full_age = 255 << 8;
+    int x = 0;
+#if CV_SIMD128
+    const cv::v_uint16x8 v_decay = cv::v_setall_u16(decay_q16);
+    const cv::v_uint16x8 v_full = cv::v_setall_u16(full_age);
+    const cv::v_uint16x8 v_half = cv::v_setall_u16(128);
+    const cv::v_uint16x8 v_zero = cv::v_setzero_u16();
+    for (; x <= width - 16; x += 16) {
+        cv::v_uint16x8 m0, m1;
+        cv::v_expand(cv::v_load(fg_mask + x), m0, m1);
+        cv::v_uint16x8 a0 = cv::v_mul_hi(cv::v_load(age + x), v_decay);
+        cv::v_uint16x8 a1 = cv::v_mul_hi(cv::v_load(age + x + 8), v_decay);
+        a0 = cv::v_select(m0 > v_zero, v_full, a0);
+        a1 = cv::v_select(m1 > v_zero, v_full, a1);
+        cv::v_store(age + x, a0);
+        cv::v_store(age + x + 8, a1);
+        cv::v_store(intensity + x, cv::v_pack((a0 + v_half) >> 8, (a1 + v_half) >> 8));
+    }
+#endif
+    for (; x < width; x++) {
+        uint16_t a = fg_mask[x] ? full_age : static_cast<uint16_t>((age[x] * decay_q16) >> 16);
+        age[x] = a;
+        intensity[x] = static_cast<uint8_t>((a + 128) >> 8);
+    }
+}
+
+void RainbowTrailsEffect::process(const FrameContext& context, cv::Mat& out) {
+    const cv::Mat& in_bgr = context.input;
+
+    // Detect current foreground (moving person) on the morphology-cleaned mask
+    // (removes small facial feature detections)
+    const auto& contours = context.contours(/*cleaned=*/true);
+
+    // Create mask for current foreground
+    fg_mask_.create(in_bgr.rows, in_bgr.cols, CV_8UC1);
+    fg_mask_.setTo(0);
+    drawAllContours(fg_mask_, contours, cv::Scalar(255), cv::FILLED);
+
+    // Time-based hue cycling for animation
+    hue_offset_ = fmod(hue_offset_ + 3.0f, 180.0f);  // Faster animation (was 2.0)
+
+    // Fused per-row pass: trail decay (0.93, slower decay = longer trails), new motion at
+    // full brightness, then gamma/hue/blend onto the camera feed. Hue varies with
+    // position (x * 0.5 + y * 0.4) for a multi-color rainbow; only pixels with intensity
+    // above the noise threshold and outside the current person get a trail.
+    const int kTrailThreshold = 20;
+    output_.create(in_bgr.rows, in_bgr.cols, CV_8UC3);
+    out = output_;
+    intensity_row_.resize(in_bgr.cols);
+    uint8_t* intensity = intensity_row_.data();
+
+    for (int y = 0; y < in_bgr.rows; y++) {
+        uint16_t* age_row = trail_age_.ptr<uint16_t>(y);
+        const uint8_t* mask_row = fg_mask_.ptr<uint8_t>(y);
+        const uint8_t* cam_row = in_bgr.ptr<uint8_t>(y);
+        uint8_t* out_row = output_.ptr<uint8_t>(y);
+
+        decayTrailRow(age_row, mask_row, intensity, in_bgr.cols);
+
+        // Start with camera feed
+        std::memcpy(out_row, cam_row, static_cast<size_t>(in_bgr.cols) * 3);
+
+        // hue(x) = floor(row_base + x / 2) mod 180, tracked in half-hue steps
+        float row_base = fmod(y * 0.4f + hue_offset_, 180.0f);
+        int half_hue = static_cast<int>(row_base * 2.0f);
+        for (int x = 0; x < in_bgr.cols; x++, half_hue++) {
+            if (half_hue >= RAINBOW_HUES * 2) half_hue -= RAINBOW_HUES * 2;
+            uint8_t i = intensity[x];
+            if (i <= kTrailThreshold || mask_row[x]) continue;
+
+            const uint8_t* pal = palette_ + (half_hue >> 1) * 3;
+            const uint32_t tw = trail_weight_[i];
+            const uint32_t cw = cam_weight_[i];
+            uint8_t* px = out_row + x * 3;
+            px[0] = static_cast<uint8_t>((pal[0] * tw + px[0] * cw + 128) >> 8);
+            px[1] = static_cast<uint8_t>((pal[1] * tw + px[1] * cw + 128) >> 8);
+            px[2] = static_cast<uint8_t>((pal[2] * tw + px[2] * cw + 128) >> 8);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#include "effects/active/silhouette.h"
+
+#include <opencv2/imgproc.hpp>
+
+SilhouetteEffect::SilhouetteEffect(Style style)
+    : style_(style) {
+}
+
+void SilhouetteEffect::prepare(const cv::Size& size) {
+    output_.create(size, CV_8UC3);
+}
+
+void SilhouetteEffect::process(const FrameContext& context, cv::Mat& out) {
+    const auto& contours = context.contours(/*cleaned=*/false);
+
+    output_.create(context.input.size(), CV_8UC3);
+    output_.setTo(0);
+    int thickness = style_ == Style::FILLED ? cv::FILLED : 2;
+    drawAllContours(output_, contours, cv::Scalar(255, 255, 255), thickness);
+    out = output_;
+}
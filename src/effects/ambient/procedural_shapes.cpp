@@ -1,4 +1,5 @@
 #include "effects/ambient/procedural_shapes.h"
+#include "app/state_checkpoint.h"
 #include <cmath>
 #include <opencv2/imgproc.hpp>
 
@@ -11,6 +12,18 @@ ProceduralShapesEffect::ProceduralShapesEffect(int width, int height)
     reset();
 }
 
+void ProceduralShapesEffect::prepare(const cv::Size& size) {
+    width_ = size.width;
+    height_ = size.height;
+    output_.create(size, CV_8UC3);
+}
+
+void ProceduralShapesEffect::process(const FrameContext& context, cv::Mat& out) {
+    // Own buffer: the caller's out may still alias last frame's (read-only) input
+    process(output_, context.input.cols, context.input.rows);
+    out = output_;
+}
+
 void ProceduralShapesEffect::reset() {
     procedural_frame_counter_ = 0;
     procedural_time_ = 0.0f;
@@ -19,6 +32,32 @@ void ProceduralShapesEffect::reset() {
     hue_shift_ = 0.0f;
     fill_mode_progress_ = 0.0f;  // 0.0 = outline only, 1.0 = filled
     color_morph_progress_ = 0.0f;  // For color morphing
+    stamp_.release();
+    stamp_points_.clear();
+}
+
+void ProceduralShapesEffect::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    checkpoint.putValue(prefix + "frame_counter", procedural_frame_counter_);
+    checkpoint.putValue(prefix + "time", procedural_time_);
+    checkpoint.putValue(prefix + "shape_type", current_shape_type_);
+    checkpoint.putValue(prefix + "shape_morph", shape_morph_progress_);
+    checkpoint.putValue(prefix + "hue_shift", hue_shift_);
+    checkpoint.putValue(prefix + "fill_mode", fill_mode_progress_);
+    checkpoint.putValue(prefix + "color_morph", color_morph_progress_);
+}
+
+void ProceduralShapesEffect::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    double value;
+    if (checkpoint.getValue(prefix + "frame_counter", value)) procedural_frame_counter_ = static_cast<int>(value);
+    if (checkpoint.getValue(prefix + "time", value)) procedural_time_ = static_cast<float>(value);
+    if (checkpoint.getValue(prefix + "shape_type", value)) {
+        current_shape_type_ = std::max(0, std::min(4, static_cast<int>(value)));
+    }
+    if (checkpoint.getValue(prefix + "shape_morph", value)) shape_morph_progress_ = static_cast<float>(value);
+    if (checkpoint.getValue(prefix + "hue_shift", value)) hue_shift_ = static_cast<float>(value);
+    if (checkpoint.getValue(prefix + "fill_mode", value)) fill_mode_progress_ = static_cast<float>(value);
+    if (checkpoint.getValue(prefix + "color_morph", value)) color_morph_progress_ = static_cast<float>(value);
+    // The shape stamp is rebuilt from these on the next frame
 }
 
 void ProceduralShapesEffect::process(cv::Mat& out_bgr, int target_width, int target_height) {
@@ -27,7 +66,9 @@ void ProceduralShapesEffect::process(cv::Mat& out_bgr, int target_width, int tar
     int output_height = (target_height > 0) ? target_height : height_;
 
     // Initialize output with black background
-    out_bgr = cv::Mat::zeros(output_height, output_width, CV_8UC3);
+    // Reuse the caller's buffer (and write into it when it is a panel ROI)
+    out_bgr.create(output_height, output_width, CV_8UC3);
+    out_bgr.setTo(0);
 
     procedural_frame_counter_++;
     procedural_time_ = procedural_frame_counter_ * 0.016f;  // ~30fps
@@ -123,6 +164,9 @@ void ProceduralShapesEffect::process(cv::Mat& out_bgr, int target_width, int tar
     int extra_rows = std::max(2, (int)((height_ - base_rows * row_spacing) / row_spacing) + 2);
     int rows = base_rows + extra_rows + 4;  // Extra padding for scrolling
 
+    // Every tile this frame has the same outline, so rasterize it once
+    updateShapeStamp(radius, current_shape_type_, shape_morph_progress_, fill_mode_progress_);
+
     for (int row = -1; row < rows; row++) {
         for (int col = -1; col < cols; col++) {
             // Calculate base position for current shape tessellation
@@ -186,10 +230,8 @@ void ProceduralShapesEffect::process(cv::Mat& out_bgr, int target_width, int tar
             float val = 0.9f + 0.1f * std::cos(procedural_time_ * 0.3f + row - col);
             cv::Scalar color = hsvToBgr(current_hue, sat, val);
 
-            // Draw shape with morphing and fill/outline mode
-            drawMorphingShape(out_bgr, (int)center_x, (int)center_y, radius,
-                             current_shape_type_, shape_morph_progress_,
-                             color, fill_mode_progress_);
+            // Tint the shape stamp (morph and fill/outline mode baked in) at this tile
+            stampShape(out_bgr, (int)center_x, (int)center_y, color);
         }
     }
 }
@@ -218,39 +260,89 @@ cv::Scalar ProceduralShapesEffect::hsvToBgr(float h, float s, float v) {
     return cv::Scalar((b + m) * 255, (g + m) * 255, (r + m) * 255);
 }
 
-// Helper function to draw morphing shapes
-void ProceduralShapesEffect::drawMorphingShape(cv::Mat& img, int cx, int cy, int radius,
-                                int shape_type, float morph_progress, cv::Scalar color,
-                                float fill_mode) {
-    std::vector<cv::Point> points;
-
+// Rasterize the morphed shape around the origin into a mask. Shape points are integer
+// offsets from the tile centre, so every tile is a translation of this stamp; it is only
+// redrawn when the morphed outline, fill or border width actually changes.
+void ProceduralShapesEffect::updateShapeStamp(int radius, int shape_type, float morph_progress,
+                                              float fill_mode) {
     // Generate points for current and next shape
     int next_shape = (shape_type + 1) % 5;
 
-    std::vector<cv::Point> current_points = getShapePoints(shape_type, cx, cy, radius);
-    std::vector<cv::Point> next_points = getShapePoints(next_shape, cx, cy, radius);
+    const std::vector<cv::Point> current_points = getShapePoints(shape_type, 0, 0, radius);
+    const std::vector<cv::Point> next_points = getShapePoints(next_shape, 0, 0, radius);
 
-    // Interpolate between shapes
+    // Interpolate between shapes (floor keeps the offsets translation-invariant,
+    // matching truncation of the absolute coordinates for on-screen tiles)
+    std::vector<cv::Point>& points = morph_points_;
+    points.clear();
     for (size_t i = 0; i < std::max(current_points.size(), next_points.size()); i++) {
         cv::Point p1 = current_points[i % current_points.size()];
         cv::Point p2 = next_points[i % next_points.size()];
-        cv::Point interpolated(
-            (int)(p1.x + (p2.x - p1.x) * morph_progress),
-            (int)(p1.y + (p2.y - p1.y) * morph_progress)
-        );
-        points.push_back(interpolated);
+        points.push_back(cv::Point(
+            (int)std::floor(p1.x + (p2.x - p1.x) * morph_progress),
+            (int)std::floor(p1.y + (p2.y - p1.y) * morph_progress)
+        ));
     }
 
-    if (points.size() >= 3) {
-        // Draw based on fill_mode: 0.0 = outline only, 1.0 = filled
-        if (fill_mode > 0.3f) {
-            // Draw filled shape
-            cv::fillPoly(img, std::vector<std::vector<cv::Point>>{points}, color);
-        }
+    // Draw based on fill_mode: 0.0 = outline only, 1.0 = filled
+    bool filled = fill_mode > 0.3f;
+    // Always draw border, but make it more prominent when in outline mode
+    int border_thickness = (fill_mode < 0.5f) ? 3 : 2;
+
+    if (!stamp_.empty() && filled == stamp_filled_ && border_thickness == stamp_thickness_ &&
+        points == stamp_points_) {
+        return;
+    }
+    stamp_points_ = points;
+    stamp_filled_ = filled;
+    stamp_thickness_ = border_thickness;
+
+    if (points.size() < 3) {
+        stamp_.release();
+        return;
+    }
+
+    // Pad the outline's bounds by the border width so thick edges are not clipped
+    cv::Rect bounds = cv::boundingRect(points);
+    int pad = border_thickness;
+    stamp_origin_ = cv::Point(pad - bounds.x, pad - bounds.y);
+    stamp_.create(bounds.height + 2 * pad, bounds.width + 2 * pad, CV_8UC1);
+    stamp_.setTo(0);
 
-        // Always draw border, but make it more prominent when in outline mode
-        int border_thickness = (fill_mode < 0.5f) ? 3 : 2;
-        cv::polylines(img, std::vector<std::vector<cv::Point>>{points}, true, color, border_thickness);
+    for (cv::Point& p : points) {
+        p += stamp_origin_;
+    }
+    const cv::Point* pts = points.data();
+    int npts = static_cast<int>(points.size());
+    if (filled) {
+        cv::fillPoly(stamp_, &pts, &npts, 1, cv::Scalar(255));
+    }
+    cv::polylines(stamp_, &pts, &npts, 1, true, cv::Scalar(255), border_thickness);
+}
+
+// Paint the stamp's set pixels in color with the shape centred at (cx, cy), clipped to img
+void ProceduralShapesEffect::stampShape(cv::Mat& img, int cx, int cy, const cv::Scalar& color) {
+    if (stamp_.empty()) return;
+
+    cv::Rect dst(cx - stamp_origin_.x, cy - stamp_origin_.y, stamp_.cols, stamp_.rows);
+    cv::Rect clipped = dst & cv::Rect(0, 0, img.cols, img.rows);
+    if (clipped.empty()) return;
+
+    const uint8_t b = cv::saturate_cast<uint8_t>(color[0]);
+    const uint8_t g = cv::saturate_cast<uint8_t>(color[1]);
+    const uint8_t r = cv::saturate_cast<uint8_t>(color[2]);
+    int sx = clipped.x - dst.x;
+    int sy = clipped.y - dst.y;
+    for (int y = 0; y < clipped.height; y++) {
+        const uint8_t* mask = stamp_.ptr<uint8_t>(sy + y) + sx;
+        uint8_t* px = img.ptr<uint8_t>(clipped.y + y) + clipped.x * 3;
+        for (int x = 0; x < clipped.width; x++, px += 3) {
+            if (mask[x]) {
+                px[0] = b;
+                px[1] = g;
+                px[2] = r;
+            }
+        }
     }
 }
 
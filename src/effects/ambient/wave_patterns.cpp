@@ -1,5 +1,7 @@
 #include "effects/ambient/wave_patterns.h"
+#include "app/state_checkpoint.h"
 #include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
 #include <opencv2/imgproc.hpp>
 
 #ifndef M_PI
@@ -8,63 +10,122 @@
 
 WavePatternsEffect::WavePatternsEffect(int width, int height)
     : width_(width), height_(height) {
+    // Hue -> BGR at full saturation and value; brightness is applied per pixel
+    for (int h = 0; h < PALETTE_HUES; h++) {
+        cv::Scalar color = hsvToBgr(static_cast<float>(h), 1.0f, 1.0f);
+        for (int c = 0; c < 3; c++) {
+            palette_[h * 3 + c] = cv::saturate_cast<uint8_t>(color[c]);
+        }
+    }
     reset();
 }
 
+void WavePatternsEffect::prepare(const cv::Size& size) {
+    width_ = size.width;
+    height_ = size.height;
+    output_.create(size, CV_8UC3);
+}
+
+void WavePatternsEffect::process(const FrameContext& context, cv::Mat& out) {
+    // Own buffer: the caller's out may still alias last frame's (read-only) input
+    process(output_, context.input.cols, context.input.rows);
+    out = output_;
+}
+
 void WavePatternsEffect::reset() {
     wave_time_ = 0.0f;
     wave_phase_ = 0.0f;
 }
 
 // Effect 8: Wave Patterns (Ambient System Mode)
+void WavePatternsEffect::saveState(StateCheckpoint& checkpoint, const std::string& prefix) const {
+    checkpoint.putValue(prefix + "time", wave_time_);
+    checkpoint.putValue(prefix + "phase", wave_phase_);
+}
+
+void WavePatternsEffect::loadState(const StateCheckpoint& checkpoint, const std::string& prefix) {
+    double value;
+    if (checkpoint.getValue(prefix + "time", value)) wave_time_ = static_cast<float>(value);
+    if (checkpoint.getValue(prefix + "phase", value)) wave_phase_ = static_cast<float>(value);
+}
+
 void WavePatternsEffect::process(cv::Mat& out_bgr, int target_width, int target_height) {
     // Use target dimensions if provided, otherwise use default dimensions
     int output_width = (target_width > 0) ? target_width : width_;
     int output_height = (target_height > 0) ? target_height : height_;
 
-    out_bgr = cv::Mat::zeros(output_height, output_width, CV_8UC3);
+    // Reuse the caller's buffer (and write into it when it is a panel ROI);
+    // every pixel is written below
+    out_bgr.create(output_height, output_width, CV_8UC3);
 
     wave_time_ += 0.05f;
     wave_phase_ += 0.02f;
 
-    // Optimize: Process at lower resolution then upscale for better performance
-    // Process at half resolution for 4x speedup
-    int proc_w = output_width / 2;
-    int proc_h = output_height / 2;
-    if (proc_w < 1) proc_w = 1;
-    if (proc_h < 1) proc_h = 1;
-
-    cv::Mat proc_frame(proc_h, proc_w, CV_8UC3);
-
-    // Create interference pattern with multiple waves at reduced resolution
-    for (int y = 0; y < proc_h; y++) {
-        for (int x = 0; x < proc_w; x++) {
-            // Scale coordinates back to original size for wave calculations
-            float fx = (x * 2.0f) * 0.1f;
-            float fy = (y * 2.0f) * 0.1f;
-
-            // Multiple sine waves for interference
-            float wave1 = std::sin(fx + wave_time_);
-            float wave2 = std::sin(fy + wave_time_ * 1.3f);
-            float wave3 = std::sin((fx + fy) * 0.07f + wave_phase_);
-
-            float combined = (wave1 + wave2 + wave3) / 3.0f;
-
-            // Map to color (hue based on position, brightness based on wave)
-            float hue = fmod((fx + fy) * 10.0f + wave_time_ * 20.0f, 360.0f);
-            float brightness = (combined + 1.0f) * 0.5f;  // Normalize to 0-1
-            cv::Scalar color = hsvToBgr(hue, 1.0f, brightness);
-
-            proc_frame.at<cv::Vec3b>(y, x) = cv::Vec3b(
-                static_cast<uint8_t>(color[0]),
-                static_cast<uint8_t>(color[1]),
-                static_cast<uint8_t>(color[2])
-            );
-        }
+    // Rendered at full resolution. Per pixel (fx = 0.1x, fy = 0.1y):
+    //   wave1 = sin(fx + t), wave2 = sin(fy + 1.3t), wave3 = sin(0.07(fx + fy) + phase)
+    //   brightness = ((wave1 + wave2 + wave3) / 3 + 1) / 2
+    //   hue = (fx + fy) * 10 + 20t = x + y + 20t  (degrees, mod 360)
+    // wave1 only depends on x and wave2 only on y, and wave3 splits with
+    // sin(a + b) = sin(a)cos(b) + cos(a)sin(b), so every sin() goes into a
+    // per-column or per-row table and the per-pixel work is a few multiply-adds
+    // plus a palette lookup.
+    col_wave_.resize(output_width);
+    col_sin3_.resize(output_width);
+    col_cos3_.resize(output_width);
+    row_brightness_.resize(output_width);
+    for (int x = 0; x < output_width; x++) {
+        float fx = x * 0.1f;
+        float a = fx * 0.07f + wave_phase_;
+        col_wave_[x] = std::sin(fx + wave_time_);
+        col_sin3_[x] = std::sin(a);
+        col_cos3_[x] = std::cos(a);
     }
 
-    // Upscale to target resolution
-    cv::resize(proc_frame, out_bgr, cv::Size(output_width, output_height), 0, 0, cv::INTER_LINEAR);
+    float hue_base = std::fmod(wave_time_ * 20.0f, 360.0f);
+
+    for (int y = 0; y < output_height; y++) {
+        float fy = y * 0.1f;
+        float b = fy * 0.07f;
+        float wave2 = std::sin(fy + wave_time_ * 1.3f);
+        float sin_b = std::sin(b);
+        float cos_b = std::cos(b);
+
+        // brightness * 256 = 128 + (128/3) * (wave1 + wave2 + wave3), in Q8 so
+        // the palette blend below is an integer multiply and shift
+        const float scale = 128.0f / 3.0f;
+        const float offset = 128.0f + wave2 * scale;
+        int32_t* brightness = row_brightness_.data();
+        int x = 0;
+#if CV_SIMD128
+        const cv::v_float32x4 v_scale = cv::v_setall_f32(scale);
+        const cv::v_float32x4 v_offset = cv::v_setall_f32(offset);
+        const cv::v_float32x4 v_cos_b = cv::v_setall_f32(cos_b);
+        const cv::v_float32x4 v_sin_b = cv::v_setall_f32(sin_b);
+        for (; x <= output_width - 4; x += 4) {
+            cv::v_float32x4 sum = cv::v_muladd(cv::v_load(col_sin3_.data() + x), v_cos_b,
+                                               cv::v_load(col_wave_.data() + x));
+            sum = cv::v_muladd(cv::v_load(col_cos3_.data() + x), v_sin_b, sum);
+            cv::v_store(brightness + x, cv::v_round(cv::v_muladd(sum, v_scale, v_offset)));
+        }
+#endif
+        for (; x < output_width; x++) {
+            float sum = col_wave_[x] + col_sin3_[x] * cos_b + col_cos3_[x] * sin_b;
+            brightness[x] = static_cast<int32_t>(std::lround(sum * scale + offset));
+        }
+
+        // Hue steps one degree per column, so walk the palette instead of fmod per pixel
+        int hue = static_cast<int>(std::fmod(y + hue_base, 360.0f));
+        uint8_t* out_row = out_bgr.ptr<uint8_t>(y);
+        for (x = 0; x < output_width; x++) {
+            const uint8_t* pal = palette_ + hue * 3;
+            const int32_t v = brightness[x];
+            uint8_t* px = out_row + x * 3;
+            px[0] = static_cast<uint8_t>((pal[0] * v) >> 8);
+            px[1] = static_cast<uint8_t>((pal[1] * v) >> 8);
+            px[2] = static_cast<uint8_t>((pal[2] * v) >> 8);
+            if (++hue == PALETTE_HUES) hue = 0;
+        }
+    }
 }
 
 // Helper function to convert HSV to BGR
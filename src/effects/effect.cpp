@@ -0,0 +1,34 @@
+#include "effects/effect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+const std::vector<std::vector<cv::Point>>& FrameContext::contours(bool cleaned) const {
+    return segmentation->contours(min_contour_area, cleaned, roi);
+}
+
+cv::Mat FrameContext::foregroundMask() const {
+    return segmentation->foregroundMask()(roi);
+}
+
+double FrameContext::scaledLength(double length) const {
+    return std::max(1.0, length * std::sqrt(area_scale));
+}
+
+int FrameContext::scaledKernelSize(int size) const {
+    return scaledKernelSize(size, area_scale);
+}
+
+int FrameContext::scaledKernelSize(int size, double area_scale) {
+    // Keep kernels odd and at least 3x3 so the morphology/blur still has an effect
+    int scaled = static_cast<int>(std::lround(size * std::sqrt(area_scale))) | 1;
+    return std::max(3, std::min(size, scaled));
+}
+
+void drawAllContours(cv::Mat& img, const std::vector<std::vector<cv::Point>>& contours,
+                     const cv::Scalar& color, int thickness) {
+    for (size_t i = 0; i < contours.size(); i++) {
+        cv::drawContours(img, contours, static_cast<int>(i), color, thickness);
+    }
+}
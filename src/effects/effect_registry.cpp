@@ -0,0 +1,81 @@
+#include "effects/effect_registry.h"
+
+#include "app/app_core.h"
+#include "effects/active/double_exposure.h"
+#include "effects/active/geometric_abstraction.h"
+#include "effects/active/motion_trails.h"
+#include "effects/active/pass_through.h"
+#include "effects/active/rainbow_trails.h"
+#include "effects/active/silhouette.h"
+#include "effects/ambient/procedural_shapes.h"
+#include "effects/ambient/wave_patterns.h"
+
+template <typename T, typename... Args>
+static EffectRegistry::Factory makeFactory(Args... args) {
+    return [=]() { return std::unique_ptr<IEffect>(new T(args...)); };
+}
+
+static void registerBuiltinEffects(EffectRegistry& registry) {
+    registry.registerEffect(static_cast<int>(Effect::DEBUG), "Debug View",
+                            makeFactory<PassThroughEffect>());
+    registry.registerEffect(static_cast<int>(Effect::FILLED_SILHOUETTE), "Filled Silhouette",
+                            makeFactory<SilhouetteEffect>(SilhouetteEffect::Style::FILLED));
+    registry.registerEffect(static_cast<int>(Effect::OUTLINE_ONLY), "Outline Only",
+                            makeFactory<SilhouetteEffect>(SilhouetteEffect::Style::OUTLINE));
+    registry.registerEffect(static_cast<int>(Effect::MOTION_TRAILS), "Motion Trails",
+                            makeFactory<MotionTrailsEffect>());
+    registry.registerEffect(static_cast<int>(Effect::RAINBOW_MOTION_TRAILS), "Rainbow Motion Trails",
+                            makeFactory<RainbowTrailsEffect>());
+    registry.registerEffect(static_cast<int>(Effect::DOUBLE_EXPOSURE), "Double Exposure",
+                            makeFactory<DoubleExposureEffect>());
+    registry.registerEffect(static_cast<int>(Effect::PROCEDURAL_SHAPES), "Procedural Shapes",
+                            makeFactory<ProceduralShapesEffect>());
+    registry.registerEffect(static_cast<int>(Effect::WAVE_PATTERNS), "Wave Patterns",
+                            makeFactory<WavePatternsEffect>());
+    registry.registerEffect(static_cast<int>(Effect::GEOMETRIC_ABSTRACTION), "Geometric Abstraction",
+                            makeFactory<GeometricAbstractionEffect>());
+}
+
+EffectRegistry& EffectRegistry::instance() {
+    static EffectRegistry* registry = [] {
+        EffectRegistry* r = new EffectRegistry();
+        registerBuiltinEffects(*r);
+        return r;
+    }();
+    return *registry;
+}
+
+void EffectRegistry::registerEffect(int id, const std::string& name, Factory factory) {
+    // Inputs are fixed per effect type; read them once from a probe instance
+    // (constructors only set parameters, buffers come with prepare())
+    uint32_t inputs = factory()->inputs();
+    entries_[id] = Entry{name, inputs, std::move(factory)};
+}
+
+bool EffectRegistry::contains(int id) const {
+    return entries_.count(id) != 0;
+}
+
+std::unique_ptr<IEffect> EffectRegistry::create(int id) const {
+    auto it = entries_.find(id);
+    if (it == entries_.end()) return nullptr;
+    return it->second.factory();
+}
+
+uint32_t EffectRegistry::getInputs(int id) const {
+    auto it = entries_.find(id);
+    return it != entries_.end() ? it->second.inputs : 0;
+}
+
+const char* EffectRegistry::getName(int id) const {
+    auto it = entries_.find(id);
+    return it != entries_.end() ? it->second.name.c_str() : "Unknown";
+}
+
+std::vector<int> EffectRegistry::getIds() const {
+    std::vector<int> ids;
+    for (const auto& entry : entries_) {
+        ids.push_back(entry.first);
+    }
+    return ids;
+}
@@ -0,0 +1,175 @@
+#include "components/matrix_display.h"
+#include "components/tile_receiver.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <pwd.h>
+#include <string>
+#include <unistd.h>
+
+volatile bool running = true;
+
+void signalHandler(int signum) {
+    std::cout << "\nInterrupt signal (" << signum << ") received. Exiting...\n";
+    running = false;
+}
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "Shows one tile of a frame sent by camera_to_matrix / rpicam_to_matrix /\n"
+              << "desktop_to_matrix --send-tiles on this node's LED matrix.\n"
+              << "Options:\n"
+              << "  --port PORT                    UDP port to listen on (default: 5005)\n"
+              << "  --tile N                       Tile index: position in the sender's --send-tiles list,\n"
+              << "                                 0 = leftmost (default: 0)\n"
+              << "\n"
+              << "Matrix configuration:\n"
+              << "  --led-rows ROWS                Matrix rows per panel (default: 64)\n"
+              << "  --led-cols COLS                Matrix columns per panel (default: 64)\n"
+              << "  --led-chain CHAIN              Number of chained matrices (default: 1)\n"
+              << "  --led-parallel PARALLEL        Number of parallel chains (default: 1)\n"
+              << "  --led-hardware-mapping MAP     Hardware mapping: regular, adafruit-hat, adafruit-hat-pwm (default: regular)\n"
+              << "  --led-brightness N             LED brightness 0-100 (default: 50)\n"
+              << "  --led-slowdown-gpio N          GPIO slowdown for stability (default: 4, try 2-4)\n"
+              << "  --led-pwm-bits N               PWM bits for color depth (default: 11, range: 1-11)\n"
+              << "  --led-pwm-dither-bits N        Dither bits for temporal dithering (default: 0, range: 0-2)\n"
+              << "  --led-pwm-lsb-nanoseconds N    PWM LSB nanoseconds (default: 130, range: 50-3000)\n"
+              << "  --led-limit-refresh N          Limit refresh rate to N Hz (default: 0 = no limit)\n"
+              << "  --output-gamma G               Apply gamma G, brightness and PWM levels in our output LUT\n"
+              << "                                 instead of the library (e.g. 2.2; default: off)\n"
+              << "  --output-dither                Temporal dithering between PWM levels (with --output-gamma)\n"
+              << "  --scale-filter FILTER          Tile-to-matrix filter when the sizes differ: nearest, area\n"
+              << "                                 (default: nearest)\n"
+              << "\n"
+              << "  --help                         Show this help message\n"
+              << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    signal(SIGINT, signalHandler);
+    signal(SIGTERM, signalHandler);
+
+    int port = 5005;
+    int tile_index = 0;
+    int rows = 64;
+    int cols = 64;
+    int chain_length = 1;
+    int parallel = 1;
+    std::string hardware_mapping = "regular";
+    int brightness = 50;
+    int gpio_slowdown = 4;
+    int pwm_bits = 11;
+    int pwm_dither_bits = 0;
+    int pwm_lsb_nanoseconds = 130;
+    int limit_refresh_rate_hz = 0;
+    FrameScaler::Mode scale_mode = FrameScaler::Mode::NEAREST;
+    double output_gamma = 0.0;  // 0 = library luminance correction
+    bool output_dither = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--tile") == 0 && i + 1 < argc) {
+            tile_index = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-rows") == 0 && i + 1 < argc) {
+            rows = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-cols") == 0 && i + 1 < argc) {
+            cols = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-chain") == 0 && i + 1 < argc) {
+            chain_length = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-parallel") == 0 && i + 1 < argc) {
+            parallel = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-hardware-mapping") == 0 && i + 1 < argc) {
+            hardware_mapping = argv[++i];
+        } else if (strcmp(argv[i], "--led-brightness") == 0 && i + 1 < argc) {
+            brightness = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-slowdown-gpio") == 0 && i + 1 < argc) {
+            gpio_slowdown = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-pwm-bits") == 0 && i + 1 < argc) {
+            pwm_bits = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-pwm-dither-bits") == 0 && i + 1 < argc) {
+            pwm_dither_bits = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-pwm-lsb-nanoseconds") == 0 && i + 1 < argc) {
+            pwm_lsb_nanoseconds = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-limit-refresh") == 0 && i + 1 < argc) {
+            limit_refresh_rate_hz = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output-gamma") == 0 && i + 1 < argc) {
+            output_gamma = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--output-dither") == 0) {
+            output_dither = true;
+        } else if (strcmp(argv[i], "--scale-filter") == 0 && i + 1 < argc) {
+            const char* filter = argv[++i];
+            if (strcmp(filter, "nearest") == 0) {
+                scale_mode = FrameScaler::Mode::NEAREST;
+            } else if (strcmp(filter, "area") == 0) {
+                scale_mode = FrameScaler::Mode::AREA;
+            } else {
+                std::cerr << "Unknown scale filter: " << filter << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    MatrixDisplay matrix(rows, cols, chain_length, parallel, hardware_mapping, brightness,
+                         gpio_slowdown, pwm_bits, pwm_dither_bits, pwm_lsb_nanoseconds,
+                         limit_refresh_rate_hz);
+    if (!matrix.isReady()) {
+        std::cerr << "Failed to create RGB matrix" << std::endl;
+        return 1;
+    }
+    matrix.setInputOrder(PixelOrder::RGB);
+    matrix.setScaleMode(scale_mode);
+    if (output_gamma > 0.0) {
+        matrix.setOutputCurve(output_gamma, output_dither);
+    }
+
+    // Bind before dropping privileges (ports below 1024)
+    TileReceiver receiver(port, tile_index);
+    if (!receiver.isOpen()) return 1;
+
+    if (geteuid() == 0) {
+        const char* sudo_user = std::getenv("SUDO_USER");
+        const char* target_user = sudo_user ? sudo_user : "pi";
+        struct passwd *pw = getpwnam(target_user);
+        if (pw) {
+            setgid(pw->pw_gid);
+            setuid(pw->pw_uid);
+        }
+    }
+
+    std::cout << "Matrix size: " << matrix.getWidth() << "x" << matrix.getHeight()
+              << ", waiting for tile " << tile_index << "... (Ctrl+C to stop)" << std::endl;
+
+    auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    uint64_t reported_frames = 0;
+    while (running) {
+        // Short timeout so Ctrl+C is noticed while the sender is quiet
+        if (receiver.receive(100)) {
+            // Tiles keep their size, so the scaler tables are only built once
+            matrix.displayFrame(const_cast<uint8_t*>(receiver.getData()), receiver.getWidth(),
+                                receiver.getHeight());
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_report) {
+            uint64_t frames = receiver.getFrameCount();
+            std::cout << "[RECEIVER] " << (frames - reported_frames) / 10.0 << " fps, "
+                      << receiver.getLostFrames() << " frame(s) lost in total" << std::endl;
+            reported_frames = frames;
+            next_report = now + std::chrono::seconds(10);
+        }
+    }
+
+    std::cout << "Frames shown: " << receiver.getFrameCount() << std::endl;
+    return 0;
+}
@@ -1,55 +1,95 @@
+#include "app/app_core.h"
+#include "components/debug_data_collector.h"
+#include "components/frame_recording.h"
+#include "components/matrix_display.h"
+#include "components/network_output_sink.h"
+#include "components/stdin_frame_source.h"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
 #include <iostream>
 #include <memory>
+#include <chrono>
 #include <csignal>
+#include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
 #include <pwd.h>
-#include <led-matrix.h>
-
-using rgb_matrix::RGBMatrix;
-using rgb_matrix::RuntimeOptions;
-using rgb_matrix::FrameCanvas;
+#include <vector>
 
 volatile bool running = true;
+// Set while stdin is the input, so Ctrl+C also ends a read() waiting on a stalled pipe
+StdinFrameSource* volatile stdin_to_stop = nullptr;
 
 void signalHandler(int signum) {
     std::cout << "\nInterrupt signal (" << signum << ") received. Exiting...\n";
     running = false;
+    if (stdin_to_stop) {
+        stdin_to_stop->stop();
+    }
 }
 
+// AppCore effects on frames from any FrameSource (stdin pipe, recording), shown through
+// MatrixDisplay. The source's pixel order is resolved here, once per frame, before the
+// BGR-only effect pipeline; BGR sources (ffmpeg -pix_fmt bgr24) need no conversion at all.
 class RpicamToMatrix {
 public:
-    RpicamToMatrix(int rows, int cols, 
+    RpicamToMatrix(int width, int height, int rows, int cols,
                    int chain_length = 1, int parallel = 1,
                    const std::string& hardware_mapping = "regular",
                    int brightness = 50, int gpio_slowdown = 3,
-                   int pwm_bits = 11, int pwm_lsb_nanoseconds = 130,
+                   int pwm_bits = 11, int pwm_dither_bits = 0,
+                   int pwm_lsb_nanoseconds = 130,
                    int limit_refresh_rate_hz = 0)
-        : rows_(rows), cols_(cols),
-          chain_length_(chain_length), parallel_(parallel),
-          hardware_mapping_(hardware_mapping),
-          brightness_(brightness), gpio_slowdown_(gpio_slowdown),
-          pwm_bits_(pwm_bits), pwm_lsb_nanoseconds_(pwm_lsb_nanoseconds),
-          limit_refresh_rate_hz_(limit_refresh_rate_hz) {
-        setupMatrix();
+        : matrix_(rows, cols, chain_length, parallel, hardware_mapping,
+                  brightness, gpio_slowdown, pwm_bits, pwm_dither_bits,
+                  pwm_lsb_nanoseconds, limit_refresh_rate_hz),
+          core_(width, height, chain_length) {}
+
+    AppCore& getCore() { return core_; }
+
+    void setScaleMode(FrameScaler::Mode mode) {
+        matrix_.setScaleMode(mode);
     }
 
-    ~RpicamToMatrix() {
-        cleanup();
+    void setOutputCurve(double gamma, bool dither) {
+        matrix_.setOutputCurve(gamma, dither);
     }
 
-    bool initialize() {
-        if (!matrix_) {
-            std::cerr << "Failed to create RGB matrix" << std::endl;
-            return false;
-        }
-        return true;
+    // Adaptive quality against the collector's CPU temperature (sampled once per second)
+    void setQualityGovernor(double target_fps, float target_temp_c) {
+        core_.setQualityGovernor(target_fps, target_temp_c,
+                                 [this]() { return debug_data_collector_.getTemperature(); });
+    }
+
+    // Also send every processed frame, split into one tile per endpoint, to matrix_receiver
+    // nodes (tile_width x tile_height each; 0 = this matrix's size)
+    bool setTileOutput(const std::vector<std::string>& endpoints, int tile_width, int tile_height,
+                       FrameScaler::Mode mode) {
+        tile_sink_ = std::make_unique<NetworkOutputSink>(
+            endpoints, tile_width > 0 ? tile_width : matrix_.getWidth(),
+            tile_height > 0 ? tile_height : matrix_.getHeight());
+        tile_sink_->setScaleMode(mode);
+        return tile_sink_->isReady();
+    }
+
+    // Record every input frame to path (raw, replayable with --replay)
+    bool setRecording(const std::string& path) {
+        return recorder_.open(path);
     }
 
-    void run(int input_width, int input_height) {
-        if (!initialize()) {
-            std::cerr << "Failed to initialize matrix" << std::endl;
+    // Per-stage timing (process per effect, display, vsync), logged every report_seconds
+    void setStageTiming(bool enabled, int report_seconds = 5) {
+        stage_timing_ = enabled;
+        timing_report_seconds_ = std::max(1, report_seconds);
+        matrix_.setTimingCollector(enabled ? &debug_data_collector_ : nullptr);
+    }
+
+    // source: stdin reader or a recording; runs until it ends or Ctrl+C
+    void run(FrameSource& source) {
+        if (!matrix_.isReady()) {
+            std::cerr << "Failed to create RGB matrix" << std::endl;
             return;
         }
 
@@ -63,146 +103,73 @@ public:
             }
         }
 
-        int matrix_width = canvas_->width();
-        int matrix_height = canvas_->height();
-        
-        if (!canvas_) {
-            std::cerr << "ERROR: Canvas is null!" << std::endl;
-            return;
-        }
-
         std::cerr << "Matrix initialized successfully!" << std::endl;
-        std::cerr << "Matrix size: " << matrix_width << "x" << matrix_height << std::endl;
-        std::cerr << "Reading from stdin..." << std::endl;
-        std::cerr << "Input resolution: " << input_width << "x" << input_height << std::endl;
-        std::cerr << "Frame size: " << (input_width * input_height * 3) << " bytes" << std::endl;
+        std::cerr << "Matrix size: " << matrix_.getWidth() << "x" << matrix_.getHeight() << std::endl;
         std::cerr << "Press Ctrl+C to stop" << std::endl;
 
-        // Disable buffering on stdin for real-time reading
-        setvbuf(stdin, NULL, _IONBF, 0);
-        std::cin.sync_with_stdio(false);
-        std::cin.tie(nullptr);
-
-        // Read raw RGB888 frames from stdin
-        size_t frame_size = input_width * input_height * 3;
-        std::vector<uint8_t> frame_buffer(frame_size);
+        DebugDataCollector* timing = stage_timing_ ? &debug_data_collector_ : nullptr;
+        auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(timing_report_seconds_);
         size_t frame_count = 0;
+        FrameView frame;
+        cv::Mat out_bgr;
 
-        while (running) {
-            // Read one complete frame (raw RGB888)
-            std::cin.read(reinterpret_cast<char*>(frame_buffer.data()), frame_size);
-            size_t bytes_read = std::cin.gcount();
-            
-            if (bytes_read == 0) {
-                if (std::cin.eof()) {
-                    std::cerr << "End of input (EOF)" << std::endl;
-                    break;
-                }
-                if (std::cin.fail()) {
-                    std::cerr << "Read error or no data available" << std::endl;
-                    usleep(10000); // Wait a bit before retrying
-                    continue;
-                }
-                break;
+        while (running && source.read(frame)) {
+            if (recorder_.isOpen()) {
+                recorder_.record(frame);
             }
 
-            if (bytes_read < frame_size) {
-                std::cerr << "Warning: Incomplete frame (" << bytes_read 
-                          << " bytes, expected " << frame_size << ")" << std::endl;
-                // Try to read the rest
-                std::cin.read(reinterpret_cast<char*>(frame_buffer.data() + bytes_read), 
-                             frame_size - bytes_read);
-                bytes_read += std::cin.gcount();
-                if (bytes_read < frame_size) {
-                    std::cerr << "Still incomplete, skipping frame" << std::endl;
-                    continue;
+            const cv::Mat& in_bgr = toBgr(frame);
+            {
+                DebugDataCollector::ScopedTimer timer(timing, DebugDataCollector::Stage::PROCESS,
+                                                      static_cast<int>(core_.getEffect()));
+                core_.processFrame(in_bgr, out_bgr);
+            }
+            if (!out_bgr.empty()) {
+                // Remote tiles first: our own display then waits for vsync
+                if (tile_sink_) {
+                    tile_sink_->writeFrame(out_bgr.data, out_bgr.cols, out_bgr.rows,
+                                           static_cast<int>(out_bgr.step), PixelOrder::BGR);
                 }
+                matrix_.displayFrame(out_bgr.data, out_bgr.cols, out_bgr.rows,
+                                     static_cast<int>(out_bgr.step));
             }
-
-            // Display frame on matrix
-            displayFrame(frame_buffer.data(), input_width, input_height);
             frame_count++;
-            
-            if (frame_count % 30 == 0) {
+
+            if (stage_timing_ && std::chrono::steady_clock::now() >= next_report) {
+                std::cout << debug_data_collector_.takeReport() << std::flush;
+                next_report += std::chrono::seconds(timing_report_seconds_);
+            }
+            if (frame_count % 300 == 0) {
                 std::cerr << "Processed " << frame_count << " frames..." << std::endl;
             }
         }
+        recorder_.close();
 
         std::cerr << "Total frames processed: " << frame_count << std::endl;
-
-        std::cout << "End of input" << std::endl;
     }
 
 private:
-    void setupMatrix() {
-        RGBMatrix::Options options;
-        options.rows = rows_;
-        options.cols = cols_;
-        options.chain_length = chain_length_;
-        options.parallel = parallel_;
-        options.hardware_mapping = hardware_mapping_.c_str();
-        options.brightness = brightness_;
-        options.pwm_bits = pwm_bits_;
-        options.pwm_lsb_nanoseconds = pwm_lsb_nanoseconds_;
-        options.limit_refresh_rate_hz = limit_refresh_rate_hz_;
-        options.disable_hardware_pulsing = true;
-        options.show_refresh_rate = true;
-        
-        RuntimeOptions runtime_options;
-        runtime_options.drop_privileges = 0;
-        runtime_options.gpio_slowdown = gpio_slowdown_;
-        
-        matrix_ = RGBMatrix::CreateFromOptions(options, runtime_options);
-        if (matrix_) {
-            canvas_ = matrix_->CreateFrameCanvas();
-        }
-    }
-
-    void displayFrame(uint8_t *data, int width, int height) {
-        if (!canvas_) {
-            std::cerr << "ERROR: Canvas is null in displayFrame!" << std::endl;
-            return;
+    // Wrap (BGR) or convert (RGB, one SIMD pass) a source frame for AppCore
+    const cv::Mat& toBgr(const FrameView& frame) {
+        input_ = cv::Mat(frame.height, frame.width, CV_8UC3, const_cast<uint8_t*>(frame.data),
+                         static_cast<size_t>(frame.stride));
+        if (frame.order == PixelOrder::BGR) {
+            return input_;
         }
-
-        int matrix_width = canvas_->width();
-        int matrix_height = canvas_->height();
-
-        for (int y = 0; y < matrix_height; y++) {
-            for (int x = 0; x < matrix_width; x++) {
-                int src_x = (x * width) / matrix_width;
-                int src_y = (y * height) / matrix_height;
-                
-                int src_idx = (src_y * width + src_x) * 3;
-                uint8_t r = data[src_idx];
-                uint8_t g = data[src_idx + 1];
-                uint8_t b = data[src_idx + 2];
-
-                // FFmpeg outputs RGB888, use directly
-                canvas_->SetPixel(x, y, r, g, b);
-            }
-        }
-
-        canvas_ = matrix_->SwapOnVSync(canvas_);
+        cv::cvtColor(input_, converted_, cv::COLOR_RGB2BGR);
+        return converted_;
     }
 
-    void cleanup() {
-        if (matrix_) {
-            matrix_->Clear();
-        }
-    }
+    MatrixDisplay matrix_;
+    AppCore core_;
+    DebugDataCollector debug_data_collector_;
+    FrameRecorder recorder_;
+    std::unique_ptr<NetworkOutputSink> tile_sink_;  // --send-tiles
+    cv::Mat input_;      // View of the current source frame
+    cv::Mat converted_;  // BGR copy for RGB sources
 
-    int rows_;
-    int cols_;
-    int chain_length_;
-    int parallel_;
-    std::string hardware_mapping_;
-    int brightness_;
-    int gpio_slowdown_;
-    int pwm_bits_;
-    int pwm_lsb_nanoseconds_;
-    int limit_refresh_rate_hz_;
-    RGBMatrix *matrix_;
-    FrameCanvas *canvas_;
+    bool stage_timing_ = false;
+    int timing_report_seconds_ = 5;
 };
 
 void printUsage(const char* program) {
@@ -211,6 +178,32 @@ void printUsage(const char* program) {
               << "Input options:\n"
               << "  --width WIDTH                  Input video width (default: 640)\n"
               << "  --height HEIGHT                Input video height (default: 480)\n"
+              << "  --input-format FORMAT          Raw stdin pixel format: rgb24 (default) or bgr24\n"
+              << "                                 (bgr24 feeds the effects without any conversion)\n"
+              << "  --every-frame                  Display every stdin frame in order (default: newest frame;\n"
+              << "                                 a reader thread drains the pipe and stale frames are skipped)\n"
+              << "  --record FILE                  Record input frames to FILE for later --replay\n"
+              << "  --replay FILE                  Read frames from a recording instead of stdin\n"
+              << "                                 (any runner's recording; size comes from the file)\n"
+              << "  --replay-speed SPEED           native: recorded timing (default), max: as fast as possible\n"
+              << "  --replay-loop                  Restart the recording when it ends\n"
+              << "\n"
+              << "Effects:\n"
+              << "  --effect N                     Effect 1-9 (default: 1 = pass-through)\n"
+              << "  --auto-cycle                   Cycle through the effects of the current mode\n"
+              << "  --auto-mode                    Switch Ambient/Active automatically from scene activity\n"
+              << "  --process-scale N              Run effects at N x matrix resolution (default: 0 = input resolution)\n"
+              << "  --bg-model MODEL               Background subtraction: mog2, mog2-fast, average, diff (default: mog2)\n"
+              << "  --segment-every N              Run segmentation every Nth frame, reuse the silhouette in between (default: 1)\n"
+              << "  --segment-change F             With --segment-every: segment early once F of the scene changed (e.g. 0.02)\n"
+              << "  --state-file PATH              Restore the learned background and effect state from PATH, save it every 30s\n"
+              << "  --transition-frames N          Crossfade effect switches over N frames (default: 30, 0 = cut)\n"
+              << "  --target-fps F                 Lower quality step by step to keep processing at F fps (default: off)\n"
+              << "  --target-temp C                Lower quality while the CPU is above C degrees (default: off)\n"
+              << "  --stage-timing [SECONDS]       Log process/display/vsync p50/p95/p99 every SECONDS (default: 5)\n"
+              << "  --send-tiles HOST:PORT,...     Also send the output split into one tile per receiver (left to right)\n"
+              << "                                 to matrix_receiver nodes over UDP\n"
+              << "  --tile-size WxH                Size of each sent tile (default: this matrix's size)\n"
               << "\n"
               << "Matrix configuration:\n"
               << "  --led-rows ROWS                Matrix rows per panel (default: 64)\n"
@@ -224,19 +217,25 @@ void printUsage(const char* program) {
               << "  --led-slowdown-gpio N          GPIO slowdown for stability (default: 4, try 2-4)\n"
               << "  --led-pwm-bits N               PWM bits for color depth (default: 11, range: 1-11)\n"
               << "                                 Lower values = less CPU, higher refresh rate, fewer colors\n"
+              << "  --led-pwm-dither-bits N        Dither bits for temporal dithering (default: 0, range: 0-2)\n"
               << "  --led-pwm-lsb-nanoseconds N    PWM LSB nanoseconds (default: 130, range: 50-3000)\n"
               << "                                 Lower values = higher refresh rate, more ghosting\n"
               << "  --led-limit-refresh N          Limit refresh rate to N Hz (default: 0 = no limit)\n"
+              << "  --output-gamma G               Apply gamma G, brightness and PWM levels in our output LUT\n"
+              << "                                 instead of the library (e.g. 2.2; default: off)\n"
+              << "  --output-dither                Temporal dithering between PWM levels (with --output-gamma)\n"
+              << "                                 Keeps gradients smooth at low --led-pwm-bits\n"
+              << "  --scale-filter FILTER          Downscale filter: nearest, area (default: nearest)\n"
               << "\n"
               << "  --help                         Show this help message\n"
               << "\n"
-              << "Reads raw RGB888 frames from stdin and displays on LED matrix.\n"
+              << "Reads raw 24-bit frames from stdin, runs the selected effect and displays on LED matrix.\n"
               << "\n"
               << "Example with rpicam-vid:\n"
               << "  rpicam-vid -t 0 --width 640 --height 480 --codec yuv420 -o - | \\\n"
               << "    ffmpeg -loglevel error -f rawvideo -pix_fmt yuv420p -s 640x480 -r 30 -i - \\\n"
-              << "    -f rawvideo -pix_fmt rgb24 - | \\\n"
-              << "    sudo " << program << " --width 640 --height 480\n"
+              << "    -f rawvideo -pix_fmt bgr24 - | \\\n"
+              << "    sudo " << program << " --width 640 --height 480 --input-format bgr24 --effect 2\n"
               << std::endl;
 }
 
@@ -254,8 +253,34 @@ int main(int argc, char *argv[]) {
     int brightness = 50;
     int gpio_slowdown = 4;
     int pwm_bits = 11;
+    int pwm_dither_bits = 0;
     int pwm_lsb_nanoseconds = 130;
     int limit_refresh_rate_hz = 0;
+    FrameScaler::Mode scale_mode = FrameScaler::Mode::NEAREST;
+    double output_gamma = 0.0;  // 0 = library luminance correction
+    bool output_dither = false;
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    ReplayFrameSource::Speed replay_speed = ReplayFrameSource::Speed::NATIVE;
+    bool replay_loop = false;
+    StdinFrameSource::Mode stdin_mode = StdinFrameSource::Mode::LATEST;
+    PixelOrder input_order = PixelOrder::RGB;
+    int effect_num = 1;
+    bool auto_cycle = false;
+    bool auto_mode = false;
+    int process_scale = 0;  // 0 = input resolution
+    BackgroundModel::Type bg_model = BackgroundModel::Type::MOG2;
+    int segment_every = 1;
+    double segment_change = 0.0;
+    const char* state_file = nullptr;
+    int transition_frames = 30;
+    double target_fps = 0.0;  // 0 = no quality governor
+    float target_temp = 0.0f;
+    bool stage_timing = false;
+    int timing_report_seconds = 5;
+    std::vector<std::string> tile_endpoints;
+    int tile_width = 0;  // 0 = matrix size
+    int tile_height = 0;
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
@@ -265,6 +290,82 @@ int main(int argc, char *argv[]) {
             input_width = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
             input_height = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--input-format") == 0 && i + 1 < argc) {
+            const char* format = argv[++i];
+            if (strcmp(format, "rgb24") == 0) {
+                input_order = PixelOrder::RGB;
+            } else if (strcmp(format, "bgr24") == 0) {
+                input_order = PixelOrder::BGR;
+            } else {
+                std::cerr << "Unknown input format: " << format << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--effect") == 0 && i + 1 < argc) {
+            effect_num = std::atoi(argv[++i]);
+            if (effect_num < 1 || effect_num > 9) {
+                std::cerr << "Effect must be 1-9" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--auto-cycle") == 0) {
+            auto_cycle = true;
+        } else if (strcmp(argv[i], "--auto-mode") == 0) {
+            auto_mode = true;
+        } else if (strcmp(argv[i], "--process-scale") == 0 && i + 1 < argc) {
+            process_scale = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bg-model") == 0 && i + 1 < argc) {
+            const char* model = argv[++i];
+            if (!BackgroundModel::parseType(model, bg_model)) {
+                std::cerr << "Unknown background model: " << model << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--segment-every") == 0 && i + 1 < argc) {
+            segment_every = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--segment-change") == 0 && i + 1 < argc) {
+            segment_change = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--state-file") == 0 && i + 1 < argc) {
+            state_file = argv[++i];
+        } else if (strcmp(argv[i], "--transition-frames") == 0 && i + 1 < argc) {
+            transition_frames = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--target-fps") == 0 && i + 1 < argc) {
+            target_fps = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--target-temp") == 0 && i + 1 < argc) {
+            target_temp = static_cast<float>(std::atof(argv[++i]));
+        } else if (strcmp(argv[i], "--stage-timing") == 0) {
+            stage_timing = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                timing_report_seconds = std::atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--send-tiles") == 0 && i + 1 < argc) {
+            if (!NetworkOutputSink::parseEndpoints(argv[++i], tile_endpoints)) {
+                std::cerr << "--send-tiles expects HOST:PORT[,HOST:PORT...]" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &tile_width, &tile_height) != 2 || tile_width <= 0 || tile_height <= 0) {
+                std::cerr << "--tile-size expects WIDTHxHEIGHT" << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--every-frame") == 0) {
+            stdin_mode = StdinFrameSource::Mode::SEQUENTIAL;
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            const char* speed = argv[++i];
+            if (strcmp(speed, "native") == 0) {
+                replay_speed = ReplayFrameSource::Speed::NATIVE;
+            } else if (strcmp(speed, "max") == 0) {
+                replay_speed = ReplayFrameSource::Speed::MAX;
+            } else {
+                std::cerr << "Unknown replay speed: " << speed << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--replay-loop") == 0) {
+            replay_loop = true;
         } else if (strcmp(argv[i], "--led-rows") == 0 && i + 1 < argc) {
             rows = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-cols") == 0 && i + 1 < argc) {
@@ -281,10 +382,27 @@ int main(int argc, char *argv[]) {
             gpio_slowdown = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-pwm-bits") == 0 && i + 1 < argc) {
             pwm_bits = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--led-pwm-dither-bits") == 0 && i + 1 < argc) {
+            pwm_dither_bits = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-pwm-lsb-nanoseconds") == 0 && i + 1 < argc) {
             pwm_lsb_nanoseconds = std::atoi(argv[++i]);
         } else if (strcmp(argv[i], "--led-limit-refresh") == 0 && i + 1 < argc) {
             limit_refresh_rate_hz = std::atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--output-gamma") == 0 && i + 1 < argc) {
+            output_gamma = std::atof(argv[++i]);
+        } else if (strcmp(argv[i], "--output-dither") == 0) {
+            output_dither = true;
+        } else if (strcmp(argv[i], "--scale-filter") == 0 && i + 1 < argc) {
+            const char* filter = argv[++i];
+            if (strcmp(filter, "nearest") == 0) {
+                scale_mode = FrameScaler::Mode::NEAREST;
+            } else if (strcmp(filter, "area") == 0) {
+                scale_mode = FrameScaler::Mode::AREA;
+            } else {
+                std::cerr << "Unknown scale filter: " << filter << std::endl;
+                printUsage(argv[0]);
+                return 1;
+            }
         } else {
             std::cerr << "Unknown option: " << argv[i] << std::endl;
             printUsage(argv[0]);
@@ -292,16 +410,33 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    std::unique_ptr<FrameSource> source;
+    StdinFrameSource* stdin_source = nullptr;
+    if (replay_path) {
+        std::unique_ptr<ReplayFrameSource> replay(new ReplayFrameSource(replay_path, replay_speed, replay_loop));
+        if (!replay->isOpen()) return 1;
+        input_width = replay->getWidth();
+        input_height = replay->getHeight();
+        source = std::move(replay);
+    } else {
+        stdin_source = new StdinFrameSource(input_width, input_height, stdin_mode, input_order);
+        source.reset(stdin_source);
+        stdin_to_stop = stdin_source;
+    }
+
     std::cout << "=" << std::string(60, '=') << std::endl;
     std::cout << "Rpicam to LED Matrix Display" << std::endl;
     std::cout << "=" << std::string(60, '=') << std::endl;
     std::cout << "Input resolution: " << input_width << "x" << input_height << std::endl;
+    std::cout << "Input: " << (replay_path ? "recording" : "stdin")
+              << (replay_path ? "" : (input_order == PixelOrder::BGR ? " (bgr24)" : " (rgb24)")) << std::endl;
     std::cout << "Matrix: " << cols << "x" << rows 
               << ", chain=" << chain_length 
               << ", parallel=" << parallel << std::endl;
     std::cout << "Hardware mapping: " << hardware_mapping << std::endl;
     std::cout << "Display settings: brightness=" << brightness
               << ", pwm-bits=" << pwm_bits
+              << ", pwm-dither=" << pwm_dither_bits
               << ", pwm-lsb-ns=" << pwm_lsb_nanoseconds << std::endl;
     std::cout << "Performance: gpio-slowdown=" << gpio_slowdown;
     if (limit_refresh_rate_hz > 0) {
@@ -310,10 +445,51 @@ int main(int argc, char *argv[]) {
     std::cout << std::endl;
     std::cout << "=" << std::string(60, '=') << std::endl;
 
-    RpicamToMatrix app(rows, cols, chain_length, parallel, hardware_mapping,
-                       brightness, gpio_slowdown, pwm_bits, pwm_lsb_nanoseconds,
-                       limit_refresh_rate_hz);
-    app.run(input_width, input_height);
+    RpicamToMatrix app(input_width, input_height, rows, cols, chain_length, parallel,
+                       hardware_mapping, brightness, gpio_slowdown, pwm_bits, pwm_dither_bits,
+                       pwm_lsb_nanoseconds, limit_refresh_rate_hz);
+    app.setScaleMode(scale_mode);
+    if (output_gamma > 0.0) {
+        app.setOutputCurve(output_gamma, output_dither);
+    }
+    app.setStageTiming(stage_timing, timing_report_seconds);
+    if (!tile_endpoints.empty() && !app.setTileOutput(tile_endpoints, tile_width, tile_height, scale_mode)) {
+        return 1;
+    }
+    if (record_path && !app.setRecording(record_path)) {
+        return 1;
+    }
+
+    AppCore& core = app.getCore();
+    if (process_scale > 0) {
+        core.setProcessingSize(cols * chain_length * process_scale, rows * parallel * process_scale);
+    }
+    core.setBackgroundModel(bg_model);
+    core.setSegmentationRate(segment_every, segment_change);
+    if (state_file) {
+        core.setStateFile(state_file);
+    }
+    core.setTransitionDuration(transition_frames);
+    if (target_fps > 0.0 || target_temp > 0.0f) {
+        app.setQualityGovernor(target_fps, target_temp);
+    }
+    // Same as selecting the effect from the keyboard in camera_to_matrix
+    Effect effect = static_cast<Effect>(effect_num);
+    core.setSystemMode(core.getAppropriateModeForEffect(effect));
+    core.setEffect(effect);
+    if (auto_cycle) {
+        core.toggleAutoCycling();
+    }
+    if (auto_mode) {
+        core.setAutoModeSwitching(true);
+    }
+
+    app.run(*source);
+    stdin_to_stop = nullptr;
+    if (stdin_source && stdin_mode == StdinFrameSource::Mode::LATEST) {
+        std::cerr << "Frames read: " << stdin_source->getFrameCount()
+                  << ", skipped for a newer frame: " << stdin_source->getSkippedFrames() << std::endl;
+    }
 
     std::cout << "Exiting..." << std::endl;
     return 0;